@@ -0,0 +1,50 @@
+#include <arbor/adex_cell.hpp>
+
+#include "adex_cell_group.hpp"
+
+namespace arb {
+
+void adex_model::resize(std::size_t n) {
+    adex_cell c;
+    C_m.assign(n, c.C_m);
+    g_L.assign(n, c.g_L);
+    E_L.assign(n, c.E_L);
+    V_T.assign(n, c.V_T);
+    delta_T.assign(n, c.delta_T);
+    V_peak.assign(n, c.V_peak);
+    V_reset.assign(n, c.V_reset);
+    t_ref.assign(n, c.t_ref);
+    a.assign(n, c.a);
+    b.assign(n, c.b);
+    tau_w.assign(n, c.tau_w);
+    I_e.assign(n, c.I_e);
+    V_init.assign(n, c.V_m);
+    w_init.assign(n, c.w);
+}
+
+void adex_model::set_cell(std::size_t i, const adex_cell& c) {
+    C_m[i] = c.C_m;
+    g_L[i] = c.g_L;
+    E_L[i] = c.E_L;
+    V_T[i] = c.V_T;
+    delta_T[i] = c.delta_T;
+    V_peak[i] = c.V_peak;
+    V_reset[i] = c.V_reset;
+    t_ref[i] = c.t_ref;
+    a[i] = c.a;
+    b[i] = c.b;
+    tau_w[i] = c.tau_w;
+    I_e[i] = c.I_e;
+    V_init[i] = c.V_m;
+    w_init[i] = c.w;
+}
+
+void adex_model::reset() {
+    V_m = V_init;
+    w = w_init;
+    refractory_end.assign(V_m.size(), 0);
+}
+
+template class point_cell_group<adex_model>;
+
+} // namespace arb
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+#include <arbor/adex_cell.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/simd/simd.hpp>
+
+#include "point_cell_group.hpp"
+
+namespace arb {
+
+// Parameters and state of adex cells, integrated with the forward Euler
+// method. A cell in its refractory period is held at the reset potential,
+// and its events are ignored.
+
+struct adex_model {
+    using value_type = double;
+    using cell_type = adex_cell;
+    static constexpr cell_kind kind = cell_kind::adex;
+
+    // Cell parameters, by cell.
+    std::vector<value_type> C_m, g_L, E_L, V_T, delta_T, V_peak, V_reset, t_ref, a, b, tau_w, I_e;
+
+    // Initial and current membrane potential and adaptation current, by cell.
+    std::vector<value_type> V_init, w_init, V_m, w;
+
+    // End of the refractory period, by cell.
+    std::vector<value_type> refractory_end;
+
+    void resize(std::size_t n);
+    void set_cell(std::size_t i, const adex_cell& c);
+    void reset();
+
+    template <int W>
+    void step(std::size_t i, value_type t, value_type h, const value_type* x, bool* crossed) {
+        using simd_value = simd::simd<value_type, W>;
+
+        const simd_value C(C_m.data()+i);
+        const simd_value g(g_L.data()+i);
+        const simd_value E(E_L.data()+i);
+        const simd_value VT(V_T.data()+i);
+        const simd_value dT(delta_T.data()+i);
+        const simd_value Vr(V_reset.data()+i);
+
+        simd_value V(V_m.data()+i);
+        simd_value u(w.data()+i);
+        simd_value end(refractory_end.data()+i);
+
+        auto refractory = simd_value(t)<end;
+
+        auto dV = (g*(E-V+dT*exp((V-VT)/dT)) - u + simd_value(I_e.data()+i))/C;
+        auto du = (simd_value(a.data()+i)*(V-E) - u)/simd_value(tau_w.data()+i);
+        V = V + h*dV + simd_value(x)/C;
+        u = u + h*du;
+        simd::where(refractory, V) = Vr;
+
+        auto m = V>=simd_value(V_peak.data()+i);
+        m.copy_to(crossed);
+        simd::where(m, V) = Vr;
+        simd::where(m, u) = u + simd_value(b.data()+i);
+        simd::where(m, end) = t + h + simd_value(t_ref.data()+i);
+
+        V.copy_to(V_m.data()+i);
+        u.copy_to(w.data()+i);
+        end.copy_to(refractory_end.data()+i);
+    }
+};
+
+extern template class point_cell_group<adex_model>;
+using adex_cell_group = point_cell_group<adex_model>;
+
+} // namespace arb
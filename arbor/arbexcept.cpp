@@ -44,6 +44,16 @@ bad_event_time::bad_event_time(time_type event_time, time_type sim_time):
     sim_time(sim_time)
 {}
 
+trace_file_error::trace_file_error(const std::string& path, const std::string& what_arg):
+    arbor_exception(pprintf("trace file {}: {}", path, what_arg)),
+    path(path)
+{}
+
+spike_file_error::spike_file_error(const std::string& path, const std::string& what_arg):
+    arbor_exception(pprintf("spike file {}: {}", path, what_arg)),
+    path(path)
+{}
+
 no_such_mechanism::no_such_mechanism(const std::string& mech_name):
     arbor_exception(pprintf("no mechanism {} in catalogue", mech_name)),
     mech_name(mech_name)
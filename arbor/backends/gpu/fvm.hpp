@@ -12,7 +12,9 @@
 #include "backends/event.hpp"
 
 #include "backends/gpu/gpu_store_types.hpp"
+#include "backends/gpu/mechanism_pipeline.hpp"
 #include "backends/gpu/shared_state.hpp"
+#include "backends/gpu/step_controller.hpp"
 
 #include "threshold_watcher.hpp"
 
@@ -56,6 +58,8 @@ struct backend {
     using sample_event_stream = arb::gpu::sample_event_stream;
 
     using shared_state = arb::gpu::shared_state;
+    using mechanism_pipeline = arb::gpu::mechanism_pipeline;
+    using step_controller = arb::gpu::step_controller;
 
     static threshold_watcher voltage_watcher(
         const shared_state& state,
@@ -16,6 +16,7 @@
 
 #include "matrix_fine.hpp"
 #include "forest.hpp"
+#include "threading/threading.hpp"
 
 namespace arb {
 namespace gpu {
@@ -141,7 +142,9 @@ public:
                  const std::vector<value_type>& cap,
                  const std::vector<value_type>& face_conductance,
                  const std::vector<value_type>& area,
-                 const std::vector<size_type>& cell_intdom)
+                 const std::vector<size_type>& cell_intdom,
+                 const task_system_handle& = {}, // Host threads are not used.
+                 bool = false) // Factorizations are not reused.
     {
         using util::make_span;
         constexpr unsigned npos = unsigned(-1);
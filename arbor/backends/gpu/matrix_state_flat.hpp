@@ -7,6 +7,7 @@
 #include "util/span.hpp"
 #include "util/partition.hpp"
 #include "util/rangeutil.hpp"
+#include "threading/threading.hpp"
 
 namespace arb {
 namespace gpu {
@@ -71,7 +72,9 @@ struct matrix_state_flat {
                  const std::vector<value_type>& cv_cap,
                  const std::vector<value_type>& face_cond,
                  const std::vector<value_type>& area,
-                 const std::vector<index_type>& cell_to_intdom):
+                 const std::vector<index_type>& cell_to_intdom,
+                 const task_system_handle& = {}, // Host threads are not used.
+                 bool = false): // Factorizations are not reused.
         parent_index(memory::make_const_view(p)),
         cell_cv_divs(memory::make_const_view(cell_cv_divs)),
         cv_to_cell(p.size()),
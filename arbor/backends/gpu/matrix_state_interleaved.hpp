@@ -12,6 +12,7 @@
 
 #include "cuda_common.hpp"
 #include "matrix_common.hpp"
+#include "threading/threading.hpp"
 
 namespace arb {
 namespace gpu {
@@ -149,7 +150,9 @@ struct matrix_state_interleaved {
                  const std::vector<value_type>& cv_cap,
                  const std::vector<value_type>& face_cond,
                  const std::vector<value_type>& area,
-                 const std::vector<index_type>& cell_intdom)
+                 const std::vector<index_type>& cell_intdom,
+                 const task_system_handle& = {}, // Host threads are not used.
+                 bool = false) // Factorizations are not reused.
     {
         arb_assert(cv_cap.size()    == p.size());
         arb_assert(face_cond.size() == p.size());
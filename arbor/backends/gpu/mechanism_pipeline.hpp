@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <arbor/fvm_types.hpp>
+#include <arbor/mechanism.hpp>
+
+namespace arb {
+namespace gpu {
+
+// Runs the kernels of the mechanisms of a cell group in each integration step.
+//
+// Each kernel is launched over all instances of its mechanism: tiling of the
+// CVs, as performed by the multicore back-end, is of no benefit on the GPU,
+// and idle CVs are not skipped.
+
+class mechanism_pipeline {
+public:
+    mechanism_pipeline() = default;
+
+    mechanism_pipeline(const std::vector<mechanism_ptr>& mechanisms, fvm_size_type, std::size_t = 0) {
+        for (auto& m: mechanisms) {
+            mechanisms_.push_back(m.get());
+        }
+    }
+
+    // Deliver events and accumulate mechanism current contributions.
+    void current(const fvm_value_type* = nullptr) {
+        for (auto m: mechanisms_) {
+            m->deliver_events();
+            m->nrn_current();
+        }
+    }
+
+    // Integrate mechanism state.
+    void state(const fvm_value_type* = nullptr) {
+        for (auto m: mechanisms_) {
+            m->nrn_state();
+        }
+    }
+
+    // Write mechanism contributions to ion concentrations.
+    void write_ions() {
+        for (auto m: mechanisms_) {
+            m->write_ions();
+        }
+    }
+
+    std::size_t num_tiles() const {
+        return 0;
+    }
+
+private:
+    std::vector<arb::mechanism*> mechanisms_;
+};
+
+} // namespace gpu
+} // namespace arb
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <arbor/fvm_types.hpp>
+
+#include "backends/multi_event_stream_state.hpp"
+#include "backends/gpu/shared_state.hpp"
+
+namespace arb {
+namespace gpu {
+
+// Chooses the time step of each integration domain.
+//
+// Adaptive time steps, as taken by the multicore back-end, are not
+// supported on the GPU: every integration domain takes steps of dt,
+// clipped to events and the end of the integration period.
+
+class step_controller {
+public:
+    using value_type = fvm_value_type;
+
+    step_controller() = default;
+
+    step_controller(const shared_state&, value_type, value_type) {}
+
+    bool adaptive() const {
+        return false;
+    }
+
+    void reset() {}
+
+    template <typename EvData>
+    void restart(const multi_event_stream_state<EvData>&) {}
+
+    void update_time_to(shared_state& s, value_type dt, value_type tmax) {
+        s.update_time_to(dt, tmax);
+    }
+
+    template <typename Solution>
+    void adapt(const shared_state&, const Solution&, value_type) {}
+};
+
+} // namespace gpu
+} // namespace arb
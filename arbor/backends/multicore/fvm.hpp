@@ -5,9 +5,11 @@
 
 #include "backends/event.hpp"
 #include "backends/multicore/matrix_state.hpp"
+#include "backends/multicore/mechanism_pipeline.hpp"
 #include "backends/multicore/multi_event_stream.hpp"
 #include "backends/multicore/multicore_common.hpp"
 #include "backends/multicore/shared_state.hpp"
+#include "backends/multicore/step_controller.hpp"
 #include "backends/multicore/threshold_watcher.hpp"
 #include "execution_context.hpp"
 #include "util/padded_alloc.hpp"
@@ -43,6 +45,8 @@ struct backend {
     using sample_event_stream = arb::multicore::sample_event_stream;
 
     using shared_state = arb::multicore::shared_state;
+    using mechanism_pipeline = arb::multicore::mechanism_pipeline;
+    using step_controller = arb::multicore::step_controller;
 
     static threshold_watcher voltage_watcher(
         const shared_state& state,
@@ -1,5 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <vector>
+
+#include <arbor/simd/simd.hpp>
+
+#include <threading/threading.hpp>
 #include <util/partition.hpp>
 #include <util/span.hpp>
 
@@ -8,6 +17,81 @@
 namespace arb {
 namespace multicore {
 
+// The tree of the matrix of a cell decomposed into branches, that is,
+// maximal unbranched paths, for a solver that processes the branches of
+// each level of the tree of branches in parallel.
+template <typename I>
+struct branch_schedule {
+    using index_type = I;
+
+    // The CVs of branch b, from head to tail, are
+    // nodes[node_divs[b]] ... nodes[node_divs[b+1]-1].
+    std::vector<index_type> nodes;
+    std::vector<index_type> node_divs;
+
+    // The branches of level l, with the root branch on level 0, are
+    // level_divs[l] ... level_divs[l+1]-1, in decreasing order of head CV.
+    std::vector<index_type> level_divs;
+
+    branch_schedule() = default;
+
+    // Decompose the tree of the CVs in [first, last) with parent index p.
+    template <typename IndexArray>
+    branch_schedule(const IndexArray& p, index_type first, index_type last) {
+        const index_type n = last-first;
+
+        std::vector<index_type> n_child(n, 0), next(n, -1);
+        for (index_type i = first+1; i<last; ++i) {
+            ++n_child[p[i]-first];
+            next[p[i]-first] = i;
+        }
+
+        // A CV heads a branch if it is the root, or if its parent has more
+        // than one child. The CVs are ordered such that p[i]<i.
+        std::vector<index_type> heads, branch_of(n), branch_level;
+        for (index_type i = first; i<last; ++i) {
+            if (i==first || n_child[p[i]-first]!=1) {
+                branch_of[i-first] = heads.size();
+                branch_level.push_back(i==first? 0: branch_level[branch_of[p[i]-first]]+1);
+                heads.push_back(i);
+            }
+            else {
+                branch_of[i-first] = branch_of[p[i]-first];
+            }
+        }
+
+        std::vector<index_type> order(heads.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+            [&](index_type a, index_type b) {
+                return branch_level[a]<branch_level[b] ||
+                      (branch_level[a]==branch_level[b] && heads[a]>heads[b]);
+            });
+
+        node_divs.push_back(0);
+        for (auto b: order) {
+            for (index_type i = heads[b]; ; i = next[i-first]) {
+                nodes.push_back(i);
+                if (n_child[i-first]!=1) break;
+            }
+            node_divs.push_back(nodes.size());
+
+            while ((index_type)level_divs.size()<=branch_level[b]) {
+                level_divs.push_back(node_divs.size()-2);
+            }
+        }
+        level_divs.push_back(order.size());
+    }
+
+    index_type num_branches() const {
+        return node_divs.size()-1;
+    }
+
+    index_type num_levels() const {
+        return level_divs.size()-1;
+    }
+};
+
 template <typename T, typename I>
 struct matrix_state {
 public:
@@ -34,6 +118,30 @@ public:
     // the invariant part of the matrix diagonal
     array invariant_d;         // [μS]
 
+    // Thread pool for parallel assembly and solution; serial if null.
+    task_system_handle threads;
+
+    // Groups with fewer CVs than this are assembled and solved serially.
+    static constexpr index_type min_parallel_cvs = 4096;
+
+    // Cells with at least this many CVs are solved by branch, and assembled
+    // in blocks of CVs, in parallel.
+    static constexpr index_type min_parallel_cell_cvs = 1024;
+    static constexpr index_type assemble_block_cvs = 512;
+
+    // Cells with the same tree of CVs are solved in blocks of simd_width
+    // cells, with the rows of the cells of a block interleaved by lane.
+    static constexpr int simd_width = std::max(4, simd::simd_abi::native_width<value_type>::value);
+
+    // If set, the factorization of the matrix of a cell is kept, and reused
+    // while the assembled diagonal of the cell differs from the factored
+    // one by no more than factorization_tolerance relative to it: only the
+    // right hand side is then eliminated and substituted. The tolerance
+    // absorbs the rounding of dt = t_to-t; a fresh factorization gives
+    // results identical to those without reuse.
+    bool reuse_factorization = false;
+    static constexpr value_type factorization_tolerance = 1e-8;
+
     matrix_state() = default;
 
     matrix_state(const std::vector<index_type>& p,
@@ -41,14 +149,17 @@ public:
                  const std::vector<value_type>& cap,
                  const std::vector<value_type>& cond,
                  const std::vector<value_type>& area,
-                 const std::vector<index_type>& cell_to_intdom):
+                 const std::vector<index_type>& cell_to_intdom,
+                 const task_system_handle& threads = {},
+                 bool reuse_factorization = false):
         parent_index(p.begin(), p.end()),
         cell_cv_divs(cell_cv_divs.begin(), cell_cv_divs.end()),
         d(size(), 0), u(size(), 0), rhs(size()),
         cv_capacitance(cap.begin(), cap.end()),
         face_conductance(cond.begin(), cond.end()),
         cv_area(area.begin(), area.end()),
-        cell_to_intdom(cell_to_intdom.begin(), cell_to_intdom.end())
+        cell_to_intdom(cell_to_intdom.begin(), cell_to_intdom.end()),
+        reuse_factorization(reuse_factorization)
     {
         arb_assert(cap.size() == size());
         arb_assert(cond.size() == size());
@@ -63,6 +174,36 @@ public:
             invariant_d[i] += gij;
             invariant_d[p[i]] += gij;
         }
+
+        auto ncells = cell_cv_divs.size()-1;
+        cell_schedule.assign(ncells, -1);
+
+        if (threads && threads->get_num_threads()>1 && (index_type)n>=min_parallel_cvs) {
+            this->threads = threads;
+
+            for (auto m: util::make_span(ncells)) {
+                auto first = cell_cv_divs[m];
+                auto last = cell_cv_divs[m+1];
+                if (last-first>=min_parallel_cell_cvs) {
+                    cell_schedule[m] = schedules.size();
+                    schedules.emplace_back(parent_index, first, last);
+
+                    auto nb = schedules.back().num_branches();
+                    d_contrib.emplace_back(nb);
+                    rhs_contrib.emplace_back(nb);
+                }
+            }
+        }
+
+        make_lane_blocks();
+
+        if (reuse_factorization) {
+            factor_key = array(n, 0);
+            factor_d = array(n, 0);
+            factor_l = array(n, 0);
+            factor_valid.assign(ncells, 0);
+            block_l = array(block_d.size(), 0);
+        }
     }
 
     const_view solution() const {
@@ -82,13 +223,13 @@ public:
         auto cell_cv_part = util::partition_view(cell_cv_divs);
         const index_type ncells = cell_cv_part.size();
 
-        // loop over submatrices
-        for (auto m: util::make_span(0, ncells)) {
+        // Assemble the rows of cell m in [first, last).
+        auto assemble_cvs = [&](index_type m, index_type first, index_type last) {
             auto dt = dt_intdom[cell_to_intdom[m]];
 
             if (dt>0) {
                 value_type oodt_factor = 1e-3/dt; // [1/µs]
-                for (auto i: util::make_span(cell_cv_part[m])) {
+                for (auto i: util::make_span(first, last)) {
                     auto area_factor = 1e-3*cv_area[i]; // [1e-9·m²]
 
                     auto gi = oodt_factor*cv_capacitance[i] + area_factor*conductivity[i]; // [μS]
@@ -99,43 +240,471 @@ public:
                 }
             }
             else {
-                for (auto i: util::make_span(cell_cv_part[m])) {
+                for (auto i: util::make_span(first, last)) {
                     d[i] = 0;
                     rhs[i] = voltage[i];
                 }
             }
+        };
+
+        if (!threads) {
+            // loop over submatrices
+            for (auto m: util::make_span(0, ncells)) {
+                assemble_cvs(m, cell_cv_part[m].first, cell_cv_part[m].second);
+            }
+            return;
         }
+
+        using threading::parallel_for;
+        using threading::partitioner;
+        using threading::partition_kind;
+
+        parallel_for::apply(0, ncells, threads.get(), partitioner(partition_kind::guided, 1),
+            [&](index_type m) {
+                auto first = cell_cv_part[m].first;
+                auto last = cell_cv_part[m].second;
+
+                if (last-first<min_parallel_cell_cvs) {
+                    assemble_cvs(m, first, last);
+                    return;
+                }
+                const index_type nblocks = (last-first-1)/assemble_block_cvs+1;
+                parallel_for::apply(0, nblocks, threads.get(), partitioner(partition_kind::static_blocks, 1),
+                    [&](index_type k) {
+                        auto b = first+k*assemble_block_cvs;
+                        assemble_cvs(m, b, std::min(last, b+assemble_block_cvs));
+                    });
+            });
     }
 
     void solve() {
-        // loop over submatrices
-        for (auto cv_span: util::partition_view(cell_cv_divs)) {
-            auto first = cv_span.first;
-            auto last = cv_span.second; // one past the end
-
-            if (d[first]!=0) {
-                // backward sweep
-                for(auto i=last-1; i>first; --i) {
-                    auto factor = u[i] / d[i];
-                    d[parent_index[i]]   -= factor * u[i];
-                    rhs[parent_index[i]] -= factor * rhs[i];
-                }
-                rhs[first] /= d[first];
+        // Solve the lane blocks, then the remaining cells.
+        const index_type nblocks = blocks.size();
+        const index_type nitems = nblocks+solo_cells.size();
 
-                // forward sweep
-                for(auto i=first+1; i<last; ++i) {
-                    rhs[i] -= u[i] * rhs[parent_index[i]];
-                    rhs[i] /= d[i];
-                }
+        auto solve_item = [&](index_type k) {
+            if (k<nblocks) {
+                solve_lane_block(k);
+                return;
             }
+            auto m = solo_cells[k-nblocks];
+            if (cell_schedule[m]<0) {
+                solve_cell(m);
+            }
+            else {
+                solve_branches(m);
+            }
+        };
+
+        if (!threads) {
+            for (auto k: util::make_span(nitems)) {
+                solve_item(k);
+            }
+            return;
         }
+
+        using threading::parallel_for;
+        using threading::partitioner;
+        using threading::partition_kind;
+
+        parallel_for::apply(0, nitems, threads.get(), partitioner(partition_kind::guided, 1), solve_item);
     }
 
 private:
+    // Schedules of the cells solved by branch: cell m uses
+    // schedules[cell_schedule[m]], or is solved serially if negative.
+    std::vector<index_type> cell_schedule;
+    std::vector<branch_schedule<index_type>> schedules;
+
+    // Per-branch contributions to the diagonal and right hand side
+    // of the parent CV, while the branches of a level are eliminated.
+    std::vector<std::vector<value_type>> d_contrib;
+    std::vector<std::vector<value_type>> rhs_contrib;
+
+    // Blocks of simd_width cells with the same tree of n CVs: row i of
+    // the cell in lane k of a block is stored at offset+i*simd_width+k in
+    // the interleaved buffers, and the cell-local parent index of the
+    // tree is block_parents[parent] ... block_parents[parent+n-1].
+    struct lane_block {
+        index_type n;
+        index_type parent;
+        index_type offset;
+    };
+    std::vector<lane_block> blocks;
+
+    // The cell in lane k of block b is block_cells[b*simd_width+k], or
+    // negative for unused lanes.
+    std::vector<index_type> block_cells;
+    std::vector<index_type> block_parents;
+
+    // Interleaved copies of the matrix and right hand side.
+    array block_d, block_u, block_rhs;
+
+    // Cells that are not in a lane block, in order.
+    std::vector<index_type> solo_cells;
+
+    // With reuse_factorization: the assembled diagonal at the last
+    // factorization of each cell, if factor_valid for the cell, and the
+    // factored diagonal and multipliers u[i]/d[i] of the elimination of
+    // cells not in lane blocks. The factored diagonal of a lane block is
+    // kept in block_d, and its multipliers, interleaved, in block_l.
+    array factor_key, factor_d, factor_l, block_l;
+    std::vector<char> factor_valid;
 
     std::size_t size() const {
         return parent_index.size();
     }
+
+    // Is the factorization of cell m current for the assembled diagonal?
+    bool factorization_current(index_type m) const {
+        if (!factor_valid[m]) return false;
+
+        for (auto i: util::make_span(cell_cv_divs[m], cell_cv_divs[m+1])) {
+            if (std::abs(d[i]-factor_key[i])>factorization_tolerance*std::abs(factor_key[i])) return false;
+        }
+        return true;
+    }
+
+    // Record the assembled diagonal of cell m as the key of the
+    // factorization to follow; cells with zero diagonal are not solved.
+    void record_factorization(index_type m) {
+        auto first = cell_cv_divs[m];
+        auto last = cell_cv_divs[m+1];
+
+        factor_valid[m] = d[first]!=0;
+        std::copy(d.begin()+first, d.begin()+last, factor_key.begin()+first);
+    }
+
+    // Partition the cells that are not solved by branch into lane blocks of
+    // cells with the same tree, if there are at least two such cells.
+    void make_lane_blocks() {
+        const index_type ncells = cell_cv_divs.size()-1;
+
+        std::map<std::vector<index_type>, std::vector<index_type>> cells_by_tree;
+        for (auto m: util::make_span(ncells)) {
+            if (cell_schedule[m]>=0) {
+                solo_cells.push_back(m);
+                continue;
+            }
+            auto first = cell_cv_divs[m];
+            auto last = cell_cv_divs[m+1];
+
+            std::vector<index_type> tree;
+            for (auto i: util::make_span(first, last)) {
+                tree.push_back(i==first? 0: parent_index[i]-first);
+            }
+            cells_by_tree[std::move(tree)].push_back(m);
+        }
+
+        index_type size = 0;
+        for (auto& entry: cells_by_tree) {
+            auto& tree = entry.first;
+            auto& cells = entry.second;
+            if (cells.size()<2) {
+                solo_cells.insert(solo_cells.end(), cells.begin(), cells.end());
+                continue;
+            }
+
+            const index_type n = tree.size();
+            const index_type parent = block_parents.size();
+            block_parents.insert(block_parents.end(), tree.begin(), tree.end());
+
+            for (std::size_t b = 0; b<cells.size(); b += simd_width) {
+                blocks.push_back({n, parent, size});
+                for (std::size_t k = b; k<b+simd_width; ++k) {
+                    block_cells.push_back(k<cells.size()? cells[k]: -1);
+                }
+                size += n*simd_width;
+            }
+        }
+        std::sort(solo_cells.begin(), solo_cells.end());
+
+        block_d = array(size);
+        block_u = array(size);
+        block_rhs = array(size);
+    }
+
+    // Solve the matrices of the cells of lane block b together.
+    //
+    // Unused lanes, and lanes of cells with zero diagonal (see solve_cell),
+    // are solved but not copied back.
+    void solve_lane_block(index_type b) {
+        using simd_value = simd::simd<value_type, simd_width>;
+        constexpr index_type W = simd_width;
+
+        const auto& block = blocks[b];
+        const index_type n = block.n;
+        const index_type* p = block_parents.data()+block.parent;
+        const index_type* cells = block_cells.data()+b*W;
+
+        value_type* D = block_d.data()+block.offset;
+        value_type* U = block_u.data()+block.offset;
+        value_type* R = block_rhs.data()+block.offset;
+        value_type* L = reuse_factorization? block_l.data()+block.offset: nullptr;
+
+        bool refactor = !reuse_factorization;
+        for (index_type k = 0; k<W && !refactor; ++k) {
+            refactor = cells[k]>=0 && !factorization_current(cells[k]);
+        }
+
+        if (!refactor) {
+            solve_lane_block_factored(b);
+            return;
+        }
+
+        // interleave
+        for (index_type k = 0; k<W; ++k) {
+            if (cells[k]<0) {
+                for (index_type i = 0; i<n; ++i) {
+                    D[i*W+k] = 1;
+                    U[i*W+k] = 0;
+                    R[i*W+k] = 0;
+                }
+            }
+            else {
+                auto first = cell_cv_divs[cells[k]];
+                for (index_type i = 0; i<n; ++i) {
+                    D[i*W+k] = d[first+i];
+                    U[i*W+k] = u[first+i];
+                    R[i*W+k] = rhs[first+i];
+                }
+                if (L) record_factorization(cells[k]);
+            }
+        }
+
+        // backward sweep
+        for (index_type i = n-1; i>0; --i) {
+            simd_value ui(U+i*W), di(D+i*W), ri(R+i*W);
+            simd_value dp(D+p[i]*W), rp(R+p[i]*W);
+
+            auto factor = ui / di;
+            dp = dp - factor * ui;
+            rp = rp - factor * ri;
+            dp.copy_to(D+p[i]*W);
+            rp.copy_to(R+p[i]*W);
+            if (L) factor.copy_to(L+i*W);
+        }
+        substitute_lane_block(b);
+    }
+
+    // Solve the matrices of the cells of lane block b with the current
+    // factorization of the block.
+    void solve_lane_block_factored(index_type b) {
+        using simd_value = simd::simd<value_type, simd_width>;
+        constexpr index_type W = simd_width;
+
+        const auto& block = blocks[b];
+        const index_type n = block.n;
+        const index_type* p = block_parents.data()+block.parent;
+        const index_type* cells = block_cells.data()+b*W;
+
+        const value_type* L = block_l.data()+block.offset;
+        value_type* R = block_rhs.data()+block.offset;
+
+        // interleave
+        for (index_type k = 0; k<W; ++k) {
+            if (cells[k]<0) {
+                for (index_type i = 0; i<n; ++i) {
+                    R[i*W+k] = 0;
+                }
+            }
+            else {
+                auto first = cell_cv_divs[cells[k]];
+                for (index_type i = 0; i<n; ++i) {
+                    R[i*W+k] = rhs[first+i];
+                }
+            }
+        }
+
+        // backward sweep
+        for (index_type i = n-1; i>0; --i) {
+            simd_value li(L+i*W), ri(R+i*W);
+            simd_value rp(R+p[i]*W);
+
+            rp = rp - li * ri;
+            rp.copy_to(R+p[i]*W);
+        }
+        substitute_lane_block(b);
+    }
+
+    // Complete the solution of lane block b after the backward sweep.
+    void substitute_lane_block(index_type b) {
+        using simd_value = simd::simd<value_type, simd_width>;
+        constexpr index_type W = simd_width;
+
+        const auto& block = blocks[b];
+        const index_type n = block.n;
+        const index_type* p = block_parents.data()+block.parent;
+        const index_type* cells = block_cells.data()+b*W;
+
+        const value_type* D = block_d.data()+block.offset;
+        const value_type* U = block_u.data()+block.offset;
+        value_type* R = block_rhs.data()+block.offset;
+
+        {
+            simd_value d0(D), r0(R);
+            r0 = r0 / d0;
+            r0.copy_to(R);
+        }
+
+        // forward sweep
+        for (index_type i = 1; i<n; ++i) {
+            simd_value ui(U+i*W), di(D+i*W), ri(R+i*W);
+            simd_value rp(R+p[i]*W);
+
+            ri = ri - ui * rp;
+            ri = ri / di;
+            ri.copy_to(R+i*W);
+        }
+
+        // de-interleave
+        for (index_type k = 0; k<W; ++k) {
+            if (cells[k]<0) continue;
+
+            auto first = cell_cv_divs[cells[k]];
+            if (d[first]==0) continue;
+
+            for (index_type i = 0; i<n; ++i) {
+                rhs[first+i] = R[i*W+k];
+            }
+        }
+    }
+
+    // Choose the diagonal to factor in the solution of cell m: d, or the
+    // copy factor_d with reuse_factorization. Returns false if the current
+    // factorization is reused instead.
+    bool begin_factorization(index_type m, value_type*& D) {
+        D = d.data();
+        if (!reuse_factorization) return true;
+
+        D = factor_d.data();
+        if (factorization_current(m)) return false;
+
+        auto first = cell_cv_divs[m];
+        auto last = cell_cv_divs[m+1];
+        record_factorization(m);
+        std::copy(d.begin()+first, d.begin()+last, factor_d.begin()+first);
+        return true;
+    }
+
+    // Solve the matrix of cell m.
+    void solve_cell(index_type m) {
+        auto first = cell_cv_divs[m];
+        auto last = cell_cv_divs[m+1];
+
+        if (d[first]==0) {
+            if (reuse_factorization) factor_valid[m] = 0;
+            return;
+        }
+
+        value_type* D;
+        if (begin_factorization(m, D)) {
+            // backward sweep
+            for(auto i=last-1; i>first; --i) {
+                auto factor = u[i] / D[i];
+                D[parent_index[i]]   -= factor * u[i];
+                rhs[parent_index[i]] -= factor * rhs[i];
+                if (reuse_factorization) factor_l[i] = factor;
+            }
+        }
+        else {
+            for(auto i=last-1; i>first; --i) {
+                rhs[parent_index[i]] -= factor_l[i] * rhs[i];
+            }
+        }
+        rhs[first] /= D[first];
+
+        // forward sweep
+        for(auto i=first+1; i<last; ++i) {
+            rhs[i] -= u[i] * rhs[parent_index[i]];
+            rhs[i] /= D[i];
+        }
+    }
+
+    // Solve the matrix of a cell, eliminating the branches of each level in
+    // parallel in the backward sweep, and substituting the branches of each
+    // level in parallel in the forward sweep.
+    //
+    // The contributions of the branches of a level to their parent CVs are
+    // applied in decreasing order of head CV, which is the order of the
+    // serial solver: the results are identical.
+    void solve_branches(index_type m) {
+        const index_type si = cell_schedule[m];
+        const auto& s = schedules[si];
+        const auto& nodes = s.nodes;
+        const auto& node_divs = s.node_divs;
+        const auto& level_divs = s.level_divs;
+        const index_type root = nodes[0];
+
+        if (d[root]==0) {
+            if (reuse_factorization) factor_valid[m] = 0;
+            return;
+        }
+
+        value_type* D;
+        const bool refactor = begin_factorization(m, D);
+
+        using threading::parallel_for;
+        using threading::partitioner;
+        using threading::partition_kind;
+
+        auto& dd = d_contrib[si];
+        auto& drhs = rhs_contrib[si];
+
+        // The multiplier of the elimination of CV i.
+        auto multiplier = [&](index_type i) {
+            if (!refactor) return factor_l[i];
+
+            auto factor = u[i] / D[i];
+            if (reuse_factorization) factor_l[i] = factor;
+            return factor;
+        };
+
+        // Eliminate the CVs of branch b after its head.
+        auto eliminate = [&](index_type b) {
+            for (auto k = node_divs[b+1]-1; k>node_divs[b]; --k) {
+                auto i = nodes[k];
+                auto factor = multiplier(i);
+                if (refactor) D[parent_index[i]] -= factor * u[i];
+                rhs[parent_index[i]] -= factor * rhs[i];
+            }
+        };
+
+        // Substitute the CVs of branch b from index k in the branch.
+        auto substitute = [&](index_type b, index_type k) {
+            for (k += node_divs[b]; k<node_divs[b+1]; ++k) {
+                auto i = nodes[k];
+                rhs[i] -= u[i] * rhs[parent_index[i]];
+                rhs[i] /= D[i];
+            }
+        };
+
+        // backward sweep
+        for (auto l = s.num_levels()-1; l>0; --l) {
+            parallel_for::apply(level_divs[l], level_divs[l+1], threads.get(), partitioner(partition_kind::dynamic, 1),
+                [&](index_type b) {
+                    eliminate(b);
+                    auto h = nodes[node_divs[b]];
+                    auto factor = multiplier(h);
+                    dd[b] = factor * u[h];
+                    drhs[b] = factor * rhs[h];
+                });
+            for (auto b = level_divs[l]; b<level_divs[l+1]; ++b) {
+                auto p = parent_index[nodes[node_divs[b]]];
+                if (refactor) D[p] -= dd[b];
+                rhs[p] -= drhs[b];
+            }
+        }
+        eliminate(0);
+        rhs[root] /= D[root];
+
+        // forward sweep
+        substitute(0, 1);
+        for (auto l = 1; l<s.num_levels(); ++l) {
+            parallel_for::apply(level_divs[l], level_divs[l+1], threads.get(), partitioner(partition_kind::dynamic, 1),
+                [&](index_type b) { substitute(b, 0); });
+        }
+    }
 };
 
 } // namespace multicore
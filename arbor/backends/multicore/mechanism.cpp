@@ -81,6 +81,7 @@ void mechanism::instantiate(unsigned id, backend::shared_state& shared, const me
     util::padded_allocator<> pad(shared.alignment);
     mechanism_id_ = id;
     width_ = pos_data.cv.size();
+    reset_instance_range();
 
     // Assign non-owning views onto shared state:
 
@@ -65,8 +65,36 @@ public:
 
     void set_parameter(const std::string& key, const std::vector<fvm_value_type>& values) override;
 
+    // Mechanisms that support instance ranges restrict the loops of their
+    // kernels to the instances in [instance_begin_, instance_end_), so that
+    // the kernels of several mechanisms can be run tile by tile over the CVs.
+    virtual bool supports_instance_range() const { return false; }
+
+    void set_instance_range(size_type begin, size_type end) {
+        instance_begin_ = begin;
+        instance_end_ = end;
+    }
+
+    void reset_instance_range() {
+        set_instance_range(0, width_);
+    }
+
+    // True if the instances are ordered by CV.
+    bool cv_ordered() const {
+        return std::is_sorted(node_index_.begin(), node_index_.begin()+width_);
+    }
+
+    // The instances on the CVs in [cv_begin, cv_end), if ordered by CV.
+    std::pair<size_type, size_type> instance_range(index_type cv_begin, index_type cv_end) const {
+        auto first = node_index_.begin();
+        auto last = first+width_;
+        return {std::lower_bound(first, last, cv_begin)-first, std::lower_bound(first, last, cv_end)-first};
+    }
+
 protected:
     size_type width_ = 0;        // Instance width (number of CVs/sites)
+    size_type instance_begin_ = 0;
+    size_type instance_end_ = 0;
     size_type width_padded_ = 0; // Width rounded up to multiple of pad/alignment.
     size_type n_ion_ = 0;
 
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <arbor/fvm_types.hpp>
+#include <arbor/mechanism.hpp>
+
+#include "backends/multicore/mechanism.hpp"
+#include "backends/multicore/mechanism_pipeline.hpp"
+
+namespace arb {
+namespace multicore {
+
+mechanism_pipeline::mechanism_pipeline(
+    const std::vector<mechanism_ptr>& mechanisms,
+    fvm_size_type n_cv,
+    std::size_t tile_bytes)
+{
+    std::vector<multicore::mechanism*> tiled;
+
+    // Per-CV shared state used by the kernels: voltage, current, conductivity,
+    // time step and CV to integration domain index.
+    std::size_t state_bytes = n_cv*(4*sizeof(fvm_value_type)+sizeof(fvm_index_type));
+
+    for (auto& m: mechanisms) {
+        mechanisms_.push_back(m.get());
+
+        auto mm = dynamic_cast<multicore::mechanism*>(m.get());
+        if (mm && mm->supports_instance_range() && mm->cv_ordered()) {
+            tiled.push_back(mm);
+            state_bytes += mm->memory();
+        }
+    }
+
+    if (n_cv==0 || tiled.size()!=mechanisms_.size()) return;
+
+    const std::size_t tile_cvs = std::max<std::size_t>(1, (double)tile_bytes/state_bytes*n_cv);
+    const std::size_t num_tiles = (n_cv+tile_cvs-1)/tile_cvs;
+    if (num_tiles<2) return;
+
+    tiled_ = std::move(tiled);
+    num_tiles_ = num_tiles;
+    ranges_.reserve(num_tiles_*tiled_.size());
+    tile_divs_.push_back(0);
+    for (std::size_t t = 0; t<num_tiles_; ++t) {
+        fvm_index_type cv_begin = t*tile_cvs;
+        fvm_index_type cv_end = std::min<std::size_t>(n_cv, (t+1)*tile_cvs);
+        for (auto m: tiled_) {
+            ranges_.push_back(m->instance_range(cv_begin, cv_end));
+        }
+        tile_divs_.push_back(cv_end);
+    }
+}
+
+template <typename F>
+void mechanism_pipeline::foreach_tile(F&& kernel, const fvm_value_type* dt_cv) {
+    const auto n = tiled_.size();
+    auto r = ranges_.begin();
+    for (std::size_t t = 0; t<num_tiles_; ++t) {
+        if (dt_cv && std::all_of(dt_cv+tile_divs_[t], dt_cv+tile_divs_[t+1], [](fvm_value_type dt) { return dt==0; })) {
+            r += n;
+            continue;
+        }
+        for (std::size_t i = 0; i<n; ++i, ++r) {
+            if (r->first==r->second) continue;
+            tiled_[i]->set_instance_range(r->first, r->second);
+            kernel(tiled_[i]);
+        }
+    }
+    for (auto m: tiled_) {
+        m->reset_instance_range();
+    }
+}
+
+void mechanism_pipeline::current(const fvm_value_type* dt_cv) {
+    if (!num_tiles_) {
+        for (auto m: mechanisms_) {
+            m->deliver_events();
+            m->nrn_current();
+        }
+        return;
+    }
+
+    // Event delivery updates only the state of the mechanism itself, and
+    // is not tiled.
+    for (auto m: mechanisms_) {
+        m->deliver_events();
+    }
+    foreach_tile([](multicore::mechanism* m) { m->nrn_current(); }, dt_cv);
+}
+
+void mechanism_pipeline::state(const fvm_value_type* dt_cv) {
+    if (!num_tiles_) {
+        for (auto m: mechanisms_) {
+            m->nrn_state();
+        }
+        return;
+    }
+    foreach_tile([](multicore::mechanism* m) { m->nrn_state(); }, dt_cv);
+}
+
+void mechanism_pipeline::write_ions() {
+    if (!num_tiles_) {
+        for (auto m: mechanisms_) {
+            m->write_ions();
+        }
+        return;
+    }
+    foreach_tile([](multicore::mechanism* m) { m->write_ions(); });
+}
+
+} // namespace multicore
+} // namespace arb
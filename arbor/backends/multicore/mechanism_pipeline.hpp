@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <arbor/fvm_types.hpp>
+#include <arbor/mechanism.hpp>
+
+namespace arb {
+namespace multicore {
+
+class mechanism;
+
+// Runs the kernels of the mechanisms of a cell group in each integration step.
+//
+// Without tiling, each kernel streams through the state of all of its
+// instances in turn. With tiling, the CVs are split into contiguous tiles
+// with state that fits in cache, and the kernels of all mechanisms are run
+// on one tile before moving on to the next. The kernels are applied to each
+// CV in the same order either way, so the results are identical.
+//
+// Tiling requires that every mechanism supports instance ranges, with
+// instances ordered by CV; otherwise the kernels are run untiled.
+//
+// The current and state kernels can be given the time step of each CV, and
+// then skip the tiles in which every CV has a zero time step, that is, every
+// integration domain has reached the end of the integration period.
+
+class mechanism_pipeline {
+public:
+    // Default size in bytes of the CV and mechanism state of a tile.
+    static constexpr std::size_t default_tile_bytes = 256*1024;
+
+    mechanism_pipeline() = default;
+
+    mechanism_pipeline(
+        const std::vector<mechanism_ptr>& mechanisms,
+        fvm_size_type n_cv,
+        std::size_t tile_bytes = default_tile_bytes);
+
+    // Deliver events and accumulate mechanism current contributions,
+    // skipping tiles idle in the step with time step dt_cv if given.
+    void current(const fvm_value_type* dt_cv = nullptr);
+
+    // Integrate mechanism state, skipping tiles idle with time step dt_cv
+    // if given.
+    void state(const fvm_value_type* dt_cv = nullptr);
+
+    // Write mechanism contributions to ion concentrations.
+    void write_ions();
+
+    // Number of tiles; zero if the kernels are run untiled.
+    std::size_t num_tiles() const {
+        return num_tiles_;
+    }
+
+private:
+    std::vector<arb::mechanism*> mechanisms_;
+
+    // With tiling: the mechanisms, and the instance range of each mechanism
+    // on each tile, with ranges_[t*mechanisms_.size()+i] for mechanism i on tile t.
+    std::vector<multicore::mechanism*> tiled_;
+    std::vector<std::pair<fvm_size_type, fvm_size_type>> ranges_;
+    std::size_t num_tiles_ = 0;
+
+    // The CVs of tile t are tile_divs_[t] ... tile_divs_[t+1]-1.
+    std::vector<fvm_index_type> tile_divs_;
+
+    template <typename F>
+    void foreach_tile(F&& kernel, const fvm_value_type* dt_cv = nullptr);
+};
+
+} // namespace multicore
+} // namespace arb
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+
+#include <arbor/fvm_types.hpp>
+
+#include "backends/multicore/multicore_common.hpp"
+#include "backends/multicore/shared_state.hpp"
+#include "backends/multicore/step_controller.hpp"
+#include "util/rangeutil.hpp"
+
+namespace arb {
+namespace multicore {
+
+step_controller::step_controller(const shared_state& s, value_type tolerance, value_type max_factor):
+    tolerance_(tolerance),
+    max_factor_(std::max<value_type>(1, max_factor))
+{
+    if (adaptive()) {
+        step_ = array(s.n_intdom, 0);
+        error_ = array(s.n_intdom, 0);
+        rate_ = array(s.n_cv, 0);
+    }
+}
+
+void step_controller::reset() {
+    util::fill(step_, 0);
+}
+
+void step_controller::update_time_to(shared_state& s, value_type dt, value_type tmax) {
+    if (!adaptive()) {
+        s.update_time_to(dt, tmax);
+        return;
+    }
+
+    for (fvm_size_type i = 0; i<s.n_intdom; ++i) {
+        auto t = s.time[i]+(step_[i]>0? step_[i]: dt);
+        s.time_to[i] = std::min(t, tmax);
+    }
+}
+
+void step_controller::adapt(const shared_state& s, const array& v, value_type dt) {
+    if (!adaptive()) return;
+
+    // Steps cut to less than half their length by the end of the integration
+    // period give unreliable rates, and are ignored.
+    auto ignored = [&](fvm_index_type k) {
+        auto h = s.dt_intdom[k];
+        return h<=0 || 2*h<(step_[k]>0? step_[k]: dt);
+    };
+
+    // The error of a step of length h with rate r, after a step with
+    // rate r', is estimated as h·|r-r'|/2: an intdom without a previous
+    // step has no estimate, and takes a step of dt.
+    util::fill(error_, 0);
+    for (fvm_size_type i = 0; i<s.n_cv; ++i) {
+        auto k = s.cv_to_intdom[i];
+        if (ignored(k)) continue;
+
+        auto h = s.dt_intdom[k];
+        auto r = (v[i]-s.voltage[i])/h;
+        if (step_[k]>0) {
+            error_[k] = std::max(error_[k], h*std::abs(r-rate_[i])/2);
+        }
+        rate_[i] = r;
+    }
+
+    const value_type max_step = max_factor_*dt;
+    for (fvm_size_type k = 0; k<s.n_intdom; ++k) {
+        if (ignored(k)) continue;
+
+        auto h = s.dt_intdom[k];
+        if (step_[k]==0) {
+            step_[k] = dt;
+            continue;
+        }
+
+        // The local error of the backward Euler method is of second order
+        // in the step.
+        auto next = 2*step_[k];
+        if (error_[k]>0) {
+            next = std::min(next, h*std::sqrt(tolerance_/error_[k]));
+        }
+        step_[k] = std::min(std::max(next, dt), max_step);
+    }
+}
+
+} // namespace multicore
+} // namespace arb
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <arbor/fvm_types.hpp>
+
+#include "backends/multi_event_stream_state.hpp"
+#include "backends/multicore/multicore_common.hpp"
+#include "backends/multicore/shared_state.hpp"
+
+namespace arb {
+namespace multicore {
+
+// Chooses the time step of each integration domain.
+//
+// With fixed steps, every integration domain takes steps of dt, clipped to
+// events and the end of the integration period.
+//
+// With adaptive steps, each integration domain takes steps of between dt
+// and max_factor*dt. The local error of a step is estimated from the change
+// in the rate of change of the membrane voltage between consecutive steps,
+// and the next step is chosen to bring the largest error over the CVs of
+// the integration domain to the tolerance, growing by at most a factor of
+// two per step. Steps are not rejected: an error above the tolerance only
+// shortens the following step. Quiescent cells thus take long steps, while
+// cells near a spike take steps of dt. Delivery of an event to an
+// integration domain restarts it with a step of dt.
+
+class step_controller {
+public:
+    using value_type = fvm_value_type;
+
+    step_controller() = default;
+
+    // Adaptive steps if tolerance [mV] is positive, else fixed steps.
+    step_controller(const shared_state& s, value_type tolerance, value_type max_factor);
+
+    bool adaptive() const {
+        return tolerance_>0;
+    }
+
+    // Forget the step history.
+    void reset();
+
+    // Restart the integration domains with events in the marked state.
+    template <typename EvData>
+    void restart(const multi_event_stream_state<EvData>& marked) {
+        if (!adaptive()) return;
+
+        for (fvm_size_type i = 0; i<marked.n_streams(); ++i) {
+            if (marked.begin_offset[i]!=marked.end_offset[i]) {
+                step_[i] = 0;
+            }
+        }
+    }
+
+    // Set time_to to the earliest of time plus the step and tmax.
+    void update_time_to(shared_state& s, value_type dt, value_type tmax);
+
+    // Choose the next steps given the solution v for the step from time
+    // to time_to, before it is copied to the voltage.
+    void adapt(const shared_state& s, const array& v, value_type dt);
+
+    // The next step of each integration domain, or zero for dt.
+    const array& steps() const {
+        return step_;
+    }
+
+private:
+    value_type tolerance_ = 0;  // [mV]
+    value_type max_factor_ = 1;
+
+    array step_;    // Maps intdom index to next step [ms].
+    array error_;   // Maps intdom index to error estimate [mV].
+    array rate_;    // Maps CV index to dv/dt over the last step [mV/ms].
+};
+
+} // namespace multicore
+} // namespace arb
@@ -19,10 +19,11 @@ public:
     mechanism_ptr clone() const override { return mechanism_ptr(new stimulus()); }
 
     void nrn_init() override {}
+    bool supports_instance_range() const override { return true; }
+
     void nrn_state() override {}
     void nrn_current() override {
-        size_type n = size();
-        for (size_type i=0; i<n; ++i) {
+        for (size_type i=instance_begin_; i<instance_end_; ++i) {
             auto cv = node_index_[i];
             auto t = vec_t_[vec_ci_[cv]];
 
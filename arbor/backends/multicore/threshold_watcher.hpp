@@ -1,8 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include <arbor/assert.hpp>
 #include <arbor/fvm_types.hpp>
 #include <arbor/math.hpp>
+#include <arbor/simd/simd.hpp>
 
 #include "backends/threshold_crossing.hpp"
 #include "execution_context.hpp"
@@ -11,8 +15,20 @@
 namespace arb {
 namespace multicore {
 
+// Watches the values at a set of CVs for crossings of per-CV thresholds.
+//
+// The watched CVs, thresholds and previous values are held in arrays
+// padded to a multiple of simd_width, and are tested simd_width at a time:
+// a watch is crossed if its last value is at or above its threshold, so
+// that a crossing is a lane with the current value at or above the
+// threshold and the previous value below it. The crossing mask of each
+// block is packed into an integer, and only blocks with a crossing lane
+// take the scalar path that interpolates the crossing time.
+
 class threshold_watcher {
 public:
+    static constexpr int simd_width = std::max(4, simd::simd_abi::native_width<fvm_value_type>::value);
+
     threshold_watcher() = default;
 
     threshold_watcher(const execution_context& ctx) {}
@@ -30,13 +46,18 @@ public:
         t_before_(t_before),
         t_after_(t_after),
         values_(values),
-        n_cv_(cv_index.size()),
-        cv_index_(cv_index),
-        is_crossed_(n_cv_),
-        thresholds_(thresholds),
-        v_prev_(values_, values_+n_cv_)
+        n_cv_(cv_index.size())
     {
         arb_assert(n_cv_==thresholds.size());
+
+        // Padding lanes watch CV 0, and are never reported.
+        auto n_padded = (n_cv_+simd_width-1)/simd_width*simd_width;
+        cv_index_.assign(n_padded, 0);
+        thresholds_.assign(n_padded, 0);
+        v_prev_.assign(n_padded, 0);
+        std::copy(cv_index.begin(), cv_index.end(), cv_index_.begin());
+        std::copy(thresholds.begin(), thresholds.end(), thresholds_.begin());
+
         reset();
     }
 
@@ -51,8 +72,8 @@ public:
     /// calling, because the values are used to determine the initial state
     void reset() {
         clear_crossings();
-        for (fvm_size_type i = 0; i<n_cv_; ++i) {
-            is_crossed_[i] = values_[cv_index_[i]]>=thresholds_[i];
+        for (fvm_size_type i = 0; i<cv_index_.size(); ++i) {
+            v_prev_[i] = values_[cv_index_[i]];
         }
     }
 
@@ -64,36 +85,31 @@ public:
     /// Crossing events are recorded for each threshold that
     /// is crossed since the last call to test
     void test() {
-        for (fvm_size_type i = 0; i<n_cv_; ++i) {
-            auto cv     = cv_index_[i];
-            auto cell   = cv_to_intdom_[cv];
-            auto v_prev = v_prev_[i];
-            auto v      = values_[cv];
-            auto thresh = thresholds_[i];
-
-            if (!is_crossed_[i]) {
-                if (v>=thresh) {
-                    // The threshold has been passed, so estimate the time using
-                    // linear interpolation.
-                    auto pos = (thresh - v_prev)/(v - v_prev);
-                    auto crossing_time = math::lerp(t_before_[cell], t_after_[cell], pos);
-                    crossings_.push_back({i, crossing_time});
-
-                    is_crossed_[i] = true;
+        using simd_value = simd::simd<fvm_value_type, simd_width>;
+        using simd_index = simd::simd<fvm_index_type, simd_width>;
+        constexpr fvm_size_type W = simd_width;
+
+        for (fvm_size_type i = 0; i<cv_index_.size(); i += W) {
+            simd_index cv(cv_index_.data()+i);
+            simd_value v(simd::indirect(values_, cv));
+            simd_value v_prev(v_prev_.data()+i);
+            simd_value thresh(thresholds_.data()+i);
+
+            auto m = v>=thresh && v_prev<thresh;
+            v.copy_to(v_prev_.data()+i);
+
+            if (auto crossed = m.pack()) {
+                for (fvm_size_type k = 0; k<W; ++k) {
+                    if ((crossed>>k)&1 && i+k<n_cv_) {
+                        record_crossing(i+k, v_prev[k], v[k]);
+                    }
                 }
             }
-            else {
-                if (v<thresh) {
-                    is_crossed_[i] = false;
-                }
-            }
-
-            v_prev_[i] = v;
         }
     }
 
     bool is_crossed(fvm_size_type i) const {
-        return is_crossed_[i];
+        return v_prev_[i]>=thresholds_[i];
     }
 
     /// The number of threshold values that are monitored.
@@ -109,13 +125,23 @@ private:
     const fvm_value_type* t_after_ = nullptr;
     const fvm_value_type* values_ = nullptr;
 
-    /// Threshold watcher state.
+    /// Threshold watcher state, padded to a multiple of simd_width.
     fvm_size_type n_cv_ = 0;
-    std::vector<fvm_index_type> cv_index_;
-    std::vector<fvm_size_type> is_crossed_;
-    std::vector<fvm_value_type> thresholds_;
-    std::vector<fvm_value_type> v_prev_;
+    iarray cv_index_;
+    array thresholds_;
+    array v_prev_;
     std::vector<threshold_crossing> crossings_;
+
+    // The threshold of watch i has been crossed, rising from v_prev to v:
+    // estimate the time using linear interpolation.
+    void record_crossing(fvm_size_type i, fvm_value_type v_prev, fvm_value_type v) {
+        auto thresh = thresholds_[i];
+        auto cell = cv_to_intdom_[cv_index_[i]];
+
+        auto pos = (thresh - v_prev)/(v - v_prev);
+        auto crossing_time = math::lerp(t_before_[cell], t_after_[cell], pos);
+        crossings_.push_back({i, crossing_time});
+    }
 };
 
 } // namespace multicore
@@ -86,7 +86,17 @@ void benchmark_cell_group::add_sampler(sampler_association_handle h,
                                    sampler_function fn,
                                    sampling_policy policy)
 {
-    std::logic_error("A benchmark_cell group doen't support sampling of internal state!");
+    // Samplers are added to every cell group, and there is no internal
+    // state of a benchmark_cell to sample: ignore them.
+}
+
+void benchmark_cell_group::add_bulk_sampler(sampler_association_handle h,
+                                   cell_member_predicate probe_ids,
+                                   schedule sched,
+                                   bulk_sampler_function fn,
+                                   sampling_policy policy)
+{
+    // As for add_sampler.
 }
 
 } // namespace arb
@@ -29,6 +29,8 @@ public:
 
     void add_sampler(sampler_association_handle h, cell_member_predicate probe_ids, schedule sched, sampler_function fn, sampling_policy policy) override;
 
+    void add_bulk_sampler(sampler_association_handle h, cell_member_predicate probe_ids, schedule sched, bulk_sampler_function fn, sampling_policy policy) override;
+
     void remove_sampler(sampler_association_handle h) override {}
 
     void remove_all_samplers() override {}
@@ -0,0 +1,73 @@
+#pragma once
+
+/*
+ * Helper for cell groups that advance their cells in chunks of cells,
+ * each chunk as one task.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <arbor/spike.hpp>
+
+#include "threading/threading.hpp"
+#include "util/span.hpp"
+
+namespace arb {
+
+// Splits the cells [0, n) of a group into chunks of chunk_cells cells.
+// The chunks are advanced independently, in parallel if there is a task
+// system, and the spikes of each chunk are kept apart until all chunks
+// have been advanced.
+
+class cell_chunks {
+public:
+    // Cells per chunk of cells advanced as one task; a multiple of the
+    // SIMD width of the cell groups that use it.
+    static constexpr std::size_t chunk_cells = 1024;
+
+    cell_chunks() = default;
+
+    explicit cell_chunks(std::size_t n_cells):
+        n_cells_(n_cells),
+        chunk_spikes_((n_cells+chunk_cells-1)/chunk_cells)
+    {}
+
+    std::size_t size() const {
+        return chunk_spikes_.size();
+    }
+
+    // Calls f(begin, end, spikes) for the cells [begin, end) of each chunk,
+    // where spikes collects the spikes of the chunk, then appends the spikes
+    // of the chunks to out in order of chunk.
+    template <typename F>
+    void advance(const task_system_handle& threads, std::vector<spike>& out, F&& f) {
+        auto advance_chunk = [&](std::size_t c) {
+            auto begin = c*chunk_cells;
+            f(begin, std::min(begin+chunk_cells, n_cells_), chunk_spikes_[c]);
+        };
+
+        if (threads && size()>1) {
+            threading::parallel_for::apply(0, size(), threads.get(), advance_chunk);
+        }
+        else {
+            for (auto c: util::make_span(size())) {
+                advance_chunk(c);
+            }
+        }
+
+        for (auto& s: chunk_spikes_) {
+            out.insert(out.end(), s.begin(), s.end());
+            s.clear();
+        }
+    }
+
+private:
+    std::size_t n_cells_ = 0;
+
+    // Spikes generated by each chunk in the current call to advance.
+    std::vector<std::vector<spike>> chunk_spikes_;
+};
+
+} // namespace arb
@@ -35,6 +35,7 @@ public:
     // from a sampler call back called from a different cell group running on a different thread.
 
     virtual void add_sampler(sampler_association_handle, cell_member_predicate, schedule, sampler_function, sampling_policy) = 0;
+    virtual void add_bulk_sampler(sampler_association_handle, cell_member_predicate, schedule, bulk_sampler_function, sampling_policy) = 0;
     virtual void remove_sampler(sampler_association_handle) = 0;
     virtual void remove_all_samplers() = 0;
 };
@@ -3,11 +3,13 @@
 #include <arbor/common_types.hpp>
 #include <arbor/recipe.hpp>
 
+#include "adex_cell_group.hpp"
 #include "benchmark_cell_group.hpp"
 #include "cell_group.hpp"
 #include "cell_group_factory.hpp"
 #include "execution_context.hpp"
 #include "fvm_lowered_cell.hpp"
+#include "izhikevich_cell_group.hpp"
 #include "lif_cell_group.hpp"
 #include "mc_cell_group.hpp"
 #include "spike_source_cell_group.hpp"
@@ -40,8 +42,22 @@ cell_group_factory cell_kind_implementation(
     case cell_kind::lif:
         if (bk!=backend_kind::multicore) break;
 
-        return [](const gid_vector& gids, const recipe& rec) {
-            return make_cell_group<lif_cell_group>(gids, rec);
+        return [ctx](const gid_vector& gids, const recipe& rec) {
+            return make_cell_group<lif_cell_group>(gids, rec, ctx.thread_pool);
+        };
+
+    case cell_kind::adex:
+        if (bk!=backend_kind::multicore) break;
+
+        return [ctx](const gid_vector& gids, const recipe& rec) {
+            return make_cell_group<adex_cell_group>(gids, rec, ctx.thread_pool);
+        };
+
+    case cell_kind::izhikevich:
+        if (bk!=backend_kind::multicore) break;
+
+        return [ctx](const gid_vector& gids, const recipe& rec) {
+            return make_cell_group<izhikevich_cell_group>(gids, rec, ctx.thread_pool);
         };
 
     case cell_kind::benchmark:
@@ -19,6 +19,10 @@ std::ostream& operator<<(std::ostream& o, arb::cell_kind k) {
         return o << "lif";
     case arb::cell_kind::benchmark:
         return o << "benchmark_cell";
+    case arb::cell_kind::adex:
+        return o << "adex";
+    case arb::cell_kind::izhikevich:
+        return o << "izhikevich";
     }
     return o;
 }
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <numeric>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -22,10 +25,33 @@
 
 namespace arb {
 
+namespace {
+// Connections are built in contiguous batches of local cells, with at least
+// this many cells per batch.
+constexpr std::size_t min_batch_cells = 256;
+
+// A local connection, as staged for sorting during construction of the
+// connection table.
+struct staged_connection {
+    cell_member_type source;
+    cell_size_type index_on_domain;
+    cell_lid_type target_lid;
+    float weight;
+    time_type delay;
+
+    friend bool operator<(const staged_connection& l, const staged_connection& r) {
+        return std::tie(l.source, l.index_on_domain, l.target_lid)
+             < std::tie(r.source, r.index_on_domain, r.target_lid);
+    }
+};
+} // anonymous namespace
+
 communicator::communicator(const recipe& rec,
                           const domain_decomposition& dom_dec,
                           execution_context& ctx)
 {
+    using util::make_span;
+
     distributed_ = ctx.distributed;
     thread_pool_ = ctx.thread_pool;
 
@@ -33,70 +59,78 @@ communicator::communicator(const recipe& rec,
     num_local_groups_ = dom_dec.groups.size();
     num_local_cells_ = dom_dec.num_local_cells;
 
-    // For caching information about each cell
-    struct gid_info {
-        using connection_list = decltype(std::declval<recipe>().connections_on(0));
-        cell_gid_type gid;              // global identifier of cell
-        cell_size_type index_on_domain; // index of cell in this domain
-        connection_list conns;          // list of connections terminating at this cell
-        gid_info() = default;           // so we can in a std::vector
-        gid_info(cell_gid_type g, cell_size_type di, connection_list c):
-            gid(g), index_on_domain(di), conns(std::move(c)) {}
-    };
-
-    // Make a list of local gid with their group index and connections
-    //   -> gid_infos
-    // Count the number of local connections (i.e. connections terminating on this domain)
-    //   -> n_cons: scalar
-    // Calculate and store domain id of the presynaptic cell on each local connection
-    //   -> src_domains: array with one entry for every local connection
-    // Also the count of presynaptic sources from each domain
-    //   -> src_counts: array with one entry for each domain
-
     // Record all the gid in a flat vector.
-    // These are used to map from local index to gid in the parallel loop
-    // that populates gid_infos.
+    // These are used to map from local index to gid in the parallel loops
+    // that build the connections.
     std::vector<cell_gid_type> gids;
     gids.reserve(num_local_cells_);
     for (auto g: dom_dec.groups) {
         util::append(gids, g.gids);
     }
-    // Build the connection information for local cells in parallel.
-    std::vector<gid_info> gid_infos;
-    gid_infos.resize(num_local_cells_);
-    threading::parallel_for::apply(0, gids.size(), thread_pool_.get(),
-        [&](cell_size_type i) {
-            auto gid = gids[i];
-            gid_infos[i] = gid_info(gid, i, rec.connections_on(gid));
-        });
 
-    cell_local_size_type n_cons =
-        util::sum_by(gid_infos, [](const gid_info& g){ return g.conns.size(); });
-    std::vector<unsigned> src_domains;
-    src_domains.reserve(n_cons);
-    std::vector<cell_size_type> src_counts(num_domains_);
-    for (const auto& g: gid_infos) {
-        for (auto con: g.conns) {
-            const auto src = dom_dec.gid_domain(con.source.gid);
-            src_domains.push_back(src);
-            src_counts[src]++;
-        }
-    }
+    // The connection table is built in two passes over the local cells, with
+    // the cells divided into contiguous batches that are processed in
+    // parallel. The connections of each cell are requested from the recipe
+    // in both passes, and only one list of connections is held at a time by
+    // each thread.
+    //
+    // The first pass counts the connections from each source domain in each
+    // batch:
+    //   -> batch_counts: num_domains_ counts for each batch
+    // which gives the position of the connections of each batch in an array
+    // of connections partitioned by source domain, in which the connections
+    // of each domain are ordered by batch:
+    //   -> connection_part: partition of connections by source domain
+    //   -> batch_offsets: offset of the connections of each (domain, batch)
+    // The second pass copies the connections into their place in the array.
+    const std::size_t n_cells = gids.size();
+    const std::size_t n_batches = std::max<std::size_t>(1, std::min<std::size_t>(
+        4*thread_pool_->get_num_threads(), (n_cells+min_batch_cells-1)/min_batch_cells));
+    auto batch_range = [&](std::size_t b) {
+        return make_span(n_cells*b/n_batches, n_cells*(b+1)/n_batches);
+    };
 
-    // Construct the connections.
-    // The loop above gave the information required to construct in place
-    // the connections as partitioned by the domain of their source gid.
-    connections_.resize(n_cons);
-    connection_part_ = algorithms::make_index(src_counts);
-    auto offsets = connection_part_;
-    std::size_t pos = 0;
-    for (const auto& cell: gid_infos) {
-        for (auto c: cell.conns) {
-            const auto i = offsets[src_domains[pos]]++;
-            connections_[i] = {c.source, c.dest, c.weight, c.delay, cell.index_on_domain};
-            ++pos;
+    std::vector<cell_size_type> batch_counts(n_batches*num_domains_);
+    threading::parallel_for::apply(0, n_batches, thread_pool_.get(),
+        [&](std::size_t b) {
+            auto counts = batch_counts.begin()+b*num_domains_;
+            for (auto i: batch_range(b)) {
+                for (const auto& c: rec.connections_on(gids[i])) {
+                    ++counts[dom_dec.gid_domain(c.source.gid)];
+                }
+            }
+        });
+
+    // Exclusive scan over (domain, batch) in domain-major order.
+    std::vector<cell_size_type> batch_offsets(n_batches*num_domains_+1);
+    std::vector<cell_size_type> connection_part(num_domains_+1);
+    cell_size_type n_cons = 0;
+    for (auto dom: make_span(num_domains_)) {
+        connection_part[dom] = n_cons;
+        for (auto b: make_span(n_batches)) {
+            batch_offsets[dom*n_batches+b] = n_cons;
+            n_cons += batch_counts[b*num_domains_+dom];
         }
     }
+    connection_part[num_domains_] = n_cons;
+    batch_offsets[n_batches*num_domains_] = n_cons;
+
+    std::vector<staged_connection> connections(n_cons);
+    threading::parallel_for::apply(0, n_batches, thread_pool_.get(),
+        [&](std::size_t b) {
+            std::vector<cell_size_type> offsets(num_domains_);
+            for (auto dom: make_span(num_domains_)) {
+                offsets[dom] = batch_offsets[dom*n_batches+b];
+            }
+            for (auto i: batch_range(b)) {
+                for (const auto& c: rec.connections_on(gids[i])) {
+                    const auto dom = dom_dec.gid_domain(c.source.gid);
+                    connections[offsets[dom]++] = {c.source, cell_size_type(i), c.dest.index, c.weight, c.delay};
+                }
+            }
+        });
+    batch_counts.clear();
+    batch_counts.shrink_to_fit();
 
     // Build cell partition by group for passing events to cell groups
     index_part_ = util::make_partition(index_divisions_,
@@ -104,13 +138,70 @@ communicator::communicator(const recipe& rec,
             dom_dec.groups,
             [](const group_description& g){return g.gids.size();}));
 
-    // Sort the connections for each domain.
-    // This is num_domains_ independent sorts, so it can be parallelized trivially.
-    const auto& cp = connection_part_;
+    // Sort the connections of each domain: first sort the connections of each
+    // (domain, batch) in parallel, then merge pairs of adjacent sorted runs
+    // within each domain, in parallel, until each domain is a single run.
+    const auto& bo = batch_offsets;
+    threading::parallel_for::apply(0, num_domains_*n_batches, thread_pool_.get(),
+        [&](std::size_t k) {
+            std::sort(connections.begin()+bo[k], connections.begin()+bo[k+1]);
+        });
+    for (std::size_t width = 1; width<n_batches; width *= 2) {
+        const std::size_t n_pairs = (n_batches+2*width-1)/(2*width);
+        threading::parallel_for::apply(0, num_domains_*n_pairs, thread_pool_.get(),
+            [&](std::size_t k) {
+                const auto dom = k/n_pairs;
+                const auto first = dom*n_batches + (k%n_pairs)*2*width;
+                const auto mid = std::min(first+width, (dom+1)*n_batches);
+                const auto last = std::min(first+2*width, (dom+1)*n_batches);
+                std::inplace_merge(
+                    connections.begin()+bo[first],
+                    connections.begin()+bo[mid],
+                    connections.begin()+bo[last]);
+            });
+    }
+    batch_offsets.clear();
+    batch_offsets.shrink_to_fit();
+
+    // Compress the sorted connections into the connection table: count the
+    // unique sources of each domain, then fill the table for each domain in
+    // parallel.
+    const auto& cp = connection_part;
+    std::vector<cell_size_type> source_counts(num_domains_);
     threading::parallel_for::apply(0, num_domains_, thread_pool_.get(),
-        [&](cell_size_type i) {
-            util::sort(util::subrange_view(connections_, cp[i], cp[i+1]));
+        [&](cell_size_type dom) {
+            cell_size_type n = 0;
+            for (auto i: make_span(cp[dom], cp[dom+1])) {
+                n += i==cp[dom] || !(connections[i-1].source==connections[i].source);
+            }
+            source_counts[dom] = n;
         });
+    source_part_ = algorithms::make_index(source_counts);
+
+    local_gids_ = std::move(gids);
+    sources_.resize(source_part_.back());
+    source_divisions_.resize(source_part_.back()+1);
+    target_lids_.resize(n_cons);
+    target_indices_.resize(n_cons);
+    weights_.resize(n_cons);
+    delays_.resize(n_cons);
+    threading::parallel_for::apply(0, num_domains_, thread_pool_.get(),
+        [&](cell_size_type dom) {
+            auto k = source_part_[dom];
+            for (auto i: make_span(cp[dom], cp[dom+1])) {
+                const auto& c = connections[i];
+                if (i==cp[dom] || !(connections[i-1].source==c.source)) {
+                    sources_[k] = c.source;
+                    source_divisions_[k] = i;
+                    ++k;
+                }
+                target_lids_[i] = c.target_lid;
+                target_indices_[i] = c.index_on_domain;
+                weights_[i] = c.weight;
+                delays_[i] = c.delay;
+            }
+        });
+    source_divisions_.back() = n_cons;
 }
 
 std::pair<cell_size_type, cell_size_type> communicator::group_queue_range(cell_size_type i) {
@@ -120,87 +211,277 @@ std::pair<cell_size_type, cell_size_type> communicator::group_queue_range(cell_s
 
 time_type communicator::min_delay() {
     auto local_min = std::numeric_limits<time_type>::max();
-    for (auto& con : connections_) {
-        local_min = std::min(local_min, con.delay());
+    for (auto d: delays_) {
+        local_min = std::min(local_min, d);
     }
 
     return distributed_->min(local_min);
 }
 
+time_type communicator::max_local_delay() const {
+    time_type local_max = 0;
+    for (auto d: delays_) {
+        local_max = std::max(local_max, d);
+    }
+    return local_max;
+}
+
+void communicator::set_exchange_kind(spike_exchange_kind kind) {
+    if (kind==spike_exchange_kind::sparse && route_divisions_.empty()) {
+        make_routes();
+    }
+    exchange_kind_ = kind;
+}
+
+spike_exchange_kind communicator::exchange_kind() const {
+    return exchange_kind_;
+}
+
+void communicator::set_spike_compression(bool compress) {
+    compress_spikes_ = compress;
+}
+
+// Build the routing table for sparse spike exchange.
+//
+// The sources of the connection table are partitioned by source domain, and
+// sorted within each partition, so the unique source gids in each partition
+// are the gids that this domain requires from the corresponding source domain. These
+// requests are sent to the source domains in a single all-to-all exchange;
+// the requests received are the gids of local cells with the domains that
+// require their spikes.
+void communicator::make_routes() {
+    using util::make_span;
+    using util::subrange_view;
+
+    const auto& sp = source_part_;
+    std::vector<cell_gid_type> requests;
+    std::vector<unsigned> request_part;
+    request_part.reserve(num_domains_+1);
+    request_part.push_back(0);
+    for (auto dom: make_span(num_domains_)) {
+        for (const auto& src: subrange_view(sources_, sp[dom], sp[dom+1])) {
+            const auto gid = src.gid;
+            if (requests.size()==request_part.back() || requests.back()!=gid) {
+                requests.push_back(gid);
+            }
+        }
+        request_part.push_back(requests.size());
+    }
+
+    auto received = distributed_->alltoall_gids(requests, request_part);
+
+    // Sort (gid, domain) pairs by gid, then by domain.
+    const auto& rp = received.partition();
+    std::vector<std::pair<cell_gid_type, unsigned>> routes;
+    routes.reserve(received.size());
+    for (auto dom: make_span(num_domains_)) {
+        for (auto i: make_span(rp[dom], rp[dom+1])) {
+            routes.push_back({received.values()[i], dom});
+        }
+    }
+    util::sort(routes);
+
+    route_gids_.clear();
+    route_divisions_.clear();
+    route_domains_.clear();
+    route_domains_.reserve(routes.size());
+    for (const auto& r: routes) {
+        if (route_gids_.empty() || route_gids_.back()!=r.first) {
+            route_gids_.push_back(r.first);
+            route_divisions_.push_back(route_domains_.size());
+        }
+        route_domains_.push_back(r.second);
+    }
+    route_divisions_.push_back(route_domains_.size());
+}
+
 gathered_vector<spike> communicator::exchange(std::vector<spike> local_spikes) {
+    auto request = start_exchange(std::move(local_spikes));
+    return finish_exchange(request);
+}
+
+spike_gather_request communicator::start_exchange(std::vector<spike> local_spikes) {
     PE(communication_exchange_sort);
     // sort the spikes in ascending order of source gid
     util::sort_by(local_spikes, [](spike s){return s.source;});
     PL();
 
+    if (exchange_kind_==spike_exchange_kind::all_gather) {
+        PE(communication_exchange_post);
+        // global all-to-all to gather a local copy of the global spike list on each node.
+        auto request = compress_spikes_?
+            distributed_->gather_spikes_compressed_async(local_spikes):
+            distributed_->gather_spikes_async(std::move(local_spikes));
+        PL();
+
+        return request;
+    }
+
+    return completed_spike_gather{sparse_exchange(local_spikes)};
+}
+
+gathered_vector<spike> communicator::finish_exchange(spike_gather_request& request) {
     PE(communication_exchange_gather);
-    // global all-to-all to gather a local copy of the global spike list on each node.
-    auto global_spikes = distributed_->gather_spikes(local_spikes);
-    num_spikes_ += global_spikes.size();
+    auto global_spikes = request.finish();
+    // Sparse exchange counts the global number of spikes when it is started.
+    if (exchange_kind_==spike_exchange_kind::all_gather) {
+        num_spikes_ += global_spikes.size();
+    }
     PL();
 
     return global_spikes;
 }
 
+gathered_vector<spike> communicator::sparse_exchange(const std::vector<spike>& local_spikes) {
+    PE(communication_exchange_route);
+    // Find the route of each spike: as both the spikes and the routes are
+    // sorted by gid, the search for each spike starts from the last match.
+    const auto n_routes = route_gids_.size();
+    std::vector<cell_size_type> spike_routes;
+    spike_routes.reserve(local_spikes.size());
+    std::vector<unsigned> send_part(num_domains_+1);
+    auto r = route_gids_.begin();
+    for (const auto& s: local_spikes) {
+        r = std::lower_bound(r, route_gids_.end(), s.source.gid);
+        const cell_size_type k = r-route_gids_.begin();
+        spike_routes.push_back(k);
+        if (k<n_routes && *r==s.source.gid) {
+            for (auto i: util::make_span(route_divisions_[k], route_divisions_[k+1])) {
+                ++send_part[route_domains_[i]+1];
+            }
+        }
+    }
+    std::partial_sum(send_part.begin(), send_part.end(), send_part.begin());
+
+    // Copy each spike into the send buffer of every domain that requires it,
+    // preserving the order of sources within each buffer.
+    std::vector<spike> send_spikes(send_part.back());
+    std::vector<unsigned> offsets(send_part.begin(), send_part.end()-1);
+    for (auto i: util::make_span(local_spikes.size())) {
+        const auto k = spike_routes[i];
+        if (k<n_routes && route_gids_[k]==local_spikes[i].source.gid) {
+            for (auto j: util::make_span(route_divisions_[k], route_divisions_[k+1])) {
+                send_spikes[offsets[route_domains_[j]]++] = local_spikes[i];
+            }
+        }
+    }
+    PL();
+
+    PE(communication_exchange_alltoall);
+    // personalised all-to-all: each domain receives only the spikes it requires.
+    auto received_spikes = distributed_->alltoall_spikes(send_spikes, send_part);
+    num_spikes_ += distributed_->sum(local_spikes.size());
+    PL();
+
+    return received_spikes;
+}
+
+namespace {
+// Minimum number of spikes per block when generating events in parallel.
+constexpr std::size_t min_block_spikes = 32;
+
+// Exponential search for the first element of [first, last) that is not less
+// than key: the cost is logarithmic in the distance to the result, so that a
+// walk over a sorted sequence of keys takes amortized constant time per key.
+template <typename It, typename T>
+It gallop_lower_bound(It first, It last, const T& key) {
+    const std::ptrdiff_t n = last-first;
+    std::ptrdiff_t bound = 1;
+    while (bound<n && first[bound]<key) {
+        bound *= 2;
+    }
+    return std::lower_bound(first+bound/2, first+std::min(bound+1, n), key);
+}
+} // anonymous namespace
+
 void communicator::make_event_queues(
         const gathered_vector<spike>& global_spikes,
         std::vector<pse_vector>& queues)
 {
     arb_assert(queues.size()==num_local_cells_);
 
-    using util::subrange_view;
     using util::make_span;
-    using util::make_range;
 
     const auto& sp = global_spikes.partition();
-    const auto& cp = connection_part_;
-    for (auto dom: make_span(num_domains_)) {
-        auto cons = subrange_view(connections_, cp[dom], cp[dom+1]);
-        auto spks = subrange_view(global_spikes.values(), sp[dom], sp[dom+1]);
-
-        struct spike_pred {
-            bool operator()(const spike& spk, const cell_member_type& src)
-                {return spk.source<src;}
-            bool operator()(const cell_member_type& src, const spike& spk)
-                {return src<spk.source;}
-        };
-
-        // We have a choice of whether to walk spikes or connections:
-        // i.e., we can iterate over the spikes, and for each spike search
-        // the for connections that have the same source; or alternatively
-        // for each connection, we can search the list of spikes for spikes
-        // with the same source.
-        //
-        // We iterate over whichever set is the smallest, which has
-        // complexity of order max(S log(C), C log(S)), where S is the
-        // number of spikes, and C is the number of connections.
-        if (cons.size()<spks.size()) {
-            auto sp = spks.begin();
-            auto cn = cons.begin();
-            while (cn!=cons.end() && sp!=spks.end()) {
-                auto sources = std::equal_range(sp, spks.end(), cn->source(), spike_pred());
-                for (auto s: make_range(sources)) {
-                    queues[cn->index_on_domain()].push_back(cn->make_event(s));
+    const auto& spikes = global_spikes.values();
+    const std::size_t n_spikes = spikes.size();
+
+    // Generate the events for the spikes in [first, last), which may span
+    // several source domains. Spikes and the sources of the connection table
+    // are both sorted within each domain, so they are walked together.
+    auto make_events = [&](std::size_t first, std::size_t last, auto&& emit) {
+        cell_size_type dom = std::upper_bound(sp.begin(), sp.end(), first)-sp.begin()-1;
+        for (; dom<num_domains_ && sp[dom]<last; ++dom) {
+            auto src = sources_.begin()+source_part_[dom];
+            const auto src_end = sources_.begin()+source_part_[dom+1];
+            const auto spk_end = std::min<std::size_t>(sp[dom+1], last);
+            for (auto k = std::max<std::size_t>(sp[dom], first); k<spk_end && src!=src_end; ++k) {
+                const auto& spk = spikes[k];
+                src = gallop_lower_bound(src, src_end, spk.source);
+                if (src==src_end || !(*src==spk.source)) continue;
+
+                const auto s = src-sources_.begin();
+                for (auto i: make_span(source_divisions_[s], source_divisions_[s+1])) {
+                    const auto target = target_indices_[i];
+                    emit(target, spike_event{{local_gids_[target], target_lids_[i]}, spk.time+delays_[i], weights_[i]});
                 }
-
-                sp = sources.first;
-                ++cn;
             }
         }
-        else {
-            auto cn = cons.begin();
-            auto sp = spks.begin();
-            while (cn!=cons.end() && sp!=spks.end()) {
-                auto targets = std::equal_range(cn, cons.end(), sp->source);
-                for (auto c: make_range(targets)) {
-                    queues[c.index_on_domain()].push_back(c.make_event(*sp));
-                }
+    };
 
-                cn = targets.first;
-                ++sp;
-            }
-        }
+    const std::size_t n_blocks = std::min<std::size_t>(
+        thread_pool_->get_num_threads(), n_spikes/min_block_spikes);
+
+    if (n_blocks<2) {
+        make_events(0, n_spikes,
+            [&](cell_size_type i, const spike_event& e) { queues[i].push_back(e); });
+        return;
     }
+
+    // Generate events from contiguous blocks of spikes in parallel, staging
+    // them in a buffer per block along with the count of events for each cell.
+    if (event_stages_.size()<n_blocks) {
+        event_stages_.resize(n_blocks);
+    }
+    threading::parallel_for::apply(0, n_blocks, thread_pool_.get(),
+        [&](std::size_t b) {
+            auto& stage = event_stages_[b];
+            stage.index.clear();
+            stage.events.clear();
+            stage.counts.assign(num_local_cells_, 0);
+            make_events(n_spikes*b/n_blocks, n_spikes*(b+1)/n_blocks,
+                [&stage](cell_size_type i, const spike_event& e) {
+                    stage.index.push_back(i);
+                    stage.events.push_back(e);
+                    ++stage.counts[i];
+                });
+        });
+
+    // Grow each queue to take its new events, replacing the count of events
+    // from each block with the position of the first of them in the queue.
+    threading::parallel_for::apply(0, num_local_cells_, thread_pool_.get(),
+        threading::partitioner(threading::partition_kind::static_blocks, 256),
+        [&](cell_size_type i) {
+            auto n = queues[i].size();
+            for (auto b: make_span(n_blocks)) {
+                auto& count = event_stages_[b].counts[i];
+                auto k = count;
+                count = n;
+                n += k;
+            }
+            queues[i].resize(n);
+        });
+
+    // Scatter the staged events into the queues: each block writes to a
+    // disjoint set of positions in each queue.
+    threading::parallel_for::apply(0, n_blocks, thread_pool_.get(),
+        [&](std::size_t b) {
+            auto& stage = event_stages_[b];
+            for (auto j: make_span(stage.events.size())) {
+                auto i = stage.index[j];
+                queues[i][stage.counts[i]++] = stage.events[j];
+            }
+        });
 }
 
 std::uint64_t communicator::num_spikes() const {
@@ -211,8 +492,17 @@ cell_size_type communicator::num_local_cells() const {
     return num_local_cells_;
 }
 
-const std::vector<connection>& communicator::connections() const {
-    return connections_;
+std::vector<connection> communicator::connections() const {
+    std::vector<connection> cons;
+    cons.reserve(target_indices_.size());
+    for (auto s: util::make_span(sources_.size())) {
+        for (auto i: util::make_span(source_divisions_[s], source_divisions_[s+1])) {
+            const auto target = target_indices_[i];
+            cons.emplace_back(sources_[s], cell_member_type{local_gids_[target], target_lids_[i]},
+                weights_[i], delays_[i], target);
+        }
+    }
+    return cons;
 }
 
 void communicator::reset() {
@@ -6,9 +6,11 @@
 #include <arbor/domain_decomposition.hpp>
 #include <arbor/recipe.hpp>
 #include <arbor/spike.hpp>
+#include <arbor/spike_event.hpp>
 
 #include "communication/gathered_vector.hpp"
 #include "connection.hpp"
+#include "distributed_context.hpp"
 #include "execution_context.hpp"
 #include "util/partition.hpp"
 
@@ -39,12 +41,44 @@ public:
     /// The minimum delay of all connections in the global network.
     time_type min_delay();
 
+    /// The maximum delay of the connections to cells on this domain.
+    time_type max_local_delay() const;
+
+    /// Select how spikes are exchanged between domains.
+    ///
+    /// Switching to sparse exchange for the first time builds the routing
+    /// table from local sources to the domains that they are connected to,
+    /// which requires communication: this must be called collectively.
+    void set_exchange_kind(spike_exchange_kind kind);
+
+    spike_exchange_kind exchange_kind() const;
+
+    /// Select whether all-gather spike exchange uses the compact wire format
+    /// of communication/spike_codec.hpp. Sparse exchange always sends full spikes.
+    void set_spike_compression(bool compress);
+
     /// Perform exchange of spikes.
     ///
     /// Takes as input the list of local_spikes that were generated on the calling domain.
-    /// Returns the full global set of vectors, along with meta data about their partition
+    /// Returns the set of spikes received from all domains, along with meta data about
+    /// their partition by source domain. For all-gather exchange this is the full
+    /// global set of spikes; for sparse exchange it contains only the spikes from
+    /// sources that are connected to a local cell.
     gathered_vector<spike> exchange(std::vector<spike> local_spikes);
 
+    /// Start a spike exchange without waiting for it to complete.
+    ///
+    /// All-gather exchanges are posted as non-blocking collectives, so that
+    /// several may be in flight at once; they must be completed with
+    /// finish_exchange in the order in which they were started. Sparse
+    /// exchanges are completed before start_exchange returns. The exchange
+    /// kind must not be changed while any exchange is in flight.
+    spike_gather_request start_exchange(std::vector<spike> local_spikes);
+
+    /// Wait for an exchange started by start_exchange to complete, and return
+    /// the spikes received, as for exchange.
+    gathered_vector<spike> finish_exchange(spike_gather_request& request);
+
     /// Check each global spike in turn to see it generates local events.
     /// If so, make the events and insert them into the appropriate event list.
     ///
@@ -62,7 +96,9 @@ public:
 
     cell_size_type num_local_cells() const;
 
-    const std::vector<connection>& connections() const;
+    /// The local connections, reconstructed from the connection table,
+    /// partitioned by source domain and sorted by source within each domain.
+    std::vector<connection> connections() const;
 
     void reset();
 
@@ -70,11 +106,50 @@ private:
     cell_size_type num_local_cells_;
     cell_size_type num_local_groups_;
     cell_size_type num_domains_;
-    std::vector<connection> connections_;
-    std::vector<cell_size_type> connection_part_;
     std::vector<cell_size_type> index_divisions_;
     util::partition_view_type<std::vector<cell_size_type>> index_part_;
 
+    // Connection table, in compressed sparse row form.
+    // The connections from source k are the entries
+    // [source_divisions_[k], source_divisions_[k+1]) of the per-connection
+    // arrays, and the sources on domain d are sources_[source_part_[d], source_part_[d+1]),
+    // sorted within each domain.
+    std::vector<cell_member_type> sources_;
+    std::vector<cell_size_type> source_divisions_;
+    std::vector<cell_size_type> source_part_;
+
+    // Per-connection arrays: the index of the target on its cell, the index
+    // on this domain of the target cell, and the weight and delay.
+    std::vector<cell_lid_type> target_lids_;
+    std::vector<cell_size_type> target_indices_;
+    std::vector<float> weights_;
+    std::vector<time_type> delays_;
+
+    // The gid of each local cell, by index on domain.
+    std::vector<cell_gid_type> local_gids_;
+
+    // Sparse exchange: the sorted gids of local cells that are the source of a
+    // connection on some domain, and for each such gid k, the list of those
+    // domains in route_domains_[route_divisions_[k], route_divisions_[k+1]).
+    spike_exchange_kind exchange_kind_ = spike_exchange_kind::all_gather;
+    bool compress_spikes_ = false;
+    std::vector<cell_gid_type> route_gids_;
+    std::vector<cell_size_type> route_divisions_;
+    std::vector<unsigned> route_domains_;
+
+    // Per-block staging of events generated in parallel by make_event_queues:
+    // the local cell index of each event, the events, and the number of
+    // events for each local cell. Retained to reuse the allocations.
+    struct event_stage {
+        std::vector<cell_size_type> index;
+        pse_vector events;
+        std::vector<cell_size_type> counts;
+    };
+    std::vector<event_stage> event_stages_;
+
+    void make_routes();
+    gathered_vector<spike> sparse_exchange(const std::vector<spike>& local_spikes);
+
     distributed_context_handle distributed_;
     task_system_handle thread_pool_;
     std::uint64_t num_spikes_ = 0u;
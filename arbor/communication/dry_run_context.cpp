@@ -41,6 +41,16 @@ struct dry_run_context_impl {
         return gathered_vector<arb::spike>(std::move(gathered_spikes), std::move(partition));
     }
 
+    spike_gather_request
+    gather_spikes_async(std::vector<arb::spike> local_spikes) const {
+        return completed_spike_gather{gather_spikes(local_spikes)};
+    }
+
+    spike_gather_request
+    gather_spikes_compressed_async(const std::vector<arb::spike>& local_spikes) const {
+        return completed_spike_gather{gather_spikes(local_spikes)};
+    }
+
     gathered_vector<cell_gid_type>
     gather_gids(const std::vector<cell_gid_type>& local_gids) const {
         using count_type = typename gathered_vector<cell_gid_type>::count_type;
@@ -68,6 +78,67 @@ struct dry_run_context_impl {
         return gathered_vector<cell_gid_type>(std::move(gathered_gids), std::move(partition));
     }
 
+    gathered_vector<double>
+    gather_cell_costs(const std::vector<double>& local_costs) const {
+        using count_type = typename gathered_vector<double>::count_type;
+
+        count_type local_size = local_costs.size();
+
+        // The costs of each tile are those of the local domain.
+        std::vector<double> gathered_costs;
+        gathered_costs.reserve(local_size*num_ranks_);
+
+        for (count_type i = 0; i < num_ranks_; i++) {
+            gathered_costs.insert(gathered_costs.end(), local_costs.begin(), local_costs.end());
+        }
+
+        std::vector<count_type> partition;
+        for (count_type i = 0; i <= num_ranks_; i++) {
+            partition.push_back(static_cast<count_type>(i*local_size));
+        }
+
+        return gathered_vector<double>(std::move(gathered_costs), std::move(partition));
+    }
+
+    // Every dry run rank is modelled as a copy of rank 0 with gids shifted by
+    // a whole number of tiles, so rank i sends to rank (i+j)%num_ranks what
+    // rank 0 sends to rank j. Rank 0 thus receives from rank i the values
+    // that it sends to rank (num_ranks-i)%num_ranks, shifted by i tiles.
+    gathered_vector<arb::spike>
+    alltoall_spikes(const std::vector<arb::spike>& send_spikes, const std::vector<unsigned>& send_partition) const {
+        return alltoall(send_spikes, send_partition,
+            [](arb::spike& s) -> cell_gid_type& { return s.source.gid; });
+    }
+
+    gathered_vector<cell_gid_type>
+    alltoall_gids(const std::vector<cell_gid_type>& send_gids, const std::vector<unsigned>& send_partition) const {
+        return alltoall(send_gids, send_partition,
+            [](cell_gid_type& gid) -> cell_gid_type& { return gid; });
+    }
+
+    template <typename T, typename GidOf>
+    gathered_vector<T>
+    alltoall(const std::vector<T>& send, const std::vector<unsigned>& send_partition, GidOf gid_of) const {
+        using count_type = typename gathered_vector<T>::count_type;
+
+        const cell_gid_type num_gids = num_ranks_*num_cells_per_tile_;
+
+        std::vector<T> received;
+        std::vector<count_type> partition = {0u};
+        for (count_type i = 0; i < num_ranks_; i++) {
+            count_type j = (num_ranks_-i)%num_ranks_;
+            for (count_type k = send_partition[j]; k < send_partition[j+1]; k++) {
+                T value = send[k];
+                auto& gid = gid_of(value);
+                gid = (gid + num_cells_per_tile_*i)%num_gids;
+                received.push_back(value);
+            }
+            partition.push_back(received.size());
+        }
+
+        return gathered_vector<T>(std::move(received), std::move(partition));
+    }
+
     int id() const { return 0; }
 
     int size() const { return num_ranks_; }
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <type_traits>
 #include <vector>
 
@@ -177,6 +178,209 @@ gathered_vector<T> gather_all_with_partition(const std::vector<T>& values, MPI_C
     );
 }
 
+/// Communicators and posting order shared by the non-blocking gathers of a
+/// context.
+///
+/// Each rank posts the second phase of a gather when it sees the counts of
+/// the first phase arrive, which differs between ranks relative to other
+/// collectives. The two phases therefore have communicators of their own,
+/// duplicated from the context's communicator, and the second phases are
+/// posted in the order in which the gathers were started.
+struct gather_sequence {
+    MPI_Comm counts_comm;
+    MPI_Comm values_comm;
+    std::size_t started = 0;    // Number of gathers started.
+    std::size_t posted = 0;     // Number of gathers with values posted.
+
+    // Collective over comm.
+    explicit gather_sequence(MPI_Comm comm) {
+        MPI_OR_THROW(MPI_Comm_dup, comm, &counts_comm);
+        MPI_OR_THROW(MPI_Comm_dup, comm, &values_comm);
+    }
+
+    gather_sequence(const gather_sequence&) = delete;
+    gather_sequence& operator=(const gather_sequence&) = delete;
+
+    ~gather_sequence() {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (!finalized) {
+            MPI_Comm_free(&counts_comm);
+            MPI_Comm_free(&values_comm);
+        }
+    }
+};
+
+/// Non-blocking gather_all_with_partition.
+///
+/// The gather proceeds in two phases: the counts are gathered with
+/// MPI_Iallgather, after which the values are gathered with MPI_Iallgatherv.
+/// test() checks for the counts without waiting, and posts the second phase
+/// once they have arrived and the gathers started before have posted theirs;
+/// finish() waits for both phases. Requests must be finished in the order in
+/// which they were started. The request owns the values to be sent.
+template <typename T>
+class gather_all_with_partition_request {
+    using gathered_type = gathered_vector<T>;
+    using count_type = typename gathered_vector<T>::count_type;
+    using traits = mpi_traits<T>;
+
+    // MPI retains pointers into the state until completion, so it is kept
+    // at a fixed address for the lifetime of the request.
+    struct state {
+        std::shared_ptr<gather_sequence> sequence;
+        std::size_t index;  // Position in the sequence of gathers.
+        MPI_Request request = MPI_REQUEST_NULL;
+        int phase = 0; // 0: gathering counts; 1: gathering values; 2: complete.
+        bool counts_ready = false;
+        int local_count;
+        std::vector<T> values;
+        std::vector<int> counts;
+        std::vector<int> displs;
+        std::vector<T> buffer;
+    };
+    std::unique_ptr<state> state_;
+
+    bool can_post() const {
+        return state_->counts_ready && state_->sequence->posted==state_->index;
+    }
+
+    void post_values() {
+        auto& s = *state_;
+        s.displs = algorithms::make_index(s.counts);
+        s.buffer.resize(s.displs.back()/traits::count());
+
+        MPI_OR_THROW(MPI_Iallgatherv,
+                // const_cast required for MPI implementations that don't use const* in their interfaces
+                const_cast<T*>(s.values.data()), s.local_count, traits::mpi_type(), // send buffer
+                s.buffer.data(), s.counts.data(), s.displs.data(), traits::mpi_type(), // receive buffer
+                s.sequence->values_comm, &s.request);
+        ++s.sequence->posted;
+        s.phase = 1;
+    }
+
+public:
+    gather_all_with_partition_request(std::vector<T> values, std::shared_ptr<gather_sequence> sequence):
+        state_(new state)
+    {
+        auto& s = *state_;
+        s.sequence = std::move(sequence);
+        s.index = s.sequence->started++;
+        s.values = std::move(values);
+        s.local_count = s.values.size()*traits::count();
+        s.counts.resize(size(s.sequence->counts_comm));
+
+        MPI_OR_THROW(MPI_Iallgather,
+                &s.local_count, 1, MPI_INT, // send buffer
+                s.counts.data(), 1, MPI_INT, // receive buffer
+                s.sequence->counts_comm, &s.request);
+    }
+
+    gather_all_with_partition_request(gather_all_with_partition_request&&) = default;
+
+    // An abandoned request must still complete before its buffers are freed.
+    ~gather_all_with_partition_request() {
+        if (state_ && state_->phase<2) {
+            MPI_Wait(&state_->request, MPI_STATUS_IGNORE);
+            if (state_->phase==0) {
+                state_->counts_ready = true;
+                if (can_post()) {
+                    post_values();
+                    MPI_Wait(&state_->request, MPI_STATUS_IGNORE);
+                }
+            }
+        }
+    }
+
+    bool test() {
+        auto& s = *state_;
+        if (s.phase==0) {
+            if (!s.counts_ready) {
+                int flag = 0;
+                MPI_OR_THROW(MPI_Test, &s.request, &flag, MPI_STATUS_IGNORE);
+                s.counts_ready = flag;
+            }
+            if (can_post()) post_values();
+        }
+        if (s.phase==1) {
+            int flag = 0;
+            MPI_OR_THROW(MPI_Test, &s.request, &flag, MPI_STATUS_IGNORE);
+            if (flag) s.phase = 2;
+        }
+        return s.phase==2;
+    }
+
+    gathered_type finish() {
+        auto& s = *state_;
+        if (s.phase==0) {
+            if (!s.counts_ready) {
+                MPI_OR_THROW(MPI_Wait, &s.request, MPI_STATUS_IGNORE);
+                s.counts_ready = true;
+            }
+            // The gathers started before this one have been finished.
+            arb_assert(can_post());
+            post_values();
+        }
+        if (s.phase==1) {
+            MPI_OR_THROW(MPI_Wait, &s.request, MPI_STATUS_IGNORE);
+            s.phase = 2;
+        }
+
+        for (auto& d : s.displs) {
+            d /= traits::count();
+        }
+
+        return gathered_type(
+            std::move(s.buffer),
+            std::vector<count_type>(s.displs.begin(), s.displs.end())
+        );
+    }
+};
+
+/// Personalised all-to-all exchange of a vector, where the values in
+/// [send_partition[i], send_partition[i+1]) are sent to rank i.
+/// The received values are partitioned by source rank.
+template <typename T>
+gathered_vector<T> alltoall_with_partition(const std::vector<T>& values, const std::vector<unsigned>& send_partition, MPI_Comm comm) {
+    using gathered_type = gathered_vector<T>;
+    using count_type = typename gathered_vector<T>::count_type;
+    using traits = mpi_traits<T>;
+
+    const int nranks = size(comm);
+    arb_assert(send_partition.size()==unsigned(nranks+1));
+
+    std::vector<int> send_counts(nranks);
+    std::vector<int> send_displs(nranks);
+    for (int i=0; i<nranks; ++i) {
+        send_counts[i] = (send_partition[i+1]-send_partition[i])*traits::count();
+        send_displs[i] = send_partition[i]*traits::count();
+    }
+
+    std::vector<int> counts(nranks);
+    MPI_OR_THROW(MPI_Alltoall,
+            send_counts.data(), 1, MPI_INT, // send buffer
+            counts.data(),      1, MPI_INT, // receive buffer
+            comm);
+    auto displs = algorithms::make_index(counts);
+
+    std::vector<T> buffer(displs.back()/traits::count());
+
+    MPI_OR_THROW(MPI_Alltoallv,
+            // const_cast required for MPI implementations that don't use const* in their interfaces
+            const_cast<T*>(values.data()), send_counts.data(), send_displs.data(), traits::mpi_type(), // send buffer
+            buffer.data(), counts.data(), displs.data(), traits::mpi_type(), // receive buffer
+            comm);
+
+    for (auto& d : displs) {
+        d /= traits::count();
+    }
+
+    return gathered_type(
+        std::move(buffer),
+        std::vector<count_type>(displs.begin(), displs.end())
+    );
+}
+
 template <typename T>
 T reduce(T value, MPI_Op op, int root, MPI_Comm comm) {
     using traits = mpi_traits<T>;
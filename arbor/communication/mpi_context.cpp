@@ -5,6 +5,7 @@
 #error "build only if MPI is enabled"
 #endif
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,17 +14,30 @@
 #include <arbor/spike.hpp>
 
 #include "communication/mpi.hpp"
+#include "communication/spike_codec.hpp"
 #include "distributed_context.hpp"
 
 namespace arb {
 
+// Non-blocking gather of spikes in the compact wire format, decoded on completion.
+struct compressed_spike_gather {
+    mpi::gather_all_with_partition_request<char> request;
+
+    bool test() { return request.test(); }
+    gathered_vector<arb::spike> finish() { return decode_spikes(request.finish()); }
+};
+
 // Throws arb::mpi::mpi_error if MPI calls fail.
 struct mpi_context_impl {
     int size_;
     int rank_;
     MPI_Comm comm_;
+    std::shared_ptr<mpi::gather_sequence> gathers_;
 
-    explicit mpi_context_impl(MPI_Comm comm): comm_(comm) {
+    explicit mpi_context_impl(MPI_Comm comm):
+        comm_(comm),
+        gathers_(std::make_shared<mpi::gather_sequence>(comm))
+    {
         size_ = mpi::size(comm_);
         rank_ = mpi::rank(comm_);
     }
@@ -33,11 +47,37 @@ struct mpi_context_impl {
         return mpi::gather_all_with_partition(local_spikes, comm_);
     }
 
+    spike_gather_request
+    gather_spikes_async(std::vector<arb::spike> local_spikes) const {
+        return mpi::gather_all_with_partition_request<arb::spike>(std::move(local_spikes), gathers_);
+    }
+
+    spike_gather_request
+    gather_spikes_compressed_async(const std::vector<arb::spike>& local_spikes) const {
+        return compressed_spike_gather{
+            mpi::gather_all_with_partition_request<char>(encode_spikes(local_spikes), gathers_)};
+    }
+
     gathered_vector<cell_gid_type>
     gather_gids(const std::vector<cell_gid_type>& local_gids) const {
         return mpi::gather_all_with_partition(local_gids, comm_);
     }
 
+    gathered_vector<double>
+    gather_cell_costs(const std::vector<double>& local_costs) const {
+        return mpi::gather_all_with_partition(local_costs, comm_);
+    }
+
+    gathered_vector<arb::spike>
+    alltoall_spikes(const std::vector<arb::spike>& send_spikes, const std::vector<unsigned>& send_partition) const {
+        return mpi::alltoall_with_partition(send_spikes, send_partition, comm_);
+    }
+
+    gathered_vector<cell_gid_type>
+    alltoall_gids(const std::vector<cell_gid_type>& send_gids, const std::vector<unsigned>& send_partition) const {
+        return mpi::alltoall_with_partition(send_gids, send_partition, comm_);
+    }
+
     std::string name() const { return "MPI"; }
     int id() const { return rank_; }
     int size() const { return size_; }
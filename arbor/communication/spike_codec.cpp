@@ -0,0 +1,115 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/spike.hpp>
+
+#include "communication/gathered_vector.hpp"
+#include "communication/spike_codec.hpp"
+
+namespace arb {
+
+namespace {
+void put_varint(std::uint64_t v, std::vector<char>& out) {
+    while (v>=0x80) {
+        out.push_back(char((v&0x7f)|0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+std::uint64_t get_varint(const char*& p, const char* end) {
+    std::uint64_t v = 0;
+    for (unsigned shift = 0; p!=end && shift<64; shift += 7) {
+        auto byte = (unsigned char)*p++;
+        v |= std::uint64_t(byte&0x7f)<<shift;
+        if (!(byte&0x80)) return v;
+    }
+    throw arbor_internal_error("spike_codec: truncated varint");
+}
+
+template <typename T>
+void put_raw(T v, std::vector<char>& out) {
+    char buf[sizeof(T)];
+    std::memcpy(buf, &v, sizeof(T));
+    out.insert(out.end(), buf, buf+sizeof(T));
+}
+
+template <typename T>
+T get_raw(const char*& p, const char* end) {
+    if (end-p<(std::ptrdiff_t)sizeof(T)) {
+        throw arbor_internal_error("spike_codec: truncated record");
+    }
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+// Zig-zag encoding maps signed differences of small magnitude to small
+// unsigned values, so that unsorted input is encoded correctly if less compactly.
+std::uint64_t zigzag(std::int64_t v) {
+    return (std::uint64_t(v)<<1)^std::uint64_t(v>>63);
+}
+
+std::int64_t unzigzag(std::uint64_t v) {
+    return std::int64_t(v>>1)^-std::int64_t(v&1);
+}
+} // anonymous namespace
+
+std::vector<char> encode_spikes(const std::vector<spike>& spikes) {
+    std::vector<char> out;
+    out.reserve((2+sizeof(time_type))*spikes.size());
+
+    std::int64_t prev_gid = 0;
+    for (const auto& s: spikes) {
+        const bool has_index = s.source.index!=0;
+        put_varint(zigzag(std::int64_t(s.source.gid)-prev_gid)<<1 | has_index, out);
+        if (has_index) {
+            put_varint(s.source.index, out);
+        }
+        put_raw<time_type>(s.time, out);
+        prev_gid = s.source.gid;
+    }
+    return out;
+}
+
+void decode_spikes(const char* begin, const char* end, std::vector<spike>& out) {
+    const char* p = begin;
+    std::int64_t gid = 0;
+    while (p!=end) {
+        spike s;
+        const auto head = get_varint(p, end);
+        gid += unzigzag(head>>1);
+        s.source.gid = cell_gid_type(gid);
+        s.source.index = (head&1)? cell_lid_type(get_varint(p, end)): 0;
+        s.time = get_raw<time_type>(p, end);
+        out.push_back(s);
+    }
+}
+
+std::vector<spike> decode_spikes(const std::vector<char>& encoded) {
+    std::vector<spike> spikes;
+    decode_spikes(encoded.data(), encoded.data()+encoded.size(), spikes);
+    return spikes;
+}
+
+gathered_vector<spike> decode_spikes(const gathered_vector<char>& encoded) {
+    using count_type = gathered_vector<spike>::count_type;
+
+    const auto& part = encoded.partition();
+    const char* data = encoded.values().data();
+
+    std::vector<spike> spikes;
+    std::vector<count_type> partition;
+    partition.reserve(part.size());
+    partition.push_back(0);
+    for (std::size_t i = 0; i+1<part.size(); ++i) {
+        decode_spikes(data+part[i], data+part[i+1], spikes);
+        partition.push_back(spikes.size());
+    }
+    return gathered_vector<spike>(std::move(spikes), std::move(partition));
+}
+
+} // namespace arb
@@ -0,0 +1,36 @@
+#pragma once
+
+// Compact wire format for spike exchange.
+//
+// Each spike is encoded as a record of:
+//     source gid:   LEB128 varint of the zig-zag encoded difference from the
+//                   gid of the previous spike (or from zero for the first
+//                   spike), shifted left one bit; the low bit is set if the
+//                   source index is non-zero;
+//     source index: LEB128 varint, present only if non-zero;
+//     time:         the bits of the time_type value.
+//
+// When the spikes are sorted by source, as they are by the communicator,
+// a record typically takes 5 bytes in place of the 12 bytes of arb::spike.
+// The encoding is lossless.
+
+#include <vector>
+
+#include <arbor/spike.hpp>
+
+#include "communication/gathered_vector.hpp"
+
+namespace arb {
+
+std::vector<char> encode_spikes(const std::vector<spike>& spikes);
+
+// Append the spikes encoded in [begin, end) to out.
+void decode_spikes(const char* begin, const char* end, std::vector<spike>& out);
+
+std::vector<spike> decode_spikes(const std::vector<char>& encoded);
+
+// Decode the encoded spikes gathered from each domain, preserving the
+// partition by domain.
+gathered_vector<spike> decode_spikes(const gathered_vector<char>& encoded);
+
+} // namespace arb
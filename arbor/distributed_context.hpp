@@ -2,6 +2,9 @@
 
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <arbor/spike.hpp>
 #include <arbor/util/pp_util.hpp>
@@ -30,6 +33,74 @@ namespace arb {
 
 #define ARB_COLLECTIVE_TYPES_ float, double, int, unsigned, long, unsigned long, long long, unsigned long long
 
+// Handle on a non-blocking spike gather, as started by
+// distributed_context::gather_spikes_async.
+//
+// test() makes progress on the gather without waiting for other domains,
+// and returns true once it is complete. finish() waits for the gather to
+// complete and returns the gathered spikes; it must be called exactly once,
+// and the requests of a distributed context must be finished in the order
+// in which they were started, on all domains.
+//
+// Uses the same value-semantic type erasure as distributed_context.
+
+class spike_gather_request {
+public:
+    spike_gather_request() = default;
+
+    template <
+        typename Impl,
+        typename = typename std::enable_if<!std::is_same<typename std::decay<Impl>::type, spike_gather_request>::value>::type
+    >
+    spike_gather_request(Impl&& impl):
+        impl_(new wrap<typename std::decay<Impl>::type>(std::forward<Impl>(impl)))
+    {}
+
+    spike_gather_request(spike_gather_request&& other) = default;
+    spike_gather_request& operator=(spike_gather_request&& other) = default;
+
+    bool test() {
+        return impl_->test();
+    }
+
+    gathered_vector<arb::spike> finish() {
+        return impl_->finish();
+    }
+
+private:
+    struct interface {
+        virtual bool test() = 0;
+        virtual gathered_vector<arb::spike> finish() = 0;
+
+        virtual ~interface() {}
+    };
+
+    template <typename Impl>
+    struct wrap: interface {
+        explicit wrap(const Impl& impl): wrapped(impl) {}
+        explicit wrap(Impl&& impl): wrapped(std::move(impl)) {}
+
+        bool test() override {
+            return wrapped.test();
+        }
+        gathered_vector<arb::spike> finish() override {
+            return wrapped.finish();
+        }
+
+        Impl wrapped;
+    };
+
+    std::unique_ptr<interface> impl_;
+};
+
+// A spike gather that was completed when it was started.
+struct completed_spike_gather {
+    gathered_vector<arb::spike> spikes;
+
+    bool test() { return true; }
+    gathered_vector<arb::spike> finish() { return std::move(spikes); }
+};
+
 // Defines the concept/interface for a distributed communication context.
 //
 // Uses value-semantic type erasure to define the interface, so that
@@ -43,6 +114,8 @@ class distributed_context {
 public:
     using spike_vector = std::vector<arb::spike>;
     using gid_vector = std::vector<cell_gid_type>;
+    using count_vector = std::vector<unsigned>;
+    using cost_vector = std::vector<double>;
 
     // default constructor uses a local context: see below.
     distributed_context();
@@ -59,10 +132,39 @@ public:
         return impl_->gather_spikes(local_spikes);
     }
 
+    // Start a non-blocking gather_spikes; the request takes ownership of local_spikes.
+    spike_gather_request gather_spikes_async(spike_vector local_spikes) const {
+        return impl_->gather_spikes_async(std::move(local_spikes));
+    }
+
+    // As gather_spikes_async, with the spikes sent in the compact wire format
+    // of communication/spike_codec.hpp, which is most compact when the spikes
+    // are sorted by source.
+    spike_gather_request gather_spikes_compressed_async(const spike_vector& local_spikes) const {
+        return impl_->gather_spikes_compressed_async(local_spikes);
+    }
+
     gathered_vector<cell_gid_type> gather_gids(const gid_vector& local_gids) const {
         return impl_->gather_gids(local_gids);
     }
 
+    // Gathered in the same order as gather_gids, so that the costs of cells
+    // can be gathered alongside their gids.
+    gathered_vector<double> gather_cell_costs(const cost_vector& local_costs) const {
+        return impl_->gather_cell_costs(local_costs);
+    }
+
+    // Personalised all-to-all exchange: the values in the subrange
+    // [send_partition[i], send_partition[i+1]) are sent to rank i.
+    // Returns the values received from every rank, partitioned by source rank.
+    gathered_vector<arb::spike> alltoall_spikes(const spike_vector& send_spikes, const count_vector& send_partition) const {
+        return impl_->alltoall_spikes(send_spikes, send_partition);
+    }
+
+    gathered_vector<cell_gid_type> alltoall_gids(const gid_vector& send_gids, const count_vector& send_partition) const {
+        return impl_->alltoall_gids(send_gids, send_partition);
+    }
+
     int id() const {
         return impl_->id();
     }
@@ -89,8 +191,18 @@ private:
     struct interface {
         virtual gathered_vector<arb::spike>
             gather_spikes(const spike_vector& local_spikes) const = 0;
+        virtual spike_gather_request
+            gather_spikes_async(spike_vector local_spikes) const = 0;
+        virtual spike_gather_request
+            gather_spikes_compressed_async(const spike_vector& local_spikes) const = 0;
         virtual gathered_vector<cell_gid_type>
             gather_gids(const gid_vector& local_gids) const = 0;
+        virtual gathered_vector<double>
+            gather_cell_costs(const cost_vector& local_costs) const = 0;
+        virtual gathered_vector<arb::spike>
+            alltoall_spikes(const spike_vector& send_spikes, const count_vector& send_partition) const = 0;
+        virtual gathered_vector<cell_gid_type>
+            alltoall_gids(const gid_vector& send_gids, const count_vector& send_partition) const = 0;
         virtual int id() const = 0;
         virtual int size() const = 0;
         virtual void barrier() const = 0;
@@ -111,10 +223,30 @@ private:
         gather_spikes(const spike_vector& local_spikes) const override {
             return wrapped.gather_spikes(local_spikes);
         }
+        spike_gather_request
+        gather_spikes_async(spike_vector local_spikes) const override {
+            return wrapped.gather_spikes_async(std::move(local_spikes));
+        }
+        spike_gather_request
+        gather_spikes_compressed_async(const spike_vector& local_spikes) const override {
+            return wrapped.gather_spikes_compressed_async(local_spikes);
+        }
         virtual gathered_vector<cell_gid_type>
         gather_gids(const gid_vector& local_gids) const override {
             return wrapped.gather_gids(local_gids);
         }
+        gathered_vector<double>
+        gather_cell_costs(const cost_vector& local_costs) const override {
+            return wrapped.gather_cell_costs(local_costs);
+        }
+        gathered_vector<arb::spike>
+        alltoall_spikes(const spike_vector& send_spikes, const count_vector& send_partition) const override {
+            return wrapped.alltoall_spikes(send_spikes, send_partition);
+        }
+        gathered_vector<cell_gid_type>
+        alltoall_gids(const gid_vector& send_gids, const count_vector& send_partition) const override {
+            return wrapped.alltoall_gids(send_gids, send_partition);
+        }
         int id() const override {
             return wrapped.id();
         }
@@ -149,6 +281,14 @@ struct local_context {
             {0u, static_cast<count_type>(local_spikes.size())}
         );
     }
+    spike_gather_request
+    gather_spikes_async(std::vector<arb::spike> local_spikes) const {
+        return completed_spike_gather{gather_spikes(local_spikes)};
+    }
+    spike_gather_request
+    gather_spikes_compressed_async(const std::vector<arb::spike>& local_spikes) const {
+        return completed_spike_gather{gather_spikes(local_spikes)};
+    }
     gathered_vector<cell_gid_type>
     gather_gids(const std::vector<cell_gid_type>& local_gids) const {
         using count_type = typename gathered_vector<cell_gid_type>::count_type;
@@ -157,6 +297,28 @@ struct local_context {
                 {0u, static_cast<count_type>(local_gids.size())}
         );
     }
+    gathered_vector<double>
+    gather_cell_costs(const std::vector<double>& local_costs) const {
+        using count_type = typename gathered_vector<double>::count_type;
+        return gathered_vector<double>(
+                std::vector<double>(local_costs),
+                {0u, static_cast<count_type>(local_costs.size())}
+        );
+    }
+    gathered_vector<arb::spike>
+    alltoall_spikes(const std::vector<arb::spike>& send_spikes, const std::vector<unsigned>& send_partition) const {
+        return gathered_vector<arb::spike>(
+            std::vector<arb::spike>(send_spikes),
+            std::vector<unsigned>(send_partition)
+        );
+    }
+    gathered_vector<cell_gid_type>
+    alltoall_gids(const std::vector<cell_gid_type>& send_gids, const std::vector<unsigned>& send_partition) const {
+        return gathered_vector<cell_gid_type>(
+            std::vector<cell_gid_type>(send_gids),
+            std::vector<unsigned>(send_partition)
+        );
+    }
 
     int id() const { return 0; }
 
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <arbor/assert.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/spike_event.hpp>
+
+#include "event_calendar.hpp"
+#include "merge_events.hpp"
+
+namespace arb {
+
+void event_calendar::set_intervals(time_type t0, time_type width, std::size_t n_buckets) {
+    arb_assert(width>0);
+
+    pse_vector events;
+    drain(events);
+
+    t0_ = t0;
+    width_ = width;
+    first_ = 0;
+    buckets_.resize(std::max<std::size_t>(n_buckets, 1));
+
+    push(events);
+}
+
+// The interval index is non-decreasing in t, so that all events due before
+// t_to are in the buckets of intervals up to and including interval_index(t_to),
+// regardless of rounding in the calculation of interval boundaries.
+std::size_t event_calendar::interval_index(time_type t) const {
+    if (!(t>t0_)) return 0;
+
+    // Clamp the index of events far in the future (or at infinity).
+    const double max_index = npos/2;
+    return std::min(std::floor(double(t-t0_)/double(width_)), max_index);
+}
+
+void event_calendar::push(const spike_event& e) {
+    // Events due in intervals before the first in the ring are due in the
+    // next call to pop_until: place them in the first bucket.
+    auto i = std::max(interval_index(e.time), first_);
+
+    if (i<first_+buckets_.size()) {
+        bucket(i).push_back(e);
+    }
+    else {
+        overflow_.push_back(e);
+        overflow_first_ = std::min(overflow_first_, i);
+    }
+}
+
+void event_calendar::pop_until(time_type t_to, pse_vector& out) {
+    out.clear();
+
+    const auto last = interval_index(t_to);
+    if (last<first_) {
+        // No interval boundary has been crossed: only the first bucket
+        // can contain events due before t_to.
+        auto& b = bucket(first_);
+        auto mid = std::partition(b.begin(), b.end(), [t_to](auto& e) {return e.time<t_to;});
+        out.assign(b.begin(), mid);
+        b.erase(b.begin(), mid);
+    }
+    else if (last>=first_+buckets_.size()) {
+        // The ring is passed over completely: redistribute all events.
+        pse_vector events;
+        drain(events);
+        first_ = last;
+        for (auto& e: events) {
+            if (e.time<t_to) out.push_back(e);
+            else push(e);
+        }
+    }
+    else {
+        // Take the due events from the buckets of intervals first_ to last.
+        // Events that are not yet due are kept in the bucket of interval last.
+        auto& keep = bucket(last);
+        for (auto i = first_; i<=last; ++i) {
+            auto& b = bucket(i);
+            auto mid = std::partition(b.begin(), b.end(), [t_to](auto& e) {return e.time<t_to;});
+            out.insert(out.end(), b.begin(), mid);
+            if (i==last) {
+                b.erase(b.begin(), mid);
+            }
+            else {
+                keep.insert(keep.end(), mid, b.end());
+                b.clear();
+            }
+        }
+        first_ = last;
+        refill();
+    }
+
+    sort_events(out);
+}
+
+void event_calendar::refill() {
+    const auto end = first_+buckets_.size();
+    if (overflow_first_>=end) return;
+
+    std::size_t next = npos;
+    auto keep = overflow_.begin();
+    for (auto& e: overflow_) {
+        auto i = interval_index(e.time);
+        if (i<end) {
+            bucket(std::max(i, first_)).push_back(e);
+        }
+        else {
+            *keep++ = e;
+            next = std::min(next, i);
+        }
+    }
+    overflow_.erase(keep, overflow_.end());
+    overflow_first_ = next;
+}
+
+void event_calendar::drain(pse_vector& events) {
+    for (auto& b: buckets_) {
+        events.insert(events.end(), b.begin(), b.end());
+        b.clear();
+    }
+    events.insert(events.end(), overflow_.begin(), overflow_.end());
+    overflow_.clear();
+    overflow_first_ = npos;
+}
+
+std::size_t event_calendar::size() const {
+    std::size_t n = overflow_.size();
+    for (auto& b: buckets_) {
+        n += b.size();
+    }
+    return n;
+}
+
+void event_calendar::clear() {
+    for (auto& b: buckets_) {
+        b.clear();
+    }
+    overflow_.clear();
+    overflow_first_ = npos;
+    first_ = 0;
+}
+
+} // namespace arb
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <arbor/common_types.hpp>
+#include <arbor/spike_event.hpp>
+
+namespace arb {
+
+// A calendar queue of the events pending delivery to a cell.
+//
+// Events are held unsorted in buckets, one for each integration interval of
+// a fixed width, so that adding an event has constant cost, and only the
+// events due in an interval are sorted, when they are taken from the queue.
+// The buckets form a ring that spans a fixed number of intervals: events due
+// after the last interval in the ring are kept in an overflow list until the
+// ring advances to cover them.
+
+class event_calendar {
+public:
+    event_calendar() = default;
+
+    // Set the time origin, the width of the intervals and the number of
+    // buckets in the ring. Events already in the queue are redistributed.
+    void set_intervals(time_type t0, time_type width, std::size_t n_buckets);
+
+    void push(const spike_event& e);
+
+    void push(const pse_vector& events) {
+        for (auto& e: events) push(e);
+    }
+
+    // Replace the contents of `out` with the events due before t_to, in the
+    // order given by spike_event::operator<, and remove them from the queue.
+    void pop_until(time_type t_to, pse_vector& out);
+
+    std::size_t size() const;
+
+    bool empty() const {
+        return size()==0;
+    }
+
+    void clear();
+
+private:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    time_type t0_ = 0;
+    time_type width_ = 1;
+
+    // Index of the first interval in the ring.
+    std::size_t first_ = 0;
+    std::vector<pse_vector> buckets_ = std::vector<pse_vector>(1);
+
+    // Events due after the last interval in the ring, and the index of
+    // the earliest interval in which one of these events is due.
+    pse_vector overflow_;
+    std::size_t overflow_first_ = npos;
+
+    std::size_t interval_index(time_type t) const;
+
+    pse_vector& bucket(std::size_t i) {
+        return buckets_[i%buckets_.size()];
+    }
+
+    // Move all events in the queue to `events`.
+    void drain(pse_vector& events);
+
+    // Move events from the overflow list to the buckets of the ring.
+    void refill();
+};
+
+} // namespace arb
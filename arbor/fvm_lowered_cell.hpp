@@ -36,8 +36,8 @@ struct fvm_lowered_cell {
     virtual fvm_integration_result integrate(
         fvm_value_type tfinal,
         fvm_value_type max_dt,
-        std::vector<deliverable_event> staged_events,
-        std::vector<sample_event> staged_samples) = 0;
+        const std::vector<deliverable_event>& staged_events,
+        const std::vector<sample_event>& staged_samples) = 0;
 
     virtual fvm_value_type time() const = 0;
 
@@ -58,8 +58,8 @@ public:
     fvm_integration_result integrate(
         value_type tfinal,
         value_type max_dt,
-        std::vector<deliverable_event> staged_events,
-        std::vector<sample_event> staged_samples) override;
+        const std::vector<deliverable_event>& staged_events,
+        const std::vector<sample_event>& staged_samples) override;
 
     std::vector<fvm_gap_junction> fvm_gap_junctions(
         const std::vector<cable_cell>& cells,
@@ -87,6 +87,8 @@ private:
     using shared_state = typename backend::shared_state;
     using sample_event_stream = typename backend::sample_event_stream;
     using threshold_watcher = typename backend::threshold_watcher;
+    using mechanism_pipeline = typename backend::mechanism_pipeline;
+    using step_controller = typename backend::step_controller;
 
     execution_context context_;
 
@@ -104,6 +106,15 @@ private:
     value_type temperature_ = NAN;
     std::vector<mechanism_ptr> mechanisms_;
 
+    // Schedules the mechanism kernels in each step.
+    mechanism_pipeline mechanism_pipeline_;
+
+    // Chooses the time step of each integration domain.
+    step_controller step_controller_;
+
+    // Number of steps taken by integrate since the last reset.
+    std::size_t num_steps_ = 0;
+
     // Non-physical voltage check threshold, 0 => no check.
     value_type check_voltage_mV = 0;
 
@@ -152,6 +163,8 @@ void fvm_lowered_cell_impl<Backend>::assert_tmin() {
 template <typename Backend>
 void fvm_lowered_cell_impl<Backend>::reset() {
     state_->reset(initial_voltage_, temperature_);
+    step_controller_.reset();
+    num_steps_ = 0;
     set_tmin(0);
 
     for (auto& m: mechanisms_) {
@@ -169,8 +182,8 @@ template <typename Backend>
 fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
     value_type tfinal,
     value_type dt_max,
-    std::vector<deliverable_event> staged_events,
-    std::vector<sample_event> staged_samples)
+    const std::vector<deliverable_event>& staged_events,
+    const std::vector<sample_event>& staged_samples)
 {
     using util::as_const;
 
@@ -186,11 +199,18 @@ fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
         sample_value_ = array(n_samples);
     }
 
-    state_->deliverable_events.init(std::move(staged_events));
-    sample_events_.init(std::move(staged_samples));
+    state_->deliverable_events.init(staged_events);
+    sample_events_.init(staged_samples);
 
     arb_assert((assert_tmin(), true));
     unsigned remaining_steps = dt_steps(tmin_, tfinal, dt_max);
+
+    // With adaptive steps, integration domains reach tfinal after different
+    // numbers of steps, and the mechanism kernels skip tiles of CVs whose
+    // integration domains have all reached it: for the current kernels, the
+    // CVs that were idle in the previous step of this call.
+    const bool skip_idle = step_controller_.adaptive();
+    bool first_step = true;
     PL();
 
     // TODO: Consider devolving more of this to back-end routines (e.g.
@@ -207,20 +227,19 @@ fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
         PE(advance_integrate_current_zero);
         state_->zero_currents();
         PL();
-        for (auto& m: mechanisms_) {
-            m->deliver_events();
-            m->nrn_current();
-        }
+        mechanism_pipeline_.current(skip_idle && !first_step? state_->dt_cv.data(): nullptr);
+        first_step = false;
 
         // Add current contribution from gap_junctions
         state_->add_gj_current();
 
         PE(advance_integrate_events);
+        step_controller_.restart(state_->deliverable_events.marked_events());
         state_->deliverable_events.drop_marked_events();
 
         // Update event list and integration step times.
 
-        state_->update_time_to(dt_max, tfinal);
+        step_controller_.update_time_to(*state_, dt_max, tfinal);
         state_->deliverable_events.event_time_if_before(state_->time_to);
         state_->set_dt();
         PL();
@@ -240,14 +259,13 @@ fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
         PL();
         PE(advance_integrate_matrix_solve);
         matrix_.solve();
+        step_controller_.adapt(*state_, matrix_.solution(), dt_max);
         memory::copy(matrix_.solution(), state_->voltage);
         PL();
 
         // Integrate mechanism state.
 
-        for (auto& m: mechanisms_) {
-            m->nrn_state();
-        }
+        mechanism_pipeline_.state(skip_idle? state_->dt_cv.data(): nullptr);
 
         // Update ion concentrations.
 
@@ -270,10 +288,13 @@ fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
             PL();
         }
 
-        // Check for end of integration.
+        // Check for end of integration. Adaptive steps are longer than
+        // dt_max where they can be, so the remaining steps are recounted
+        // from the time of the slowest integration domain after each step.
 
         PE(advance_integrate_stepsupdate);
-        if (!--remaining_steps) {
+        ++num_steps_;
+        if (!--remaining_steps || skip_idle) {
             tmin_ = state_->time_bounds().first;
             remaining_steps = dt_steps(tmin_, tfinal, dt_max);
         }
@@ -296,9 +317,7 @@ fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
 template <typename B>
 void fvm_lowered_cell_impl<B>::update_ion_state() {
     state_->ions_init_concentration();
-    for (auto& m: mechanisms_) {
-        m->write_ions();
-    }
+    mechanism_pipeline_.write_ions();
     state_->ions_nernst_reversal_potential(temperature_);
 }
 
@@ -380,7 +399,8 @@ void fvm_lowered_cell_impl<B>::initialize(
                    [&cell_to_intdom](index_type i){ return cell_to_intdom[i]; });
 
     arb_assert(D.ncell == ncell);
-    matrix_ = matrix<backend>(D.parent_cv, D.cell_cv_bounds, D.cv_capacitance, D.face_conductance, D.cv_area, cell_to_intdom);
+    matrix_ = matrix<backend>(D.parent_cv, D.cell_cv_bounds, D.cv_capacitance, D.face_conductance, D.cv_area, cell_to_intdom, context_.thread_pool,
+                              global_props.reuse_matrix_factorization);
     sample_events_ = sample_event_stream(num_intdoms);
 
     // Discretize mechanism data.
@@ -470,6 +490,9 @@ void fvm_lowered_cell_impl<B>::initialize(
         mechanisms_.push_back(mechanism_ptr(minst.mech.release()));
     }
 
+    mechanism_pipeline_ = mechanism_pipeline(mechanisms_, D.ncv);
+    step_controller_ = step_controller(*state_, global_props.adaptive_dt_tolerance_mV, global_props.adaptive_dt_max_factor);
+
     // Collect detectors, probe handles.
 
     std::vector<index_type> detector_cv;
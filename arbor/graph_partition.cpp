@@ -0,0 +1,612 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "graph_partition.hpp"
+#include "util/span.hpp"
+
+namespace arb {
+
+using util::make_span;
+
+weighted_graph make_weighted_graph(
+    std::vector<double> vertex_weights,
+    const std::vector<std::pair<unsigned, unsigned>>& edges)
+{
+    weighted_graph g;
+    const auto n = vertex_weights.size();
+    g.vertex_weights = std::move(vertex_weights);
+
+    // Both directions of each edge, sorted by source then target, so that
+    // parallel edges are adjacent.
+    std::vector<std::pair<unsigned, unsigned>> arcs;
+    arcs.reserve(2*edges.size());
+    for (auto& e: edges) {
+        if (e.first!=e.second) {
+            arcs.push_back(e);
+            arcs.push_back({e.second, e.first});
+        }
+    }
+    std::sort(arcs.begin(), arcs.end());
+
+    g.offsets.assign(n+1, 0);
+    for (auto i: make_span(arcs.size())) {
+        if (i && arcs[i]==arcs[i-1]) {
+            g.edge_weights.back() += 1;
+            continue;
+        }
+        g.adjacency.push_back(arcs[i].second);
+        g.edge_weights.push_back(1);
+        ++g.offsets[arcs[i].first+1];
+    }
+    std::partial_sum(g.offsets.begin(), g.offsets.end(), g.offsets.begin());
+
+    return g;
+}
+
+double edge_cut(const weighted_graph& g, const std::vector<unsigned>& part) {
+    double cut = 0;
+    for (auto u: make_span(g.size())) {
+        for (auto j: make_span(g.offsets[u], g.offsets[u+1])) {
+            if (part[u]!=part[g.adjacency[j]]) {
+                cut += g.edge_weights[j];
+            }
+        }
+    }
+    // Each edge is counted from both ends.
+    return cut/2;
+}
+
+namespace {
+
+// Fisher-Yates shuffle with R, which unlike std::shuffle gives the same
+// order with all standard libraries.
+void shuffle(std::vector<unsigned>& v, std::minstd_rand& R) {
+    for (auto i = v.size(); i>1; --i) {
+        std::swap(v[i-1], v[R()%i]);
+    }
+}
+
+// A random permutation of [0, n).
+std::vector<unsigned> random_order(std::size_t n, std::minstd_rand& R) {
+    std::vector<unsigned> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    shuffle(order, R);
+    return order;
+}
+
+// A level of the coarsening: the coarse graph, and the coarse vertex of each
+// vertex of the next finer graph.
+struct coarse_level {
+    weighted_graph graph;
+    std::vector<unsigned> map;
+};
+
+// Contract a heavy edge matching of g: the vertices are visited in random
+// order, and each unmatched vertex is matched with the unmatched neighbour
+// to which it has the heaviest edge, if their summed weight is at most
+// max_vertex_weight.
+coarse_level coarsen(const weighted_graph& g, double max_vertex_weight, std::minstd_rand& R) {
+    constexpr unsigned unmatched = -1;
+    const auto n = g.size();
+    const auto& vw = g.vertex_weights;
+
+    std::vector<unsigned> match(n, unmatched);
+    for (auto u: random_order(n, R)) {
+        if (match[u]!=unmatched) continue;
+
+        unsigned best = u;
+        double best_weight = 0;
+        for (auto j: make_span(g.offsets[u], g.offsets[u+1])) {
+            auto v = g.adjacency[j];
+            if (match[v]==unmatched && g.edge_weights[j]>best_weight && vw[u]+vw[v]<=max_vertex_weight) {
+                best = v;
+                best_weight = g.edge_weights[j];
+            }
+        }
+        match[u] = best;
+        match[best] = u;
+    }
+
+    // Coarse vertices are numbered in the order of the lower of the fine
+    // vertices they contract.
+    coarse_level c;
+    c.map.assign(n, 0);
+    unsigned nc = 0;
+    for (auto u: make_span(n)) {
+        if (match[u]>=u) {
+            c.map[u] = c.map[match[u]] = nc++;
+        }
+    }
+
+    // The edges of coarse vertex cu are accumulated in a row of the
+    // adjacency list; slot[cv] is the position of the edge to cv if it is
+    // in the current row, that is, not before row_begin.
+    constexpr std::size_t no_slot = -1;
+    std::vector<std::size_t> slot(nc, no_slot);
+    auto& cg = c.graph;
+    cg.vertex_weights.assign(nc, 0);
+    cg.offsets.reserve(nc+1);
+    cg.adjacency.reserve(g.adjacency.size());
+    cg.edge_weights.reserve(g.edge_weights.size());
+
+    for (auto u: make_span(n)) {
+        if (match[u]<u) continue;
+
+        auto cu = c.map[u];
+        auto row_begin = cg.adjacency.size();
+        for (unsigned m: {unsigned(u), match[u]}) {
+            cg.vertex_weights[cu] += vw[m];
+            for (auto j: make_span(g.offsets[m], g.offsets[m+1])) {
+                auto cv = c.map[g.adjacency[j]];
+                if (cv==cu) continue;
+                if (slot[cv]==no_slot || slot[cv]<row_begin) {
+                    slot[cv] = cg.adjacency.size();
+                    cg.adjacency.push_back(cv);
+                    cg.edge_weights.push_back(g.edge_weights[j]);
+                }
+                else {
+                    cg.edge_weights[slot[cv]] += g.edge_weights[j];
+                }
+            }
+            if (match[u]==u) break;
+        }
+        cg.offsets.push_back(cg.adjacency.size());
+    }
+
+    return c;
+}
+
+// Balance and cut of a bisection, compared by the weight in excess of the
+// bounds on the sides, then by the cut.
+struct bisection_score {
+    double excess;
+    double cut;
+
+    bool operator<(const bisection_score& other) const {
+        return excess<other.excess || (excess==other.excess && cut<other.cut);
+    }
+};
+
+// A bisection of a graph: side[v] is 0 or 1.
+struct bisection {
+    const weighted_graph& g;
+    double max_weight[2];
+
+    std::vector<unsigned> side;
+    double weight[2] = {0, 0};
+    double cut = 0;
+
+    bisection(const weighted_graph& g, double max0, double max1):
+        g(g), max_weight{max0, max1}
+    {}
+
+    void assign(std::vector<unsigned> s) {
+        side = std::move(s);
+        weight[0] = weight[1] = 0;
+        for (auto v: make_span(g.size())) {
+            weight[side[v]] += g.vertex_weights[v];
+        }
+        cut = edge_cut(g, side);
+    }
+
+    bisection_score score() const {
+        return {std::max(0., weight[0]-max_weight[0])+std::max(0., weight[1]-max_weight[1]), cut};
+    }
+
+    // Whether v has a neighbour on the other side.
+    bool is_boundary(unsigned v) const {
+        for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+            if (side[g.adjacency[j]]!=side[v]) return true;
+        }
+        return false;
+    }
+
+    // The decrease of the cut if v changes side.
+    double gain(unsigned v) const {
+        double gain = 0;
+        for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+            gain += side[g.adjacency[j]]==side[v]? -g.edge_weights[j]: g.edge_weights[j];
+        }
+        return gain;
+    }
+};
+
+// Grow side 0 of a bisection from seed, adding in turn the vertex that most
+// decreases the cut, until side 0 has weight target0. A new seed is taken
+// in random order when the component of the seed is exhausted.
+std::vector<unsigned> grow_bisection(const weighted_graph& g, double target0, unsigned seed, std::minstd_rand& R) {
+    const auto n = g.size();
+    std::vector<unsigned> side(n, 1);
+    std::vector<double> gain(n);
+    for (auto v: make_span(n)) {
+        gain[v] = 0;
+        for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+            gain[v] -= g.edge_weights[j];
+        }
+    }
+
+    // Heap of (gain, vertex) of the vertices on side 1, with stale entries
+    // skipped when popped.
+    std::priority_queue<std::pair<double, unsigned>> heap;
+    heap.push({gain[seed], seed});
+
+    const auto seeds = random_order(n, R);
+    std::size_t next_seed = 0;
+    double weight0 = 0;
+
+    for (;;) {
+        while (!heap.empty() && (side[heap.top().second]==0 || heap.top().first!=gain[heap.top().second])) {
+            heap.pop();
+        }
+        if (heap.empty()) {
+            while (next_seed<n && side[seeds[next_seed]]==0) ++next_seed;
+            if (next_seed==n) break;
+            heap.push({gain[seeds[next_seed]], seeds[next_seed]});
+            continue;
+        }
+
+        auto v = heap.top().second;
+        if (weight0+g.vertex_weights[v]/2>target0) break;
+        heap.pop();
+
+        side[v] = 0;
+        weight0 += g.vertex_weights[v];
+        for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+            auto u = g.adjacency[j];
+            if (side[u]) {
+                gain[u] += 2*g.edge_weights[j];
+                heap.push({gain[u], u});
+            }
+        }
+    }
+    return side;
+}
+
+// Fiduccia-Mattheyses refinement: in each pass, the vertex with the
+// highest gain that keeps its destination side within bounds changes side,
+// and is locked for the rest of the pass, even if the cut increases. The
+// pass stops after a number of moves without improvement, and the moves
+// after the best bisection seen in the pass are undone.
+void fm_refine(bisection& b) {
+    constexpr unsigned max_passes = 8;
+    const auto& g = b.g;
+    const auto n = g.size();
+    const std::size_t max_idle_moves = 50+n/100;
+
+    std::vector<double> gain(n);
+    std::vector<char> locked(n);
+    std::vector<unsigned> moves;
+
+    for (unsigned pass = 0; pass<max_passes; ++pass) {
+        // A heap of (gain, vertex) for the vertices of each side, with stale
+        // entries skipped when popped. Interior vertices are added when a
+        // neighbour changes side.
+        std::priority_queue<std::pair<double, unsigned>> heap[2];
+        for (auto v: make_span(n)) {
+            gain[v] = b.gain(v);
+            locked[v] = 0;
+            if (b.is_boundary(v)) {
+                heap[b.side[v]].push({gain[v], v});
+            }
+        }
+
+        auto top = [&](unsigned s) -> long {
+            auto& h = heap[s];
+            while (!h.empty() && (locked[h.top().second] || h.top().first!=gain[h.top().second])) {
+                h.pop();
+            }
+            return h.empty()? -1: long(h.top().second);
+        };
+
+        auto best = b.score();
+        std::size_t best_moves = 0;
+        moves.clear();
+
+        while (moves.size()-best_moves<max_idle_moves) {
+            // Candidate moves from each side; the move from the heavier side
+            // is preferred when its gain is equal.
+            long v = -1;
+            for (unsigned s: {0u, 1u}) {
+                auto u = top(s);
+                if (u<0) continue;
+                auto w = g.vertex_weights[u];
+                bool fits = b.weight[1-s]+w<=b.max_weight[1-s] || b.weight[1-s]+w<b.weight[s];
+                if (fits && (v<0 || gain[u]>gain[v] || (gain[u]==gain[v] && b.weight[s]>b.weight[1-s]))) {
+                    v = u;
+                }
+            }
+            if (v<0) break;
+
+            auto from = b.side[v], to = 1-from;
+            heap[from].pop();
+            locked[v] = 1;
+            b.side[v] = to;
+            b.weight[from] -= g.vertex_weights[v];
+            b.weight[to] += g.vertex_weights[v];
+            b.cut -= gain[v];
+            moves.push_back(v);
+
+            for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+                auto u = g.adjacency[j];
+                if (locked[u]) continue;
+                gain[u] += b.side[u]==to? -2*g.edge_weights[j]: 2*g.edge_weights[j];
+                heap[b.side[u]].push({gain[u], u});
+            }
+
+            if (b.score()<best) {
+                best = b.score();
+                best_moves = moves.size();
+            }
+        }
+
+        for (auto i = moves.size(); i>best_moves; --i) {
+            auto v = moves[i-1];
+            auto from = b.side[v], to = 1-from;
+            b.side[v] = to;
+            b.weight[from] -= g.vertex_weights[v];
+            b.weight[to] += g.vertex_weights[v];
+        }
+        b.cut = best.cut;
+
+        if (!best_moves) break;
+    }
+}
+
+double max_vertex_weight(const weighted_graph& g) {
+    auto& w = g.vertex_weights;
+    return w.empty()? 0: *std::max_element(w.begin(), w.end());
+}
+
+// Bisect g into sides of weight about target0 and the rest. The graph is
+// coarsened, the coarsest graph is bisected by growing side 0 from a few
+// random seeds and refining, and the best of these is projected back
+// through the levels with refinement at each.
+std::vector<unsigned> multilevel_bisection(const weighted_graph& g, double target0, double imbalance, std::minstd_rand& R) {
+    constexpr unsigned n_trials = 4;
+    constexpr std::size_t coarse_size = 100;
+
+    const auto& vw = g.vertex_weights;
+    const double total = std::accumulate(vw.begin(), vw.end(), 0.);
+    const double target[2] = {target0, total-target0};
+
+    auto make_bisection = [&](const weighted_graph& level) {
+        double max_vw = max_vertex_weight(level);
+        auto bound = [&](double t) { return std::max(t*(1+imbalance), t+max_vw); };
+        return bisection(level, bound(target[0]), bound(target[1]));
+    };
+
+    std::vector<coarse_level> levels;
+    auto graph_at = [&](std::size_t i) -> const weighted_graph& {
+        return i? levels[i-1].graph: g;
+    };
+
+    while (graph_at(levels.size()).size()>coarse_size) {
+        const auto& fine = graph_at(levels.size());
+        auto c = coarsen(fine, 1.5*total/coarse_size, R);
+        if (c.graph.size()>0.95*fine.size()) break;
+        levels.push_back(std::move(c));
+    }
+
+    const auto& coarsest = graph_at(levels.size());
+    auto best = make_bisection(coarsest);
+    for (unsigned trial = 0; trial<n_trials; ++trial) {
+        auto b = make_bisection(coarsest);
+        b.assign(grow_bisection(coarsest, target0, R()%coarsest.size(), R));
+        fm_refine(b);
+        if (!trial || b.score()<best.score()) {
+            best.assign(std::move(b.side));
+        }
+    }
+    auto side = std::move(best.side);
+
+    for (auto i = levels.size(); i>0; --i) {
+        const auto& map = levels[i-1].map;
+        std::vector<unsigned> fine_side(map.size());
+        for (auto v: make_span(map.size())) {
+            fine_side[v] = side[map[v]];
+        }
+        auto b = make_bisection(graph_at(i-1));
+        b.assign(std::move(fine_side));
+        fm_refine(b);
+        side = std::move(b.side);
+    }
+    return side;
+}
+
+// The subgraph of g induced by the vertices on side s, and the vertex of g
+// of each of its vertices.
+std::pair<weighted_graph, std::vector<unsigned>> induced_subgraph(const weighted_graph& g, const std::vector<unsigned>& side, unsigned s) {
+    std::vector<unsigned> index(g.size());
+    std::vector<unsigned> vertices;
+    for (auto v: make_span(g.size())) {
+        if (side[v]==s) {
+            index[v] = vertices.size();
+            vertices.push_back(v);
+        }
+    }
+
+    weighted_graph sub;
+    sub.offsets.reserve(vertices.size()+1);
+    for (auto v: vertices) {
+        sub.vertex_weights.push_back(g.vertex_weights[v]);
+        for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+            auto u = g.adjacency[j];
+            if (side[u]==s) {
+                sub.adjacency.push_back(index[u]);
+                sub.edge_weights.push_back(g.edge_weights[j]);
+            }
+        }
+        sub.offsets.push_back(sub.adjacency.size());
+    }
+    return {std::move(sub), std::move(vertices)};
+}
+
+// Assign the vertices of g, which are the vertices ids of the graph being
+// partitioned, to parts [first, first+num_parts) by recursive bisection.
+void recursive_bisection(
+    const weighted_graph& g, const std::vector<unsigned>& ids, unsigned first, unsigned num_parts,
+    double imbalance, std::vector<unsigned>& part, std::minstd_rand& R)
+{
+    if (num_parts==1 || g.size()<=1) {
+        for (auto v: ids) part[v] = first;
+        return;
+    }
+
+    const auto& vw = g.vertex_weights;
+    unsigned k0 = num_parts/2;
+    double target0 = std::accumulate(vw.begin(), vw.end(), 0.)*k0/num_parts;
+    auto side = multilevel_bisection(g, target0, imbalance, R);
+
+    for (unsigned s: {0u, 1u}) {
+        auto sub = induced_subgraph(g, side, s);
+        std::vector<unsigned> sub_ids;
+        sub_ids.reserve(sub.second.size());
+        for (auto v: sub.second) {
+            sub_ids.push_back(ids[v]);
+        }
+        recursive_bisection(sub.first, sub_ids, s? first+k0: first, s? num_parts-k0: k0, imbalance, part, R);
+    }
+}
+
+std::vector<double> part_weights(const weighted_graph& g, const std::vector<unsigned>& part, unsigned num_parts) {
+    std::vector<double> w(num_parts, 0);
+    for (auto v: make_span(g.size())) {
+        w[part[v]] += g.vertex_weights[v];
+    }
+    return w;
+}
+
+// Greedy boundary refinement: in each pass, the vertices with neighbours in
+// other parts are visited in random order, and each is moved to the adjacent part to which it has the most edge weight if
+// that reduces the cut, or keeps the cut and evens the part weights, without
+// making the part heavier than max_part_weight. A vertex in a part heavier
+// than max_part_weight is moved to the adjacent part to which it has the most
+// edge weight among those that stay lighter than its part.
+void refine(
+    const weighted_graph& g, double max_part_weight,
+    std::vector<unsigned>& part, std::vector<double>& pw, std::minstd_rand& R)
+{
+    constexpr unsigned max_passes = 8;
+
+    // Edge weight from the current vertex to each part, and the parts with
+    // non-zero entries.
+    std::vector<double> conn(pw.size(), 0);
+    std::vector<unsigned> adjacent;
+    std::vector<unsigned> boundary;
+
+    for (unsigned pass = 0; pass<max_passes; ++pass) {
+        boundary.clear();
+        for (auto v: make_span(g.size())) {
+            for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+                if (part[g.adjacency[j]]!=part[v]) {
+                    boundary.push_back(v);
+                    break;
+                }
+            }
+        }
+        shuffle(boundary, R);
+
+        bool moved = false;
+        for (auto v: boundary) {
+            auto a = part[v];
+            auto w = g.vertex_weights[v];
+
+            adjacent.clear();
+            for (auto j: make_span(g.offsets[v], g.offsets[v+1])) {
+                auto p = part[g.adjacency[j]];
+                if (conn[p]==0) adjacent.push_back(p);
+                conn[p] += g.edge_weights[j];
+            }
+
+            bool heavy = pw[a]>max_part_weight;
+            unsigned best = a;
+            double best_gain = 0;
+            for (auto b: adjacent) {
+                if (b==a) continue;
+                double gain = conn[b]-conn[a];
+                double wb = pw[b]+w;
+                bool ok = heavy?
+                    wb<pw[a]:
+                    wb<=max_part_weight && (gain>0 || (gain==0 && wb<pw[a]));
+                if (ok && (best==a || gain>best_gain || (gain==best_gain && pw[b]<pw[best]))) {
+                    best = b;
+                    best_gain = gain;
+                }
+            }
+
+            for (auto p: adjacent) conn[p] = 0;
+
+            if (best!=a) {
+                part[v] = best;
+                pw[a] -= w;
+                pw[best] += w;
+                moved = true;
+            }
+        }
+        if (!moved) break;
+    }
+}
+
+// Move vertices out of parts heavier than max_part_weight, which have no
+// neighbours in lighter parts, to the lightest part.
+void balance(
+    const weighted_graph& g, double max_part_weight,
+    std::vector<unsigned>& part, std::vector<double>& pw)
+{
+    auto lightest = std::min_element(pw.begin(), pw.end())-pw.begin();
+    for (auto v: make_span(g.size())) {
+        auto a = part[v];
+        auto w = g.vertex_weights[v];
+        if (pw[a]>max_part_weight && pw[lightest]+w<pw[a]) {
+            part[v] = lightest;
+            pw[a] -= w;
+            pw[lightest] += w;
+            lightest = std::min_element(pw.begin(), pw.end())-pw.begin();
+        }
+    }
+}
+
+} // anonymous namespace
+
+std::vector<unsigned> partition_graph(const weighted_graph& g, unsigned num_parts, double imbalance) {
+    const auto n = g.size();
+    if (num_parts<=1 || n==0) {
+        return std::vector<unsigned>(n, 0);
+    }
+
+    // Fixed seed, so that all domains compute the same partition.
+    std::minstd_rand R;
+
+    // The imbalance of each level of bisection compounds.
+    unsigned depth = 0;
+    while ((1u<<depth)<num_parts) ++depth;
+    double bisection_imbalance = std::pow(1+imbalance, 1./depth)-1;
+
+    std::vector<unsigned> part(n);
+    std::vector<unsigned> ids(n);
+    std::iota(ids.begin(), ids.end(), 0u);
+    recursive_bisection(g, ids, 0, num_parts, bisection_imbalance, part, R);
+
+    // Refine the partition as a whole, which also corrects the balance of
+    // parts made heavy by the bisections.
+    const auto& vw = g.vertex_weights;
+    const double mean_part_weight = std::accumulate(vw.begin(), vw.end(), 0.)/num_parts;
+    const double max_part_weight = std::max(mean_part_weight*(1+imbalance), mean_part_weight+max_vertex_weight(g));
+
+    auto pw = part_weights(g, part, num_parts);
+    refine(g, max_part_weight, part, pw, R);
+    if (*std::max_element(pw.begin(), pw.end())>max_part_weight) {
+        balance(g, max_part_weight, part, pw);
+        refine(g, max_part_weight, part, pw, R);
+    }
+
+    return part;
+}
+
+} // namespace arb
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Partitioning of weighted undirected graphs into parts of about equal
+// weight with few edges between parts, for the placement of cells on
+// domains by their connectivity.
+
+namespace arb {
+
+// An undirected graph in compressed sparse row form: the neighbours of
+// vertex i are adjacency[offsets[i]] to adjacency[offsets[i+1]-1], with the
+// weights of the edges in edge_weights. Each edge is listed from both of its
+// ends, with the same weight, and there are no self loops.
+struct weighted_graph {
+    std::vector<std::size_t> offsets = {0};
+    std::vector<unsigned> adjacency;
+    std::vector<double> edge_weights;
+    std::vector<double> vertex_weights;
+
+    std::size_t size() const { return vertex_weights.size(); }
+};
+
+// The graph with vertices of weight vertex_weights and an edge of weight one
+// for each (u, v) pair in edges; parallel edges are merged into one edge of
+// summed weight, and self loops are dropped.
+weighted_graph make_weighted_graph(
+    std::vector<double> vertex_weights,
+    const std::vector<std::pair<unsigned, unsigned>>& edges);
+
+// The total weight of the edges between vertices in different parts.
+double edge_cut(const weighted_graph& g, const std::vector<unsigned>& part);
+
+// Partition the vertices of g into num_parts parts, returning the part of
+// each vertex.
+//
+// Multilevel recursive bisection: each bisection coarsens the graph by
+// contracting heavy edge matchings, bisects the coarsest graph by greedy
+// growing from a few seeds, and projects the best bisection back through
+// the levels with Fiduccia-Mattheyses refinement at each. The resulting
+// partition is refined greedily as a whole.
+//
+// The weight of each part is at most (1+imbalance) times the mean part
+// weight, or the mean part weight plus the heaviest vertex weight if that is
+// more. The result depends only on the arguments.
+std::vector<unsigned> partition_graph(const weighted_graph& g, unsigned num_parts, double imbalance = 0.03);
+
+} // namespace arb
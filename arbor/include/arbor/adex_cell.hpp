@@ -0,0 +1,28 @@
+#pragma once
+
+namespace arb {
+
+// Model parameters of the adaptive exponential integrate and fire neuron
+// model (Brette and Gerstner 2005).
+//
+// An event of weight w increments the membrane potential by w/C_m, as for
+// lif_cell. The state of the cell can not be sampled.
+struct adex_cell {
+    // Neuronal parameters.
+    double C_m = 281;       // Membrane capacitance [pF].
+    double g_L = 30;        // Leak conductance [nS].
+    double E_L = -70.6;     // Resting potential [mV].
+    double V_T = -50.4;     // Threshold of the exponential term [mV].
+    double delta_T = 2;     // Slope factor of the exponential term, positive [mV].
+    double V_peak = 0;      // Firing threshold [mV].
+    double V_reset = -60;   // Reset potential [mV].
+    double t_ref = 0;       // Refractory period [ms].
+    double a = 4;           // Subthreshold adaptation conductance [nS].
+    double b = 80.5;        // Spike-triggered adaptation current [pA].
+    double tau_w = 144;     // Adaptation time constant [ms].
+    double I_e = 0;         // Constant external current [pA].
+    double V_m = E_L;       // Initial value of the membrane potential [mV].
+    double w = 0;           // Initial value of the adaptation current [pA].
+};
+
+} // namespace arb
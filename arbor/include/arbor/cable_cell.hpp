@@ -73,6 +73,20 @@ struct cable_cell_global_properties {
     // during integration.
     double membrane_voltage_limit_mV = 0;
 
+    // If true, reuse the factorization of the matrix of a cell between
+    // steps while its diagonal, that is dt and the membrane conductance,
+    // is unchanged to within a small relative tolerance. Where supported
+    // by the back end; the solution may differ from a full solve by the
+    // effect of this tolerance.
+    bool reuse_matrix_factorization = false;
+
+    // If >0, integrate each integration domain with adaptive time steps
+    // of between dt and adaptive_dt_max_factor*dt, with the local error of
+    // the membrane voltage in a step controlled to this tolerance. Where
+    // supported by the back end; otherwise steps are of fixed length dt.
+    double adaptive_dt_tolerance_mV = 0;
+    double adaptive_dt_max_factor = 8;
+
     // TODO: consider making some/all of the following parameters
     // cell or even segment-local.
     // 
@@ -79,6 +79,8 @@ enum class cell_kind {
     lif,       // Leaky-integrate and fire neuron.
     spike_source,     // Cell that generates spikes at a user-supplied sequence of time points.
     benchmark,        // Proxy cell used for benchmarking.
+    adex,             // Adaptive exponential integrate and fire neuron.
+    izhikevich,       // Izhikevich neuron.
 };
 
 // Enumeration for event time binning policy.
@@ -89,6 +91,13 @@ enum class binning_kind {
     following, // => round times down to previous event if within binning interval.
 };
 
+// Enumeration for the exchange of spikes between domains.
+
+enum class spike_exchange_kind {
+    all_gather, // => every domain receives every spike.
+    sparse,     // => each domain receives only spikes from the sources of its connections.
+};
+
 std::ostream& operator<<(std::ostream& o, cell_member_type m);
 std::ostream& operator<<(std::ostream& o, cell_kind k);
 std::ostream& operator<<(std::ostream& o, backend_kind k);
@@ -0,0 +1,22 @@
+#pragma once
+
+namespace arb {
+
+// Model parameters of the Izhikevich neuron model (Izhikevich 2003).
+// The defaults describe a regular spiking neuron.
+//
+// An event of weight w increments the membrane potential by w [mV].
+// The state of the cell can not be sampled.
+struct izhikevich_cell {
+    // Neuronal parameters.
+    double a = 0.02;        // Time scale of the recovery variable [1/ms].
+    double b = 0.2;         // Sensitivity of the recovery variable to the membrane potential [1/ms].
+    double c = -65;         // Reset potential [mV].
+    double d = 8;           // Increment of the recovery variable after a spike [mV/ms].
+    double V_peak = 30;     // Firing threshold [mV].
+    double I_e = 0;         // Constant external input [mV/ms].
+    double V_m = -65;       // Initial value of the membrane potential [mV].
+    double u = b*V_m;       // Initial value of the recovery variable [mV/ms].
+};
+
+} // namespace arb
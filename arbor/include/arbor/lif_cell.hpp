@@ -14,4 +14,8 @@ struct lif_cell {
     double t_ref = 2;     // Refractory period [ms].
 };
 
+// Probe address of the membrane potential of a LIF cell, as returned by
+// recipe::get_probe(); samples are of type const double*.
+struct lif_probe_voltage {};
+
 } // namespace arb
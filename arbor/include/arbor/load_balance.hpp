@@ -1,5 +1,9 @@
 #pragma once
 
+#include <functional>
+#include <limits>
+#include <unordered_map>
+
 #include <arbor/context.hpp>
 #include <arbor/domain_decomposition.hpp>
 #include <arbor/recipe.hpp>
@@ -8,17 +12,78 @@ namespace arb {
 
 struct partition_hint {
     constexpr static std::size_t max_size = -1;
+    constexpr static double max_cost = std::numeric_limits<double>::max();
 
     std::size_t cpu_group_size = 1;
     std::size_t gpu_group_size = max_size;
     bool prefer_gpu = true;
+
+    // A multicore cell group is also closed once the summed cost of its
+    // cells reaches cpu_group_cost, so that groups of costly cells are
+    // smaller.
+    double cpu_group_cost = max_cost;
 };
 
 using partition_hint_map = std::unordered_map<cell_kind, partition_hint>;
 
+// Estimated cost of advancing cell gid relative to other cells; must be
+// non-negative, and the same on all domains. The load balancers call it on
+// each domain for a share of about num_cells/num_domains gids, and gather
+// the costs on all domains only if they are not all equal.
+using cell_cost_function = std::function<double (cell_gid_type)>;
+
+// The gids are split into contiguous ranges, one per domain, of about
+// equal cost, by the costs given by recipe::get_cell_cost(). When all
+// cells have the same cost, the first num_cells%num_domains domains take
+// one cell more than the others. Within a domain, cells are grouped by kind
+// as described by the hints.
+domain_decomposition partition_load_balance(
+    const recipe& rec,
+    const context& ctx,
+    partition_hint_map hint_map = {});
+
+// As above, with the costs given by cell_cost.
 domain_decomposition partition_load_balance(
     const recipe& rec,
     const context& ctx,
+    const cell_cost_function& cell_cost,
     partition_hint_map hint_map = {});
 
+// The cells are partitioned over the domains by their connectivity, given
+// by recipe::connections_on(), so that few connections are between cells
+// on different domains, and thus few spikes need to be sent between
+// domains. The summed cell costs of each domain are at most 3% above the
+// mean, or the cost of the costliest cell above the mean if that is more;
+// there is no lower bound, and a domain may have few or no cells.
+// Cells connected by gap junctions are on the same domain. Within a domain,
+// cells are grouped by kind as described by the hints.
+//
+// Every domain builds the connectivity graph of the whole model from the
+// recipe, and computes the same partition by a multilevel graph
+// partitioning algorithm.
+domain_decomposition partition_graph_load_balance(
+    const recipe& rec,
+    const context& ctx,
+    partition_hint_map hint_map = {});
+
+// As above, with the costs given by cell_cost.
+domain_decomposition partition_graph_load_balance(
+    const recipe& rec,
+    const context& ctx,
+    const cell_cost_function& cell_cost,
+    partition_hint_map hint_map = {});
+
+// Cell costs by the number of control volumes of cable cells after
+// discretization, and one for cells of other kinds. The cable cell
+// descriptions are built by the recipe, once per call.
+cell_cost_function cv_count_cell_cost(const recipe& rec);
+
+// The cell costs measured on all domains, given the costs of the local
+// cells of each domain, such as those of simulation::cell_costs(). Cells
+// without a measured cost take the mean measured cost, or one if there is
+// none. Collective: must be called on all domains.
+cell_cost_function gather_cell_costs(
+    const context& ctx,
+    const std::unordered_map<cell_gid_type, double>& local_costs);
+
 } // namespace arb
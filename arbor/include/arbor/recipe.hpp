@@ -64,6 +64,11 @@ public:
     virtual util::unique_any get_cell_description(cell_gid_type gid) const = 0;
     virtual cell_kind get_cell_kind(cell_gid_type) const = 0;
 
+    // Estimated cost of advancing the cell relative to other cells, used
+    // by partition_load_balance to balance the load of domains. Must be
+    // non-negative.
+    virtual double get_cell_cost(cell_gid_type) const { return 1; }
+
     virtual cell_size_type num_sources(cell_gid_type) const { return 0; }
     virtual cell_size_type num_targets(cell_gid_type) const { return 0; }
     virtual cell_size_type num_probes(cell_gid_type)  const { return 0; }
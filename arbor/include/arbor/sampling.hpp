@@ -4,6 +4,7 @@
 #include <functional>
 
 #include <arbor/common_types.hpp>
+#include <arbor/fvm_types.hpp>
 #include <arbor/util/any_ptr.hpp>
 
 namespace arb {
@@ -23,6 +24,23 @@ struct sample_record {
 
 using sampler_function = std::function<void (cell_member_type, probe_tag, std::size_t, const sample_record*)>;
 
+// The samples taken in one integration period by a cell group for all the
+// probes of a bulk sampler association on the group, in columnar layout:
+// sample j of probe probe_ids[i] was taken at time[i*n_samples+j] with
+// value value[i*n_samples+j]. The arrays are valid only for the duration
+// of the call to the bulk sampler.
+
+struct sample_block {
+    std::size_t n_probes;
+    std::size_t n_samples;  // Number of samples per probe.
+    const cell_member_type* probe_ids;
+    const probe_tag* tags;
+    const fvm_value_type* time;
+    const fvm_value_type* value;
+};
+
+using bulk_sampler_function = std::function<void (const sample_block&)>;
+
 using sampler_association_handle = std::size_t;
 
 enum class sampling_policy {
@@ -150,6 +150,10 @@ struct avx_int4: implbase<avx_int4> {
         return _mm_cmpeq_epi32(b, ones);
     }
 
+    static unsigned long long mask_pack(const __m128i& m) {
+        return _mm_movemask_ps(_mm_castsi128_ps(m));
+    }
+
     static bool mask_element(const __m128i& u, int i) {
         return static_cast<bool>(element(u, i));
     }
@@ -328,6 +332,10 @@ struct avx_double4: implbase<avx_double4> {
         return _mm256_castsi256_pd(combine_m128i(bu, bl));
     }
 
+    static unsigned long long mask_pack(const __m256d& m) {
+        return _mm256_movemask_pd(m);
+    }
+
     static void mask_set_element(__m256d& u, int i, bool b) {
         char data[256];
         _mm256_storeu_pd((double*)data, u);
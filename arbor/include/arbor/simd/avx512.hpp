@@ -185,6 +185,10 @@ struct avx512_mask8: implbase<avx512_mask8> {
         return _mm512_int2mask(p);
     }
 
+    static unsigned long long mask_pack(const __mmask8& k) {
+        return _mm512_mask2int(k)&0xff;
+    }
+
     static bool mask_element(const __mmask8& u, int i) {
         return element(u, i);
     }
@@ -379,6 +379,17 @@ struct implbase {
         return I::mask_copy_from(m);
     }
 
+    static unsigned long long mask_pack(const vector_type& v) {
+        mask_store m;
+        I::mask_copy_to(v, m);
+
+        unsigned long long k = 0;
+        for (unsigned i = 0; i<width; ++i) {
+            k |= (unsigned long long)m[i]<<i;
+        }
+        return k;
+    }
+
     template <typename ImplIndex>
     static vector_type gather(tag<ImplIndex>, const scalar_type* p, const typename ImplIndex::vector_type& index) {
         typename ImplIndex::scalar_type o[width];
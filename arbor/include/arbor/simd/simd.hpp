@@ -570,6 +570,12 @@ namespace detail {
             return simd_mask_impl::wrap(Impl::mask_unpack(bits));
         }
 
+        // Make integer from mask bits; zero if no lane is set.
+
+        unsigned long long pack() const {
+            return Impl::mask_pack(value_);
+        }
+
     private:
         simd_mask_impl(const vector_type& v): base(v) {}
 
@@ -35,15 +35,41 @@ public:
     sampler_association_handle add_sampler(cell_member_predicate probe_ids,
         schedule sched, sampler_function f, sampling_policy policy = sampling_policy::lax);
 
+    // As add_sampler, with one call per cell group and integration period
+    // for the samples of all of the probes on the group.
+    sampler_association_handle add_bulk_sampler(cell_member_predicate probe_ids,
+        schedule sched, bulk_sampler_function f, sampling_policy policy = sampling_policy::lax);
+
     void remove_sampler(sampler_association_handle);
 
     void remove_all_samplers();
 
     std::size_t num_spikes() const;
 
+    // The measured cost of each local cell, by gid: the wall time in
+    // seconds spent advancing its cell group in calls to run since
+    // construction or the last reset, divided evenly among the cells of the
+    // group. For use as a cell_cost_function in partition_load_balance for
+    // a later run, once shared between domains by gather_cell_costs.
+    std::unordered_map<cell_gid_type, double> cell_costs() const;
+
     // Set event binning policy on all our groups.
     void set_binning_policy(binning_kind policy, time_type bin_interval);
 
+    // Select how spikes are exchanged between domains.
+    // Collective: must be called with the same argument on all domains.
+    void set_spike_exchange(spike_exchange_kind kind);
+
+    // Set the maximum number of spike exchanges that may be in flight at
+    // once (default 1). Collective: must be called with the same argument
+    // on all domains.
+    void set_exchange_pipeline_depth(unsigned depth);
+
+    // Select whether spikes are sent in a compact, lossless format for
+    // all-gather exchange.
+    // Collective: must be called with the same argument on all domains.
+    void set_spike_compression(bool compress);
+
     // Register a callback that will perform a export of the global
     // spike vector.
     void set_global_spike_callback(spike_export_function = spike_export_function{});
@@ -52,6 +78,14 @@ public:
     // spike vector.
     void set_local_spike_callback(spike_export_function = spike_export_function{});
 
+    // Call the spike callbacks on a dedicated thread, so that they overlap
+    // with integration and spike exchange, with at most max_spikes spikes
+    // buffered for export: when the buffer is full, the simulation waits
+    // for the callbacks. With max_spikes zero (the default) the callbacks
+    // are called synchronously during spike exchange. In either case, all
+    // callbacks have returned when run returns.
+    void set_async_spike_export(std::size_t max_spikes);
+
     // Add events directly to targets.
     // Must be called before calling simulation::run, and must contain events that
     // are to be delivered at or after the current simulation time.
@@ -0,0 +1,39 @@
+#pragma once
+
+/*
+ * Binary spike files.
+ *
+ * The layout, in native byte order, is a header of magic "ARBSPIKE"
+ * (8 bytes), format version (uint32) and padding (4 bytes), followed by
+ * one record per spike: source gid (uint32), source index (uint32) and
+ * spike time (float, ms).
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arbor/spike.hpp>
+
+namespace arb {
+
+// Appends spikes to a spike file. Models spike_export_function, for use
+// with simulation::set_global_spike_callback or set_local_spike_callback;
+// copies share the open file, which is closed with the last copy.
+
+class spike_file_writer {
+public:
+    explicit spike_file_writer(const std::string& path);
+
+    void operator()(const std::vector<spike>& spikes);
+
+    void flush();
+
+private:
+    struct impl;
+    std::shared_ptr<impl> impl_;
+};
+
+std::vector<spike> read_spike_file(const std::string& path);
+
+} // namespace arb
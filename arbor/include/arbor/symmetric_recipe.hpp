@@ -39,6 +39,10 @@ public:
         return tiled_recipe_->get_cell_kind(i % tiled_recipe_->num_cells());
     }
 
+    double get_cell_cost(cell_gid_type i) const override {
+        return tiled_recipe_->get_cell_cost(i % tiled_recipe_->num_cells());
+    }
+
     cell_size_type num_sources(cell_gid_type i) const override {
         return tiled_recipe_->num_sources(i % tiled_recipe_->num_cells());
     }
@@ -0,0 +1,99 @@
+#pragma once
+
+/*
+ * Columnar binary trace files for scalar probe samples.
+ *
+ * A trace file is preallocated for a fixed set of probes and a fixed
+ * capacity of samples per probe, and is written and read through a memory
+ * mapping. The layout, in native byte order, is:
+ *
+ *   header: magic "ARBTRACE" (8 bytes), format version (uint32),
+ *           number of probes (uint32), capacity in samples per probe (uint64)
+ *
+ *   index:  per probe, probe gid (uint32), probe index (uint32), probe tag
+ *           (int32), padding (4 bytes), number of samples written (uint64),
+ *           byte offset of the probe chunk (uint64)
+ *
+ *   chunks: per probe, capacity sample times followed by capacity sample
+ *           values (double)
+ *
+ * Only the first 'number of samples written' entries of each column are
+ * valid; the count is updated as samples are written, so that a file can
+ * be read while it is being written.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arbor/common_types.hpp>
+#include <arbor/sampling.hpp>
+
+namespace arb {
+
+// Writes the samples of a fixed set of probes with scalar double values
+// to a trace file.
+//
+// Samples are queued by the samplers, and copied into the file by a
+// background thread, so that the samplers do not wait on I/O. The samplers
+// may be called concurrently from different cell groups, but the samples
+// of each probe must be given in time order.
+//
+// A sample of a probe not in the probe set raises bad_probe_id, and a
+// sample beyond the capacity of its probe raises trace_file_error, as does
+// a sample given after the writer is closed or destroyed.
+
+class trace_writer {
+public:
+    trace_writer(const std::string& path, std::vector<cell_member_type> probe_ids, std::size_t capacity);
+
+    trace_writer(const trace_writer&) = delete;
+    trace_writer& operator=(const trace_writer&) = delete;
+
+    // Closes the file, if open.
+    ~trace_writer();
+
+    // Samplers that queue samples for writing.
+    bulk_sampler_function bulk_sampler();
+    sampler_function sampler();
+
+    // Wait until all queued samples have been written to the mapping.
+    void flush();
+
+    // Write all queued samples, stop the writer thread and close the file.
+    void close();
+
+private:
+    struct impl;
+    std::shared_ptr<impl> impl_; // Shared with the samplers.
+};
+
+// Read-only view of a trace file. The column pointers remain valid for
+// the lifetime of the reader.
+
+class trace_reader {
+public:
+    explicit trace_reader(const std::string& path);
+
+    trace_reader(trace_reader&&);
+    trace_reader& operator=(trace_reader&&);
+    ~trace_reader();
+
+    std::size_t num_probes() const;
+    std::size_t capacity() const;
+
+    cell_member_type probe_id(std::size_t i) const;
+    probe_tag tag(std::size_t i) const;
+    std::size_t num_samples(std::size_t i) const;
+
+    // The sample times [ms] and values of probe i, of length num_samples(i).
+    const double* times(std::size_t i) const;
+    const double* values(std::size_t i) const;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+} // namespace arb
@@ -0,0 +1,37 @@
+#include <arbor/izhikevich_cell.hpp>
+
+#include "izhikevich_cell_group.hpp"
+
+namespace arb {
+
+void izhikevich_model::resize(std::size_t n) {
+    izhikevich_cell cell;
+    a.assign(n, cell.a);
+    b.assign(n, cell.b);
+    c.assign(n, cell.c);
+    d.assign(n, cell.d);
+    V_peak.assign(n, cell.V_peak);
+    I_e.assign(n, cell.I_e);
+    V_init.assign(n, cell.V_m);
+    u_init.assign(n, cell.u);
+}
+
+void izhikevich_model::set_cell(std::size_t i, const izhikevich_cell& cell) {
+    a[i] = cell.a;
+    b[i] = cell.b;
+    c[i] = cell.c;
+    d[i] = cell.d;
+    V_peak[i] = cell.V_peak;
+    I_e[i] = cell.I_e;
+    V_init[i] = cell.V_m;
+    u_init[i] = cell.u;
+}
+
+void izhikevich_model::reset() {
+    V_m = V_init;
+    u = u_init;
+}
+
+template class point_cell_group<izhikevich_model>;
+
+} // namespace arb
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include <arbor/common_types.hpp>
+#include <arbor/izhikevich_cell.hpp>
+#include <arbor/simd/simd.hpp>
+
+#include "point_cell_group.hpp"
+
+namespace arb {
+
+// Parameters and state of Izhikevich cells, integrated with the forward
+// Euler method.
+
+struct izhikevich_model {
+    using value_type = double;
+    using cell_type = izhikevich_cell;
+    static constexpr cell_kind kind = cell_kind::izhikevich;
+
+    // Cell parameters, by cell.
+    std::vector<value_type> a, b, c, d, V_peak, I_e;
+
+    // Initial and current membrane potential and recovery variable, by cell.
+    std::vector<value_type> V_init, u_init, V_m, u;
+
+    void resize(std::size_t n);
+    void set_cell(std::size_t i, const izhikevich_cell& cell);
+    void reset();
+
+    template <int W>
+    void step(std::size_t i, value_type t, value_type h, const value_type* x, bool* crossed) {
+        using simd_value = simd::simd<value_type, W>;
+
+        simd_value V(V_m.data()+i);
+        simd_value U(u.data()+i);
+
+        auto dV = (0.04*V + 5.)*V + 140. - U + simd_value(I_e.data()+i);
+        auto dU = simd_value(a.data()+i)*(simd_value(b.data()+i)*V - U);
+        V = V + h*dV + simd_value(x);
+        U = U + h*dU;
+
+        auto m = V>=simd_value(V_peak.data()+i);
+        m.copy_to(crossed);
+        simd::where(m, V) = simd_value(c.data()+i);
+        simd::where(m, U) = U + simd_value(d.data()+i);
+
+        V.copy_to(V_m.data()+i);
+        U.copy_to(u.data()+i);
+    }
+};
+
+extern template class point_cell_group<izhikevich_model>;
+using izhikevich_cell_group = point_cell_group<izhikevich_model>;
+
+} // namespace arb
@@ -1,23 +1,57 @@
+#include <cmath>
+#include <numeric>
+
+#include <arbor/arbexcept.hpp>
+
 #include <lif_cell_group.hpp>
 
 #include "profile/profiler_macro.hpp"
+#include "util/filter.hpp"
+#include "util/maputil.hpp"
+#include "util/rangeutil.hpp"
 #include "util/span.hpp"
 
 using namespace arb;
 
 // Constructor containing gid of first cell in a group and a container of all cells.
-lif_cell_group::lif_cell_group(const std::vector<cell_gid_type>& gids, const recipe& rec):
-    gids_(gids)
+lif_cell_group::lif_cell_group(const std::vector<cell_gid_type>& gids, const recipe& rec, task_system_handle threads):
+    gids_(gids),
+    chunks_(gids.size()),
+    threads_(std::move(threads))
 {
     // Default to no binning of events
     set_binning_policy(binning_kind::none, 0);
 
-    cells_.reserve(gids_.size());
-    last_time_updated_.resize(gids_.size());
+    // Padding cells have no events, and are never updated.
+    auto n_padded = (gids_.size()+simd_width-1)/simd_width*simd_width;
+    for (auto v: {&tau_m_, &V_th_, &C_m_, &E_L_, &t_ref_, &V_init_}) {
+        v->assign(n_padded, 1);
+    }
 
     for (auto lid: util::make_span(gids_.size())) {
-        cells_.push_back(util::any_cast<lif_cell>(rec.get_cell_description(gids_[lid])));
+        auto gid = gids_[lid];
+        gid_index_map_[gid] = lid;
+
+        // All probes of a cell sample its membrane potential: other probe
+        // addresses are rejected.
+        for (cell_lid_type j = 0; j<rec.num_probes(gid); ++j) {
+            probe_info pi = rec.get_probe({gid, j});
+            if (!util::any_cast<lif_probe_voltage>(&pi.address)) {
+                throw bad_probe_id(pi.id);
+            }
+            probe_map_.insert({pi.id, {cell_size_type(lid), pi.tag}});
+        }
+
+        auto cell = util::any_cast<lif_cell>(rec.get_cell_description(gid));
+        tau_m_[lid] = cell.tau_m;
+        V_th_[lid] = cell.V_th;
+        C_m_[lid] = cell.C_m;
+        E_L_[lid] = cell.E_L;
+        t_ref_[lid] = cell.t_ref;
+        V_init_[lid] = cell.V_m;
     }
+
+    reset();
 }
 
 cell_kind lif_cell_group::get_cell_kind() const {
@@ -25,12 +59,89 @@ cell_kind lif_cell_group::get_cell_kind() const {
 }
 
 void lif_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& event_lanes) {
+    // Create the sample requests of the epoch, with offsets into the sample
+    // time and value arrays assigned as in mc_cell_group, so that the
+    // samples of a sampler call are contiguous.
+
+    PE(advance_samplesetup);
+    call_info_.clear();
+    bulk_call_info_.clear();
+    staged_samples_.clear();
+
+    sample_size_type n_samples = 0;
+    sample_size_type max_samples_per_call = 0;
+
+    for (auto& sa: sampler_map_) {
+        auto sample_times = util::make_range(sa.sched.events(t_, ep.tfinal));
+        if (sample_times.empty()) {
+            continue;
+        }
+
+        sample_size_type n_times = sample_times.size();
+        max_samples_per_call = std::max(max_samples_per_call, n_times);
+
+        if (sa.bulk_sampler) {
+            bulk_call_info_.push_back({&sa, n_samples, n_times});
+        }
+
+        for (cell_member_type pid: sa.probe_ids) {
+            auto p = probe_map_.at(pid);
+
+            if (!sa.bulk_sampler) {
+                call_info_.push_back({sa.sampler, pid, p.tag, n_samples, n_samples+n_times});
+            }
+
+            for (auto t: sample_times) {
+                staged_samples_.push_back({p.handle, t, n_samples++});
+            }
+        }
+    }
+
+    // Samples are taken cell by cell, in order of time.
+    util::sort_by(staged_samples_, [](const sample_request& s) { return std::make_pair(s.lid, s.time); });
+    sample_divs_.assign(gids_.size()+1, 0);
+    for (auto& s: staged_samples_) {
+        ++sample_divs_[s.lid+1];
+    }
+    std::partial_sum(sample_divs_.begin(), sample_divs_.end(), sample_divs_.begin());
+
+    sample_time_.resize(n_samples);
+    sample_value_.resize(n_samples);
+    PL();
+
     PE(advance_lif);
-    if (event_lanes.size() > 0) {
-        for (auto lid: util::make_span(gids_.size())) {
-            // Advance each cell independently.
-            advance_cell(ep.tfinal, dt, lid, event_lanes[lid]);
+    if (event_lanes.size()>0 || !staged_samples_.empty()) {
+        // Advance the chunks of cells independently.
+        chunks_.advance(threads_, spikes_,
+            [&](std::size_t begin, std::size_t end, std::vector<spike>& spikes) {
+                advance_chunk(begin, end, ep.tfinal, event_lanes, spikes);
+            });
+    }
+    t_ = ep.tfinal;
+    PL();
+
+    PE(advance_sampledeliver);
+    const auto& sample_value = sample_value_;
+    sample_records_.reserve(max_samples_per_call);
+
+    for (auto& sc: call_info_) {
+        sample_records_.clear();
+        for (auto i = sc.begin_offset; i!=sc.end_offset; ++i) {
+            sample_records_.push_back(sample_record{time_type(sample_time_[i]), &sample_value[i]});
         }
+
+        sc.sampler(sc.probe_id, sc.tag, sc.end_offset-sc.begin_offset, sample_records_.data());
+    }
+
+    for (auto& bc: bulk_call_info_) {
+        const auto& sa = *bc.assoc;
+        sample_block block{
+            sa.probe_ids.size(), std::size_t(bc.n_samples),
+            sa.probe_ids.data(), sa.probe_tags.data(),
+            sample_time_.data()+bc.begin_offset,
+            sample_value_.data()+bc.begin_offset};
+
+        sa.bulk_sampler(block);
     }
     PL();
 }
@@ -43,65 +154,214 @@ void lif_cell_group::clear_spikes() {
     spikes_.clear();
 }
 
-// TODO: implement sampler
 void lif_cell_group::add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
-                                    schedule sched, sampler_function fn, sampling_policy policy) {}
-void lif_cell_group::remove_sampler(sampler_association_handle h) {}
-void lif_cell_group::remove_all_samplers() {}
+                                 schedule sched, sampler_function fn, sampling_policy policy)
+{
+    std::vector<cell_member_type> probeset =
+        util::assign_from(util::filter(util::keys(probe_map_), probe_ids));
+
+    if (!probeset.empty()) {
+        sampler_map_.add(h, sampler_association{std::move(sched), std::move(fn), std::move(probeset)});
+    }
+}
+
+void lif_cell_group::add_bulk_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
+                                      schedule sched, bulk_sampler_function fn, sampling_policy policy)
+{
+    std::vector<cell_member_type> probeset =
+        util::assign_from(util::filter(util::keys(probe_map_), probe_ids));
+
+    if (!probeset.empty()) {
+        std::vector<probe_tag> tags;
+        for (auto pid: probeset) {
+            tags.push_back(probe_map_[pid].tag);
+        }
+
+        sampler_association assoc;
+        assoc.sched = std::move(sched);
+        assoc.probe_ids = std::move(probeset);
+        assoc.bulk_sampler = std::move(fn);
+        assoc.probe_tags = std::move(tags);
+        sampler_map_.add(h, std::move(assoc));
+    }
+}
+
+void lif_cell_group::remove_sampler(sampler_association_handle h) {
+    sampler_map_.remove(h);
+}
+
+void lif_cell_group::remove_all_samplers() {
+    sampler_map_.clear();
+}
 
-// TODO: implement binner_
 void lif_cell_group::set_binning_policy(binning_kind policy, time_type bin_interval) {
+    binners_.clear();
+    binners_.resize(gids_.size(), event_binner(policy, bin_interval));
+    binning_ = policy!=binning_kind::none;
+    binned_lanes_.resize(binning_? gids_.size(): 0);
 }
 
 void lif_cell_group::reset() {
     spikes_.clear();
-    last_time_updated_.clear();
+    V_m_ = V_init_;
+    last_time_updated_.assign(V_m_.size(), 0);
+    t_ = 0;
+
+    for (auto& assoc: sampler_map_) {
+        assoc.sched.reset();
+    }
+
+    for (auto& b: binners_) {
+        b.reset();
+    }
 }
 
-// Advances a single cell (lid) with the exact solution (jumps can be arbitrary).
-// Parameter dt is ignored, since we make jumps between two consecutive spikes.
-void lif_cell_group::advance_cell(time_type tfinal, time_type dt, cell_gid_type lid, pse_vector& event_lane) {
-    // Current time of last update.
-    auto t = last_time_updated_[lid];
-    auto& cell = cells_[lid];
-    const auto n_events = event_lane.size();
-
-    // Integrate until tfinal using the exact solution of membrane voltage differential equation.
-    for (unsigned i=0; i<n_events; ++i ) {
-        auto& ev = event_lane[i];
-        const auto time = ev.time;
-        auto weight = ev.weight;
-
-        if (time < t) continue;        // skip event if a neuron is in refactory period
-        if (time >= tfinal) break;     // end of integration interval
-
-        // if there are events that happened at the same time as this event, process them as well
-        while (i + 1 < n_events && event_lane[i+1].time <= time) {
-            weight += event_lane[i+1].weight;
-            i++;
-        }
+// Advances the cells of a chunk with the exact solution (jumps can be
+// arbitrary), simd_width cells at a time. The samples of a cell due before
+// its next event are taken from the solution at the sample times; samples
+// at the time of an event are taken after it.
+void lif_cell_group::advance_chunk(
+    std::size_t begin, std::size_t end, time_type tfinal,
+    const event_lane_subrange& event_lanes, std::vector<spike>& spikes)
+{
+    using simd_value = simd::simd<value_type, simd_width>;
+    using simd_mask = simd_value::simd_mask;
+    constexpr std::size_t W = simd_width;
+
+    // The events of each lane still to be processed, the time of the last
+    // update of the cell, and the summed weight and time since the last
+    // update of the next event.
+    const spike_event* next[W];
+    const spike_event* last[W];
+    time_type t[W];
+    value_type weight[W];
+    value_type delta[W];
+    bool active[W];
+    bool crossed[W];
+
+    // The samples of each lane still to be taken, and the membrane
+    // potentials of the lanes, for blocks with samples.
+    const sample_request* next_sample[W];
+    const sample_request* last_sample[W];
+    value_type v[W];
 
-        // Let the membrane potential decay.
-        auto decay = exp(-(time - t) / cell.tau_m);
-        cell.V_m *= decay;
-        auto update = weight / cell.C_m;
-        // Add jump due to spike.
-        cell.V_m += update;
-        t = time;
-        // If crossing threshold occurred
-        if (cell.V_m >= cell.V_th) {
-            cell_member_type spike_neuron_gid = {gids_[lid], 0};
-            spike s = {spike_neuron_gid, t};
-            spikes_.push_back(s);
-
-            // Advance the last_time_updated to account for the refractory period.
-            t += cell.t_ref;
-
-            // Reset the voltage to resting potential.
-            cell.V_m = cell.E_L;
+    // Bin the event times of the cells of the chunk.
+    if (binning_ && event_lanes.size()) {
+        for (auto lid: util::make_span(begin, end)) {
+            auto& binned = binned_lanes_[lid];
+            binned.clear();
+            for (auto e: event_lanes[lid]) {
+                if (e.time>=tfinal) break;
+                e.time = binners_[lid].bin(e.time, t_);
+                binned.push_back(e);
+            }
         }
     }
 
-    // This is the last time a cell was updated.
-    last_time_updated_[lid] = t;
+    for (std::size_t b = begin; b<end; b += W) {
+        for (std::size_t k = 0; k<W; ++k) {
+            auto lid = b+k;
+            if (lid<end && event_lanes.size()) {
+                const auto& lane = binning_? binned_lanes_[lid]: event_lanes[lid];
+                next[k] = lane.data();
+                last[k] = lane.data()+lane.size();
+            }
+            else {
+                next[k] = last[k] = nullptr;
+            }
+            t[k] = last_time_updated_[lid];
+
+            if (lid<end) {
+                next_sample[k] = staged_samples_.data()+sample_divs_[lid];
+                last_sample[k] = staged_samples_.data()+sample_divs_[lid+1];
+            }
+            else {
+                next_sample[k] = last_sample[k] = nullptr;
+            }
+        }
+
+        const bool sampled = sample_divs_[b]!=sample_divs_[std::min(b+W, end)];
+        if (sampled) {
+            std::copy(V_m_.data()+b, V_m_.data()+b+W, v);
+        }
+
+        simd_value V(V_m_.data()+b);
+        const simd_value tau(tau_m_.data()+b);
+        const simd_value C(C_m_.data()+b);
+        const simd_value V_th(V_th_.data()+b);
+        const simd_value E_L(E_L_.data()+b);
+
+        for (;;) {
+            bool any = false;
+            for (std::size_t k = 0; k<W; ++k) {
+                auto& i = next[k];
+                auto n = last[k];
+
+                // Skip events while the neuron is in its refractory period.
+                while (i<n && i->time<t[k]) ++i;
+
+                // Take the samples due before the next event; the membrane
+                // potential is held during the refractory period.
+                if (sampled) {
+                    auto te = i==n || i->time>=tfinal? tfinal: i->time;
+                    auto tau = tau_m_[b+k];
+                    for (auto& s = next_sample[k]; s<last_sample[k] && s->time<te; ++s) {
+                        sample_time_[s->offset] = s->time;
+                        sample_value_[s->offset] = s->time<=t[k]? v[k]: v[k]*std::exp(-(s->time-t[k])/tau);
+                    }
+                }
+
+                if (i==n || i->time>=tfinal) {
+                    // End of integration interval: the lane is left
+                    // unchanged.
+                    i = n;
+                    active[k] = false;
+                    weight[k] = 0;
+                    delta[k] = 0;
+                    continue;
+                }
+
+                // If there are events that happened at the same time as
+                // this event, process them as well.
+                const auto time = i->time;
+                auto w = i->weight;
+                while (++i<n && i->time<=time) {
+                    w += i->weight;
+                }
+
+                active[k] = true;
+                weight[k] = w;
+                delta[k] = time-t[k];
+                t[k] = time;
+                any = true;
+            }
+            if (!any) break;
+
+            // Let the membrane potential decay, and add the jumps due to
+            // the events; inactive lanes have zero delta and weight. Lanes
+            // that reach threshold are reset to the resting potential.
+            V = V*exp(-simd_value(delta)/tau) + simd_value(weight)/C;
+
+            auto m = V>=V_th && simd_mask(active);
+            m.copy_to(crossed);
+            simd::where(m, V) = E_L;
+            if (sampled) {
+                V.copy_to(v);
+            }
+
+            for (std::size_t k = 0; k<W; ++k) {
+                // If crossing threshold occurred
+                if (crossed[k]) {
+                    auto lid = b+k;
+                    spikes.push_back({{gids_[lid], 0}, t[k]});
+
+                    // Advance the last update time to account for the refractory period.
+                    t[k] += t_ref_[lid];
+                }
+            }
+        }
+
+        V.copy_to(V_m_.data()+b);
+        std::copy(t, t+W, last_time_updated_.data()+b);
+    }
 }
@@ -1,25 +1,47 @@
 #pragma once
 
+#include <algorithm>
+#include <unordered_map>
 #include <vector>
 
 #include <arbor/common_types.hpp>
 #include <arbor/lif_cell.hpp>
 #include <arbor/recipe.hpp>
 #include <arbor/sampling.hpp>
+#include <arbor/simd/simd.hpp>
 #include <arbor/spike.hpp>
 
+#include "cell_chunks.hpp"
 #include "cell_group.hpp"
+#include "event_binner.hpp"
+#include "sampler_map.hpp"
+#include "threading/threading.hpp"
 
 namespace arb {
 
+// Cells are advanced with the exact solution of the membrane voltage
+// between events, so that dt is not used.
+//
+// The parameters and state of the cells are held in SoA arrays, padded to a
+// multiple of simd_width cells. Cells are advanced simd_width at a time,
+// event by event: the next event of each cell of a block is found, the
+// membrane voltages are decayed and updated in vector operations, and only
+// the lanes that reach threshold are handled one by one. Blocks are split
+// into chunks that are advanced in parallel.
+//
+// The membrane potential is sampled at the sample times of a cell from the
+// exact solution, as the cell is advanced from event to event.
+
 class lif_cell_group: public cell_group {
 public:
     using value_type = double;
 
+    static constexpr int simd_width = std::max(4, simd::simd_abi::native_width<value_type>::value);
+
     lif_cell_group() = default;
 
     // Constructor containing gid of first cell in a group and a container of all cells.
-    lif_cell_group(const std::vector<cell_gid_type>& gids, const recipe& rec);
+    lif_cell_group(const std::vector<cell_gid_type>& gids, const recipe& rec, task_system_handle threads = {});
 
     virtual cell_kind get_cell_kind() const override;
     virtual void reset() override;
@@ -32,25 +54,97 @@ public:
     // Sampler association methods below should be thread-safe, as they might be invoked
     // from a sampler call back called from a different cell group running on a different thread.
     virtual void add_sampler(sampler_association_handle, cell_member_predicate, schedule, sampler_function, sampling_policy) override;
+    virtual void add_bulk_sampler(sampler_association_handle, cell_member_predicate, schedule, bulk_sampler_function, sampling_policy) override;
     virtual void remove_sampler(sampler_association_handle) override;
     virtual void remove_all_samplers() override;
 
 private:
-    // Advances a single cell (lid) with the exact solution (jumps can be arbitrary).
-    // Parameter dt is ignored, since we make jumps between two consecutive spikes.
-    void advance_cell(time_type tfinal, time_type dt, cell_gid_type lid, pse_vector& event_lane);
+    // Advances the cells [begin, end) of a chunk to tfinal, appending their
+    // spikes to spikes and taking their samples; begin is a multiple of
+    // simd_width.
+    void advance_chunk(std::size_t begin, std::size_t end, time_type tfinal, const event_lane_subrange& event_lanes, std::vector<spike>& spikes);
+
+    // A sample of the membrane potential of cell lid, stored at offset in
+    // the sample time and value arrays.
+    struct sample_request {
+        cell_size_type lid;
+        time_type time;
+        sample_size_type offset;
+    };
 
     // List of the gids of the cells in the group.
     std::vector<cell_gid_type> gids_;
 
-    // Cells that belong to this group.
-    std::vector<lif_cell> cells_;
+    // Cell parameters and initial membrane potential, by cell.
+    std::vector<value_type> tau_m_;
+    std::vector<value_type> V_th_;
+    std::vector<value_type> C_m_;
+    std::vector<value_type> E_L_;
+    std::vector<value_type> t_ref_;
+    std::vector<value_type> V_init_;
+
+    // Membrane potential, by cell.
+    std::vector<value_type> V_m_;
 
     // Spikes that are generated (not necessarily sorted).
     std::vector<spike> spikes_;
 
+    // Chunks of cells advanced as one task.
+    cell_chunks chunks_;
+
     // Time when the cell was last updated.
     std::vector<time_type> last_time_updated_;
+
+    // Time at the start of the next epoch.
+    time_type t_ = 0;
+
+    // Event time binning manager, by cell.
+    std::vector<event_binner> binners_;
+    bool binning_ = false;
+
+    // Events with binned times, by cell, used in place of the event lanes
+    // when events are binned.
+    std::vector<pse_vector> binned_lanes_;
+
+    // Hash table for converting gid to local index.
+    std::unordered_map<cell_gid_type, cell_size_type> gid_index_map_;
+
+    // Maps probe ids to the local index of their cell and their tags.
+    probe_association_map<cell_size_type> probe_map_;
+
+    // Collection of samplers to be run against probes in this group.
+    sampler_association_map sampler_map_;
+
+    // Sampler callback with the range of its samples in the sample time
+    // and value arrays.
+    struct sampler_call_info {
+        sampler_function sampler;
+        cell_member_type probe_id;
+        probe_tag tag;
+        sample_size_type begin_offset;
+        sample_size_type end_offset;
+    };
+
+    // Bulk sampler association with the range of its samples, n_samples
+    // per probe, from begin_offset.
+    struct bulk_sampler_call_info {
+        const sampler_association* assoc;
+        sample_size_type begin_offset;
+        sample_size_type n_samples;
+    };
+
+    // Samples of an epoch ordered by cell and time, partitioned by cell
+    // by sample_divs_, with their times and values and the sampler calls
+    // that deliver them.
+    std::vector<sample_request> staged_samples_;
+    std::vector<std::size_t> sample_divs_;
+    std::vector<fvm_value_type> sample_time_;
+    std::vector<fvm_value_type> sample_value_;
+    std::vector<sampler_call_info> call_info_;
+    std::vector<bulk_sampler_call_info> bulk_call_info_;
+    std::vector<sample_record> sample_records_;
+
+    task_system_handle threads_;
 };
 
 } // namespace arb
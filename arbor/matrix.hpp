@@ -5,6 +5,7 @@
 #include <arbor/assert.hpp>
 
 #include <memory/memory.hpp>
+#include <threading/threading.hpp>
 #include <util/span.hpp>
 
 namespace arb {
@@ -31,16 +32,22 @@ public:
 
     matrix() = default;
 
+    // Back ends may use the threads of the task system, if provided, to
+    // assemble and solve the matrix, and may reuse the factorization of
+    // a cell matrix while its diagonal is unchanged if reuse_factorization
+    // is set.
     matrix(const std::vector<index_type>& pi,
            const std::vector<index_type>& ci,
            const std::vector<value_type>& cv_capacitance,
            const std::vector<value_type>& face_conductance,
            const std::vector<value_type>& cv_area,
-           const std::vector<index_type>& cell_to_intdom):
+           const std::vector<index_type>& cell_to_intdom,
+           const task_system_handle& threads = {},
+           bool reuse_factorization = false):
         parent_index_(pi.begin(), pi.end()),
         cell_index_(ci.begin(), ci.end()),
         cell_to_intdom_(cell_to_intdom.begin(), cell_to_intdom.end()),
-        state_(pi, ci, cv_capacitance, face_conductance, cv_area, cell_to_intdom)
+        state_(pi, ci, cv_capacitance, face_conductance, cv_area, cell_to_intdom, threads, reuse_factorization)
     {
         arb_assert(cell_index_[num_cells()] == index_type(parent_index_.size()));
     }
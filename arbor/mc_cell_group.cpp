@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <functional>
+#include <numeric>
 #include <unordered_set>
 #include <vector>
 
@@ -50,6 +52,23 @@ mc_cell_group::mc_cell_group(const std::vector<cell_gid_type>& gids, const recip
     // Construct cell implementation, retrieving handles and maps. 
     lowered_->initialize(gids_, rec, cell_to_intdom_, target_handles_, probe_map_);
 
+    // Order the cells by integration domain.
+    std::size_t n_intdom = 0;
+    for (auto d: cell_to_intdom_) {
+        n_intdom = std::max<std::size_t>(n_intdom, d+1);
+    }
+    intdom_cell_divs_.assign(n_intdom+1, 0);
+    for (auto d: cell_to_intdom_) {
+        ++intdom_cell_divs_[d+1];
+    }
+    std::partial_sum(intdom_cell_divs_.begin(), intdom_cell_divs_.end(), intdom_cell_divs_.begin());
+
+    intdom_cells_.resize(cell_to_intdom_.size());
+    auto next = intdom_cell_divs_;
+    for (auto i: util::count_along(cell_to_intdom_)) {
+        intdom_cells_[next[cell_to_intdom_[i]]++] = i;
+    }
+
     // Create a list of the global identifiers for the spike sources
     for (auto source_gid: gids_) {
         for (cell_lid_type lid = 0; lid<rec.num_sources(source_gid); ++lid) {
@@ -85,45 +104,40 @@ void mc_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& e
     PE(advance_eventsetup);
     staged_events_.clear();
 
-    fvm_index_type ev_begin = 0, ev_mid = 0, ev_end = 0;
     // skip event binning if empty lanes are passed
     if (event_lanes.size()) {
-
-        std::vector<cell_size_type> idx_sorted_by_intdom(cell_to_intdom_.size());
-        std::iota(idx_sorted_by_intdom.begin(), idx_sorted_by_intdom.end(), 0);
-        util::sort_by(idx_sorted_by_intdom, [&](cell_size_type i) { return cell_to_intdom_[i]; });
-
-        /// Event merging on integration domain could benefit from the use of the logic from `tree_merge_events`
-        fvm_index_type prev_intdom = -1;
-        for (auto i: util::count_along(gids_)) {
-            unsigned count_staged = 0;
-
-            auto lid = idx_sorted_by_intdom[i];
-            auto& lane = event_lanes[lid];
-            auto curr_intdom = cell_to_intdom_[lid];
-
-            for (auto e: lane) {
+        // Stage the events of cell lid that are due before tfinal in out.
+        auto stage_events = [&](cell_size_type lid, std::vector<deliverable_event>& out) {
+            for (auto e: event_lanes[lid]) {
                 if (e.time>=ep.tfinal) break;
                 e.time = binners_[lid].bin(e.time, tstart);
                 auto h = target_handles_[target_handle_divisions_[lid]+e.target.index];
-                auto ev = deliverable_event(e.time, h, e.weight);
-                staged_events_.push_back(ev);
-                count_staged++;
+                out.push_back(deliverable_event(e.time, h, e.weight));
             }
-
-            ev_end += count_staged;
-
-            if (curr_intdom != prev_intdom) {
-                ev_begin = ev_end - count_staged;
-                prev_intdom = curr_intdom;
-            }
-            else {
-                std::inplace_merge(staged_events_.begin() + ev_begin,
-                                   staged_events_.begin() + ev_mid,
-                                   staged_events_.begin() + ev_end);
+        };
+
+        // The events of each integration domain are staged in order of
+        // time: the lane of each cell is sorted, and the lanes of the
+        // cells of a domain with more than one cell are merged.
+        for (auto d: util::make_span(intdom_cell_divs_.size()-1)) {
+            auto first = intdom_cell_divs_[d];
+            auto last = intdom_cell_divs_[d+1];
+
+            if (last-first==1) {
+                stage_events(intdom_cells_[first], staged_events_);
+                continue;
             }
 
-            ev_mid = ev_end;
+            merge_events_.clear();
+            merge_ranges_.clear();
+            for (auto i: util::make_span(first, last)) {
+                auto begin = merge_events_.size();
+                stage_events(intdom_cells_[i], merge_events_);
+                if (merge_events_.size()>begin) {
+                    merge_ranges_.push_back({begin, merge_events_.size()});
+                }
+            }
+            merge_staged_events();
         }
     }
     PL();
@@ -139,23 +153,16 @@ void mc_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& e
     // Each event is associated with an offset into the sample data and
     // time buffers; these are assigned contiguously such that one call to
     // a sampler callback can be represented by a `sampler_call_info`
-    // value as defined below, grouping together all the samples of the
-    // same probe for this callback in this association.
-
-    struct sampler_call_info {
-        sampler_function sampler;
-        cell_member_type probe_id;
-        probe_tag tag;
-
-        // Offsets are into lowered cell sample time and event arrays.
-        sample_size_type begin_offset;
-        sample_size_type end_offset;
-    };
+    // value, grouping together all the samples of the same probe for this
+    // callback in this association. The samples of a bulk sampler
+    // association are then contiguous, and are passed to its callback in
+    // one call.
 
     PE(advance_samplesetup);
-    std::vector<sampler_call_info> call_info;
+    call_info_.clear();
+    bulk_call_info_.clear();
+    staged_samples_.clear();
 
-    std::vector<sample_event> sample_events;
     sample_size_type n_samples = 0;
     sample_size_type max_samples_per_call = 0;
 
@@ -168,41 +175,57 @@ void mc_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& e
         sample_size_type n_times = sample_times.size();
         max_samples_per_call = std::max(max_samples_per_call, n_times);
 
+        if (sa.bulk_sampler) {
+            bulk_call_info_.push_back({&sa, n_samples, n_times});
+        }
+
         for (cell_member_type pid: sa.probe_ids) {
             auto cell_index = gid_index_map_.at(pid.gid);
             auto p = probe_map_[pid];
 
-            call_info.push_back({sa.sampler, pid, p.tag, n_samples, n_samples+n_times});
+            if (!sa.bulk_sampler) {
+                call_info_.push_back({sa.sampler, pid, p.tag, n_samples, n_samples+n_times});
+            }
 
             for (auto t: sample_times) {
                 sample_event ev{t, (cell_gid_type)cell_to_intdom_[cell_index], {p.handle, n_samples++}};
-                sample_events.push_back(ev);
+                staged_samples_.push_back(ev);
             }
         }
     }
 
     // Sample events must be ordered by time for the lowered cell.
-    util::sort_by(sample_events, [](const sample_event& ev) { return event_time(ev); });
+    util::sort_by(staged_samples_, [](const sample_event& ev) { return event_time(ev); });
     PL();
 
     // Run integration and collect samples, spikes.
-    auto result = lowered_->integrate(ep.tfinal, dt, staged_events_, std::move(sample_events));
+    auto result = lowered_->integrate(ep.tfinal, dt, staged_events_, staged_samples_);
 
-    // For each sampler callback registered in `call_info`, construct the
+    // For each sampler callback registered in `call_info_`, construct the
     // vector of sample entries from the lowered cell sample times and values
     // and then call the callback.
 
     PE(advance_sampledeliver);
-    std::vector<sample_record> sample_records;
-    sample_records.reserve(max_samples_per_call);
+    sample_records_.reserve(max_samples_per_call);
 
-    for (auto& sc: call_info) {
-        sample_records.clear();
+    for (auto& sc: call_info_) {
+        sample_records_.clear();
         for (auto i = sc.begin_offset; i!=sc.end_offset; ++i) {
-           sample_records.push_back(sample_record{time_type(result.sample_time[i]), &result.sample_value[i]});
+           sample_records_.push_back(sample_record{time_type(result.sample_time[i]), &result.sample_value[i]});
         }
 
-        sc.sampler(sc.probe_id, sc.tag, sc.end_offset-sc.begin_offset, sample_records.data());
+        sc.sampler(sc.probe_id, sc.tag, sc.end_offset-sc.begin_offset, sample_records_.data());
+    }
+
+    for (auto& bc: bulk_call_info_) {
+        const auto& sa = *bc.assoc;
+        sample_block block{
+            sa.probe_ids.size(), std::size_t(bc.n_samples),
+            sa.probe_ids.data(), sa.probe_tags.data(),
+            result.sample_time.begin()+bc.begin_offset,
+            result.sample_value.begin()+bc.begin_offset};
+
+        sa.bulk_sampler(block);
     }
     PL();
 
@@ -216,6 +239,34 @@ void mc_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& e
     }
 }
 
+void mc_cell_group::merge_staged_events() {
+    auto& ranges = merge_ranges_;
+    const auto& events = merge_events_;
+
+    if (ranges.size()==1) {
+        staged_events_.insert(staged_events_.end(), events.begin()+ranges[0].first, events.begin()+ranges[0].second);
+        return;
+    }
+
+    // Merge with a heap of the ranges, ordered by the event at their heads.
+    auto later = [&](const std::pair<std::size_t, std::size_t>& a, const std::pair<std::size_t, std::size_t>& b) {
+        return events[b.first]<events[a.first];
+    };
+
+    std::make_heap(ranges.begin(), ranges.end(), later);
+    while (!ranges.empty()) {
+        std::pop_heap(ranges.begin(), ranges.end(), later);
+        auto& r = ranges.back();
+        staged_events_.push_back(events[r.first++]);
+        if (r.first==r.second) {
+            ranges.pop_back();
+        }
+        else {
+            std::push_heap(ranges.begin(), ranges.end(), later);
+        }
+    }
+}
+
 void mc_cell_group::add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
                                 schedule sched, sampler_function fn, sampling_policy policy)
 {
@@ -227,6 +278,27 @@ void mc_cell_group::add_sampler(sampler_association_handle h, cell_member_predic
     }
 }
 
+void mc_cell_group::add_bulk_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
+                                     schedule sched, bulk_sampler_function fn, sampling_policy policy)
+{
+    std::vector<cell_member_type> probeset =
+        util::assign_from(util::filter(util::keys(probe_map_), probe_ids));
+
+    if (!probeset.empty()) {
+        std::vector<probe_tag> tags;
+        for (auto pid: probeset) {
+            tags.push_back(probe_map_[pid].tag);
+        }
+
+        sampler_association assoc;
+        assoc.sched = std::move(sched);
+        assoc.probe_ids = std::move(probeset);
+        assoc.bulk_sampler = std::move(fn);
+        assoc.probe_tags = std::move(tags);
+        sampler_map_.add(h, std::move(assoc));
+    }
+}
+
 void mc_cell_group::remove_sampler(sampler_association_handle h) {
     sampler_map_.remove(h);
 }
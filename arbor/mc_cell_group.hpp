@@ -4,6 +4,7 @@
 #include <functional>
 #include <iterator>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <arbor/common_types.hpp>
@@ -53,6 +54,9 @@ public:
     void add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
                      schedule sched, sampler_function fn, sampling_policy policy) override;
 
+    void add_bulk_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
+                          schedule sched, bulk_sampler_function fn, sampling_policy policy) override;
+
     void remove_sampler(sampler_association_handle h) override;
 
     void remove_all_samplers() override;
@@ -64,6 +68,11 @@ private:
     // Map from gid to integration domain id
     std::vector<fvm_index_type> cell_to_intdom_;
 
+    // Cells ordered by integration domain: the cells of domain d are
+    // intdom_cells_[intdom_cell_divs_[d]] ... intdom_cells_[intdom_cell_divs_[d+1]-1].
+    std::vector<cell_size_type> intdom_cells_;
+    std::vector<cell_size_type> intdom_cell_divs_;
+
     // Hash table for converting gid to local index
     std::unordered_map<cell_gid_type, cell_gid_type> gid_index_map_;
 
@@ -82,6 +91,42 @@ private:
     // List of events to deliver
     std::vector<deliverable_event> staged_events_;
 
+    // Events of the cells of one integration domain, and the ranges of
+    // events of each cell in it, to be merged into staged_events_.
+    std::vector<deliverable_event> merge_events_;
+    std::vector<std::pair<std::size_t, std::size_t>> merge_ranges_;
+
+    // Sampler callback with the range of its samples in the lowered cell
+    // sample time and value arrays.
+    struct sampler_call_info {
+        sampler_function sampler;
+        cell_member_type probe_id;
+        probe_tag tag;
+
+        // Offsets are into lowered cell sample time and event arrays.
+        sample_size_type begin_offset;
+        sample_size_type end_offset;
+    };
+
+    // Bulk sampler association with the range of its samples, n_samples
+    // per probe, from begin_offset.
+    struct bulk_sampler_call_info {
+        const sampler_association* assoc;
+        sample_size_type begin_offset;
+        sample_size_type n_samples;
+    };
+
+    // Sample events, sampler calls and sample records of an epoch; these
+    // and the event buffers above are kept to reuse their storage.
+    std::vector<sample_event> staged_samples_;
+    std::vector<sampler_call_info> call_info_;
+    std::vector<bulk_sampler_call_info> bulk_call_info_;
+    std::vector<sample_record> sample_records_;
+
+    // Merge the event ranges merge_ranges_ of merge_events_, each sorted,
+    // onto the end of staged_events_.
+    void merge_staged_events();
+
     // Pending samples to be taken.
     event_queue<sample_event> sample_events_;
 
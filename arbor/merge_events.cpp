@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -147,6 +150,30 @@ const spike_event& tourney_tree::event(unsigned i) const {
 } // namespace impl
 
 void tree_merge_events(std::vector<event_span>& sources, pse_vector& out) {
+    // Merge directly when there are at most two non-empty sources, which is
+    // the case for most cells, e.g. old and pending events with one generator
+    // that has no events in the interval.
+    sources.erase(
+        std::remove_if(sources.begin(), sources.end(), [](const event_span& s) { return s.empty(); }),
+        sources.end());
+
+    if (sources.size()<=2) {
+        const auto n = out.size();
+        const auto n0 = sources.size()>0? sources[0].size(): 0;
+        const auto n1 = sources.size()>1? sources[1].size(): 0;
+        out.resize(n+n0+n1);
+        if (n1) {
+            std::merge(sources[0].begin(), sources[0].end(), sources[1].begin(), sources[1].end(), out.begin()+n);
+        }
+        else if (n0) {
+            std::copy(sources[0].begin(), sources[0].end(), out.begin()+n);
+        }
+        for (auto& s: sources) {
+            s.left = s.right;
+        }
+        return;
+    }
+
     impl::tourney_tree tree(sources);
     while (!tree.empty()) {
         out.push_back(tree.head());
@@ -154,5 +181,77 @@ void tree_merge_events(std::vector<event_span>& sources, pse_vector& out) {
     }
 }
 
+namespace {
+// Sequences shorter than this are sorted with std::sort.
+constexpr std::size_t radix_sort_min_size = 1024;
+
+// Map a float to an unsigned integer with the same order; -0 and +0 are
+// mapped to the same value, as they compare equal.
+std::uint32_t float_key(float f) {
+    std::uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    if (u==0x80000000u) u = 0;
+    return (u&0x80000000u)? ~u: u|0x80000000u;
+}
+
+// The sort key as four 32-bit words, from least to most significant.
+std::uint32_t key_word(const spike_event& e, unsigned w) {
+    switch (w) {
+        case 0:  return float_key(e.weight);
+        case 1:  return e.target.index;
+        case 2:  return e.target.gid;
+        default: return float_key(e.time);
+    }
+}
+} // anonymous namespace
+
+void sort_events(pse_vector& events) {
+    const std::size_t n = events.size();
+    if (n<radix_sort_min_size) {
+        std::sort(events.begin(), events.end());
+        return;
+    }
+
+    // Byte-wise histograms of the 16 byte key, computed in a single pass.
+    constexpr unsigned n_digits = 16;
+    std::vector<std::uint32_t> counts(n_digits*256);
+    for (const auto& e: events) {
+        for (unsigned w = 0; w<4; ++w) {
+            auto k = key_word(e, w);
+            for (unsigned b = 0; b<4; ++b) {
+                ++counts[(4*w+b)*256 + ((k>>(8*b))&0xff)];
+            }
+        }
+    }
+
+    // One stable counting sort per digit, from least to most significant,
+    // skipping digits that are the same for all events.
+    pse_vector buffer(n);
+    spike_event* src = events.data();
+    spike_event* dst = buffer.data();
+    for (unsigned d = 0; d<n_digits; ++d) {
+        auto c = counts.begin()+d*256;
+        if (std::find(c, c+256, n)!=c+256) continue;
+
+        std::uint32_t offsets[256];
+        std::uint32_t sum = 0;
+        for (unsigned i = 0; i<256; ++i) {
+            offsets[i] = sum;
+            sum += c[i];
+        }
+
+        const unsigned w = d/4, shift = 8*(d%4);
+        for (std::size_t i = 0; i<n; ++i) {
+            const auto digit = (key_word(src[i], w)>>shift)&0xff;
+            dst[offsets[digit]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src!=events.data()) {
+        std::copy(src, src+n, events.data());
+    }
+}
+
 } // namespace arb
 
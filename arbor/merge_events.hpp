@@ -17,6 +17,12 @@ using event_span = util::range<const spike_event*>;
 
 void tree_merge_events(std::vector<event_span>& sources, pse_vector& out);
 
+// Sort events in the order given by spike_event::operator<.
+// Long sequences are sorted with an LSD radix sort on the bits of the
+// (time, target, weight) key, skipping the digits that are the same for all
+// events; short sequences are sorted with a comparison sort.
+void sort_events(pse_vector& events);
+
 namespace impl {
     // The tournament tree is used internally by the merge_events method, and
     // it is not intended for use elsewhere. It is exposed here for unit testing
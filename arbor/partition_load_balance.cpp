@@ -1,7 +1,14 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <queue>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include <arbor/cable_cell.hpp>
 #include <arbor/domain_decomposition.hpp>
 #include <arbor/load_balance.hpp>
 #include <arbor/recipe.hpp>
@@ -10,64 +17,101 @@
 
 #include "cell_group_factory.hpp"
 #include "execution_context.hpp"
+#include "fvm_layout.hpp"
 #include "gpu_context.hpp"
+#include "graph_partition.hpp"
 #include "util/maputil.hpp"
 #include "util/partition.hpp"
 #include "util/span.hpp"
 
 namespace arb {
 
-domain_decomposition partition_load_balance(
-    const recipe& rec,
-    const context& ctx,
-    partition_hint_map hint_map)
-{
-    const bool gpu_avail = ctx->gpu->has_gpu();
+namespace {
 
-    struct partition_gid_domain {
-        partition_gid_domain(gathered_vector<cell_gid_type> divs, unsigned domains):
-            gids_by_rank(std::move(divs)), num_domains(domains)
-        {}
+// The gids split into num_domains contiguous ranges, of which the first
+// num_cells%num_domains have one cell more than the others.
+std::vector<cell_gid_type> equal_gid_divisions(cell_size_type num_cells, unsigned num_domains) {
+    const cell_gid_type B = num_cells/num_domains;
+    const cell_gid_type R = num_cells - num_domains*B;
 
-        int operator()(cell_gid_type gid) const {
-            using namespace util;
-            auto rank_part = partition_view(gids_by_rank.partition());
-            for (auto i: count_along(rank_part)) {
-                if (binary_search_index(subrange_view(gids_by_rank.values(), rank_part[i]), gid)) {
-                    return i;
-                }
-            }
-            return -1;
+    std::vector<cell_gid_type> divisions = {0};
+    for (auto d: util::make_span(num_domains)) {
+        divisions.push_back(divisions.back() + B + (d<R));
+    }
+    return divisions;
+}
+
+// The costs of the cells of the model. Each domain evaluates the costs of
+// its range of the gids split as by equal_gid_divisions, and the costs are
+// gathered on all domains only if they differ, so that with equal costs
+// each domain calls the cost function for its own cells only and keeps
+// one cost.
+class global_cell_costs {
+public:
+    global_cell_costs(const recipe& rec, const context& ctx, const cell_cost_function& cell_cost) {
+        auto& dist = ctx->distributed;
+        auto divisions = equal_gid_divisions(rec.num_cells(), dist->size());
+
+        std::vector<double> local_costs;
+        for (auto gid: util::make_span(divisions[dist->id()], divisions[dist->id()+1])) {
+            local_costs.push_back(cell_cost(gid));
         }
 
-        const gathered_vector<cell_gid_type> gids_by_rank;
-        unsigned num_domains;
-    };
+        double lo = std::numeric_limits<double>::max();
+        double hi = std::numeric_limits<double>::lowest();
+        for (auto c: local_costs) {
+            lo = std::min(lo, c);
+            hi = std::max(hi, c);
+        }
+        lo = dist->min(lo);
+        hi = dist->max(hi);
 
-    struct cell_identifier {
-        cell_gid_type id;
-        bool is_super_cell;
-    };
+        if (lo<hi) {
+            costs_ = dist->gather_cell_costs(local_costs).values();
+        }
+        else {
+            uniform_cost_ = lo==hi? lo: 1;
+        }
+    }
 
-    using util::make_span;
+    // True if all cells have the same cost.
+    bool uniform() const {
+        return costs_.empty();
+    }
 
-    unsigned num_domains = ctx->distributed->size();
-    unsigned domain_id = ctx->distributed->id();
-    auto num_global_cells = rec.num_cells();
+    double operator[](cell_gid_type gid) const {
+        return uniform()? uniform_cost_: costs_[gid];
+    }
 
-    auto dom_size = [&](unsigned dom) -> cell_gid_type {
-        const cell_gid_type B = num_global_cells/num_domains;
-        const cell_gid_type R = num_global_cells - num_domains*B;
-        return B + (dom<R);
-    };
+private:
+    double uniform_cost_ = 1;
+    std::vector<double> costs_;
+};
 
-    // Global load balance
+struct cell_identifier {
+    cell_gid_type id;
+    bool is_super_cell;
+};
 
-    std::vector<cell_gid_type> gid_divisions;
-    auto gid_part = make_partition(
-        gid_divisions, transform_view(make_span(num_domains), dom_size));
+// The cells of the local domain and their cell groups.
+struct local_cells {
+    std::vector<cell_gid_type> gids;
+    std::vector<group_description> groups;
+};
 
-    // Local load balance
+// The cells of the local domain are the candidates and the cells connected
+// to them by gap junctions, except for the super cells of which owns() is
+// false for the lowest gid. They are grouped by kind as described by the
+// hints.
+local_cells partition_local_cells(
+    const recipe& rec,
+    const context& ctx,
+    const std::vector<cell_gid_type>& candidates,
+    const std::function<bool (cell_gid_type)>& owns,
+    const global_cell_costs& costs,
+    const partition_hint_map& hint_map)
+{
+    const bool gpu_avail = ctx->gpu->has_gpu();
 
     std::vector<std::vector<cell_gid_type>> super_cells; //cells connected by gj
     std::vector<cell_gid_type> reg_cells; //independent cells
@@ -77,7 +121,7 @@ domain_decomposition partition_load_balance(
 
     // Connected components algorithm using BFS
     std::queue<cell_gid_type> q;
-    for (auto gid: make_span(gid_part[domain_id])) {
+    for (auto gid: candidates) {
         if (!rec.gap_junctions_on(gid).empty()) {
             // If cell hasn't been visited yet, must belong to new super_cell
             // Perform BFS starting from that cell
@@ -114,10 +158,10 @@ domain_decomposition partition_load_balance(
 
     // Sort super_cell groups and only keep those where the first element in the group belongs to domain
     super_cells.erase(std::remove_if(super_cells.begin(), super_cells.end(),
-            [gid_part, domain_id](std::vector<cell_gid_type>& cg)
+            [&owns](std::vector<cell_gid_type>& cg)
             {
                 std::sort(cg.begin(), cg.end());
-                return cg.front() < gid_part[domain_id].first;
+                return !owns(cg.front());
             }), super_cells.end());
 
     // Collect local gids that belong to this rank, and sort gids into kind lists
@@ -125,7 +169,8 @@ domain_decomposition partition_load_balance(
     // 1. gids of regular cells (in reg_cells)
     // 2. indices of supercells (in super_cells)
 
-    std::vector<cell_gid_type> local_gids;
+    local_cells local;
+    auto& local_gids = local.gids;
     std::unordered_map<cell_kind, std::vector<cell_identifier>> kind_lists;
     for (auto gid: reg_cells) {
         local_gids.push_back(gid);
@@ -165,7 +210,7 @@ domain_decomposition partition_load_balance(
     }
     std::partition(kinds.begin(), kinds.end(), has_gpu_backend);
 
-    std::vector<group_description> groups;
+    auto& groups = local.groups;
     for (auto k: kinds) {
         partition_hint hint;
         if (auto opt_hint = util::value_by_key(hint_map, k)) {
@@ -180,23 +225,36 @@ domain_decomposition partition_load_balance(
             group_size = hint.gpu_group_size;
         }
 
+        double group_cost = backend==backend_kind::multicore? hint.cpu_group_cost: partition_hint::max_cost;
+
         std::vector<cell_gid_type> group_elements;
+        double element_cost = 0;
         // group_elements are sorted such that the gids of all members of a super_cell are consecutive.
         for (auto cell: kind_lists[k]) {
             if (cell.is_super_cell == false) {
                 group_elements.push_back(cell.id);
+                element_cost += costs[cell.id];
             } else {
-                if (group_elements.size() + super_cells[cell.id].size() > group_size && !group_elements.empty()) {
+                double super_cell_cost = 0;
+                for (auto gid: super_cells[cell.id]) {
+                    super_cell_cost += costs[gid];
+                }
+                if ((group_elements.size() + super_cells[cell.id].size() > group_size || element_cost + super_cell_cost > group_cost)
+                    && !group_elements.empty())
+                {
                     groups.push_back({k, std::move(group_elements), backend});
                     group_elements.clear();
+                    element_cost = 0;
                 }
                 for (auto gid: super_cells[cell.id]) {
                     group_elements.push_back(gid);
                 }
+                element_cost += super_cell_cost;
             }
-            if (group_elements.size()>=group_size) {
+            if (group_elements.size()>=group_size || element_cost>=group_cost) {
                 groups.push_back({k, std::move(group_elements), backend});
                 group_elements.clear();
+                element_cost = 0;
             }
         }
         if (!group_elements.empty()) {
@@ -204,25 +262,249 @@ domain_decomposition partition_load_balance(
         }
     }
 
-    cell_size_type num_local_cells = local_gids.size();
+    util::sort(local_gids);
+    return local;
+}
 
-    // Exchange gid list with all other nodes
+} // anonymous namespace
 
-    util::sort(local_gids);
+domain_decomposition partition_load_balance(
+    const recipe& rec,
+    const context& ctx,
+    partition_hint_map hint_map)
+{
+    return partition_load_balance(
+        rec, ctx, [&rec](cell_gid_type gid) { return rec.get_cell_cost(gid); }, std::move(hint_map));
+}
+
+cell_cost_function cv_count_cell_cost(const recipe& rec) {
+    return [&rec](cell_gid_type gid) -> double {
+        if (rec.get_cell_kind(gid)!=cell_kind::cable) {
+            return 1;
+        }
+        auto cell = util::any_cast<cable_cell>(rec.get_cell_description(gid));
+        return fvm_discretize({std::move(cell)}).ncv;
+    };
+}
+
+cell_cost_function gather_cell_costs(
+    const context& ctx,
+    const std::unordered_map<cell_gid_type, double>& local_costs)
+{
+    std::vector<cell_gid_type> gids;
+    std::vector<double> costs;
+    for (auto& gid_cost: local_costs) {
+        gids.push_back(gid_cost.first);
+        costs.push_back(gid_cost.second);
+    }
+
+    auto global_gids = ctx->distributed->gather_gids(gids);
+    auto global_costs = ctx->distributed->gather_cell_costs(costs);
+
+    auto cost_by_gid = std::make_shared<std::unordered_map<cell_gid_type, double>>();
+    double total = 0;
+    for (auto i: util::count_along(global_gids.values())) {
+        (*cost_by_gid)[global_gids.values()[i]] = global_costs.values()[i];
+        total += global_costs.values()[i];
+    }
+    double mean = cost_by_gid->empty()? 1: total/cost_by_gid->size();
+
+    return [cost_by_gid, mean](cell_gid_type gid) {
+        auto it = cost_by_gid->find(gid);
+        return it==cost_by_gid->end()? mean: it->second;
+    };
+}
+
+domain_decomposition partition_load_balance(
+    const recipe& rec,
+    const context& ctx,
+    const cell_cost_function& cell_cost,
+    partition_hint_map hint_map)
+{
+    struct partition_gid_domain {
+        partition_gid_domain(gathered_vector<cell_gid_type> divs, unsigned domains):
+            gids_by_rank(std::move(divs)), num_domains(domains)
+        {}
+
+        int operator()(cell_gid_type gid) const {
+            using namespace util;
+            auto rank_part = partition_view(gids_by_rank.partition());
+            for (auto i: count_along(rank_part)) {
+                if (binary_search_index(subrange_view(gids_by_rank.values(), rank_part[i]), gid)) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        const gathered_vector<cell_gid_type> gids_by_rank;
+        unsigned num_domains;
+    };
+
+    using util::make_span;
+
+    unsigned num_domains = ctx->distributed->size();
+    unsigned domain_id = ctx->distributed->id();
+    auto num_global_cells = rec.num_cells();
+
+    // Global load balance
+
+    // The gids are split into contiguous ranges. With equal costs, the
+    // first num_global_cells%num_domains domains take one more cell than
+    // the others. Otherwise each domain in turn takes gids while its cost
+    // is nearer to the mean cost of the remaining gids over the remaining
+    // domains with the next gid than without it.
+    global_cell_costs costs(rec, ctx, cell_cost);
+
+    std::vector<cell_gid_type> gid_divisions = {0};
+    if (costs.uniform()) {
+        gid_divisions = equal_gid_divisions(num_global_cells, num_domains);
+    }
+    else {
+        double remaining = 0;
+        for (auto gid: make_span(num_global_cells)) {
+            remaining += costs[gid];
+        }
+        double dom_cost = 0;
+        for (auto gid: make_span(num_global_cells)) {
+            auto d = gid_divisions.size()-1;
+            if (d+1<num_domains && gid>gid_divisions.back() && dom_cost+costs[gid]/2>remaining/(num_domains-d)) {
+                gid_divisions.push_back(gid);
+                remaining -= dom_cost;
+                dom_cost = 0;
+            }
+            dom_cost += costs[gid];
+        }
+        gid_divisions.resize(num_domains+1, num_global_cells);
+    }
+    auto gid_part = util::partition_view(gid_divisions);
+
+    // Local load balance
+
+    auto first = gid_part[domain_id].first;
+    std::vector<cell_gid_type> candidates(gid_part[domain_id].second-first);
+    std::iota(candidates.begin(), candidates.end(), first);
+    auto local = partition_local_cells(rec, ctx, candidates,
+        [first](cell_gid_type gid) { return gid>=first; }, costs, hint_map);
+
+    // Exchange gid list with all other nodes
 
     // global all-to-all to gather a local copy of the global gid list on each node.
-    auto global_gids = ctx->distributed->gather_gids(local_gids);
+    auto global_gids = ctx->distributed->gather_gids(local.gids);
 
     domain_decomposition d;
     d.num_domains = num_domains;
     d.domain_id = domain_id;
-    d.num_local_cells = num_local_cells;
+    d.num_local_cells = local.gids.size();
     d.num_global_cells = num_global_cells;
-    d.groups = std::move(groups);
+    d.groups = std::move(local.groups);
     d.gid_domain = partition_gid_domain(std::move(global_gids), num_domains);
 
     return d;
 }
 
+domain_decomposition partition_graph_load_balance(
+    const recipe& rec,
+    const context& ctx,
+    partition_hint_map hint_map)
+{
+    return partition_graph_load_balance(
+        rec, ctx, [&rec](cell_gid_type gid) { return rec.get_cell_cost(gid); }, std::move(hint_map));
+}
+
+domain_decomposition partition_graph_load_balance(
+    const recipe& rec,
+    const context& ctx,
+    const cell_cost_function& cell_cost,
+    partition_hint_map hint_map)
+{
+    using util::make_span;
+
+    unsigned num_domains = ctx->distributed->size();
+    unsigned domain_id = ctx->distributed->id();
+    auto num_global_cells = rec.num_cells();
+
+    global_cell_costs costs(rec, ctx, cell_cost);
+
+    // Cells connected by gap junctions must be on the same domain: they are
+    // contracted into one vertex of the graph. The root of each set of
+    // connected cells is its lowest gid.
+    std::vector<cell_gid_type> root(num_global_cells);
+    std::iota(root.begin(), root.end(), 0u);
+    auto find = [&root](cell_gid_type gid) {
+        while (root[gid]!=gid) {
+            gid = root[gid] = root[root[gid]];
+        }
+        return gid;
+    };
+
+    for (auto gid: make_span(num_global_cells)) {
+        for (auto& c: rec.gap_junctions_on(gid)) {
+            if (c.local.gid>=num_global_cells || c.peer.gid>=num_global_cells) {
+                throw bad_cell_description(rec.get_cell_kind(gid), gid);
+            }
+            auto a = find(c.local.gid);
+            auto b = find(c.peer.gid);
+            if (a<b) root[b] = a;
+            else root[a] = b;
+        }
+    }
+
+    std::vector<unsigned> vertex(num_global_cells);
+    std::vector<double> vertex_weights;
+    for (auto gid: make_span(num_global_cells)) {
+        auto r = find(gid);
+        if (r==gid) {
+            vertex[gid] = vertex_weights.size();
+            vertex_weights.push_back(0);
+        }
+        else {
+            vertex[gid] = vertex[r];
+        }
+        vertex_weights[vertex[gid]] += costs[gid];
+    }
+
+    // An edge for each connection; the spikes of a cell are sent once to
+    // each domain with a target of the cell, so the edge cut approximates
+    // the spike traffic between domains.
+    std::vector<std::pair<unsigned, unsigned>> edges;
+    for (auto gid: make_span(num_global_cells)) {
+        for (auto& c: rec.connections_on(gid)) {
+            if (c.source.gid<num_global_cells) {
+                edges.push_back({vertex[c.source.gid], vertex[gid]});
+            }
+        }
+    }
+
+    auto part = partition_graph(make_weighted_graph(std::move(vertex_weights), edges), num_domains);
+
+    auto domains = std::make_shared<std::vector<int>>(num_global_cells);
+    std::vector<cell_gid_type> candidates;
+    for (auto gid: make_span(num_global_cells)) {
+        auto dom = part[vertex[gid]];
+        (*domains)[gid] = dom;
+        if (dom==domain_id) {
+            candidates.push_back(gid);
+        }
+    }
+
+    // Local load balance
+
+    auto local = partition_local_cells(rec, ctx, candidates,
+        [](cell_gid_type) { return true; }, costs, hint_map);
+
+    domain_decomposition d;
+    d.num_domains = num_domains;
+    d.domain_id = domain_id;
+    d.num_local_cells = local.gids.size();
+    d.num_global_cells = num_global_cells;
+    d.groups = std::move(local.groups);
+    d.gid_domain = [domains](cell_gid_type gid) {
+        return gid<domains->size()? (*domains)[gid]: -1;
+    };
+
+    return d;
+}
+
 } // namespace arb
 
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/recipe.hpp>
+#include <arbor/sampling.hpp>
+#include <arbor/simd/simd.hpp>
+#include <arbor/spike.hpp>
+#include <arbor/util/any.hpp>
+
+#include "cell_chunks.hpp"
+#include "cell_group.hpp"
+#include "profile/profiler_macro.hpp"
+#include "util/span.hpp"
+
+namespace arb {
+
+// A cell group of point neurons without a closed form solution between
+// events, integrated with fixed time steps.
+//
+// The Model type holds the parameters and state of the cells in SoA arrays,
+// and provides:
+//
+//   Model::cell_type            The cell description returned by the recipe.
+//   Model::kind                 The cell_kind of the cells.
+//   m.resize(n)                 Allocate n cells with default parameters.
+//   m.set_cell(i, c)            Set the parameters of cell i from description c.
+//   m.reset()                   Set the state of the cells to their initial values.
+//   m.step<W>(i, t, h, x, s)    Advance cells [i, i+W) from time t to t+h in
+//                               vector operations, then add the jumps x[k] to
+//                               the membrane potentials. Cells that reach
+//                               threshold are reset, and flagged in s[k].
+//
+// The time steps of an epoch are of equal length, no longer than dt. The
+// events of a cell in a step are summed and applied at the end of the step,
+// and a cell that reaches threshold spikes at the end of the step. Cells
+// are advanced in chunks of cells, which are advanced in parallel.
+
+template <typename Model>
+class point_cell_group: public cell_group {
+public:
+    using value_type = double;
+    using cell_type = typename Model::cell_type;
+
+    static constexpr int simd_width = std::max(4, simd::simd_abi::native_width<value_type>::value);
+
+    point_cell_group() = default;
+
+    point_cell_group(const std::vector<cell_gid_type>& gids, const recipe& rec, task_system_handle threads = {}):
+        gids_(gids),
+        chunks_(gids.size()),
+        threads_(std::move(threads))
+    {
+        // Padding cells have default parameters and no events, and their
+        // spikes are discarded.
+        auto n_padded = (gids_.size()+simd_width-1)/simd_width*simd_width;
+        model_.resize(n_padded);
+        input_.assign(n_padded, 0);
+        next_event_.assign(gids_.size(), 0);
+
+        for (auto lid: util::make_span(gids_.size())) {
+            auto gid = gids_[lid];
+            try {
+                model_.set_cell(lid, util::any_cast<cell_type>(rec.get_cell_description(gid)));
+            }
+            catch (util::bad_any_cast&) {
+                throw bad_cell_description(Model::kind, gid);
+            }
+        }
+
+        reset();
+    }
+
+    cell_kind get_cell_kind() const override {
+        return Model::kind;
+    }
+
+    void reset() override {
+        spikes_.clear();
+        model_.reset();
+        t_ = 0;
+    }
+
+    void set_binning_policy(binning_kind policy, time_type bin_interval) override {}
+
+    void advance(epoch ep, time_type dt, const event_lane_subrange& event_lanes) override {
+        PE(advance_point);
+        if (ep.tfinal>t_) {
+            // Steps of equal length spanning the epoch; the tolerance
+            // avoids a short extra step due to rounding of dt.
+            value_type t0 = t_;
+            value_type span = ep.tfinal-t0;
+            auto n_steps = std::max(1.0, std::ceil(span/dt-1e-6));
+            value_type h = span/n_steps;
+
+            chunks_.advance(threads_, spikes_,
+                [&](std::size_t begin, std::size_t end, std::vector<spike>& spikes) {
+                    advance_chunk(begin, end, t0, h, std::size_t(n_steps), event_lanes, spikes);
+                });
+            t_ = ep.tfinal;
+        }
+        PL();
+    }
+
+    const std::vector<spike>& spikes() const override {
+        return spikes_;
+    }
+
+    void clear_spikes() override {
+        spikes_.clear();
+    }
+
+    // Sampling of the cell state is not supported. Samplers are added to
+    // every cell group, whatever its kind, so they are ignored rather than
+    // rejected.
+    void add_sampler(sampler_association_handle, cell_member_predicate, schedule, sampler_function, sampling_policy) override {}
+    void add_bulk_sampler(sampler_association_handle, cell_member_predicate, schedule, bulk_sampler_function, sampling_policy) override {}
+    void remove_sampler(sampler_association_handle) override {}
+    void remove_all_samplers() override {}
+
+private:
+    // Advances the cells [begin, end) of a chunk by n_steps steps of length
+    // h from t0, appending their spikes to spikes; begin is a multiple of
+    // simd_width.
+    void advance_chunk(
+        std::size_t begin, std::size_t end, value_type t0, value_type h, std::size_t n_steps,
+        const event_lane_subrange& event_lanes, std::vector<spike>& spikes)
+    {
+        constexpr std::size_t W = simd_width;
+        auto end_padded = (end+W-1)/W*W;
+        bool crossed[W];
+
+        for (auto lid: util::make_span(begin, end)) {
+            next_event_[lid] = 0;
+        }
+
+        for (std::size_t s = 0; s<n_steps; ++s) {
+            value_type t = t0+s*h;
+            value_type t_next = t0+(s+1)*h;
+
+            // Sum the weights of the events of each cell in the step; there
+            // are no event lanes if no cell has events in the epoch.
+            for (auto lid: util::make_span(begin, end)) {
+                value_type x = 0;
+                if (event_lanes.size()) {
+                    const auto& lane = event_lanes[lid];
+                    auto& i = next_event_[lid];
+                    for (; i<lane.size() && lane[i].time<t_next; ++i) {
+                        x += lane[i].weight;
+                    }
+                }
+                input_[lid] = x;
+            }
+
+            for (std::size_t b = begin; b<end_padded; b += W) {
+                model_.template step<W>(b, t, h, input_.data()+b, crossed);
+
+                for (std::size_t k = 0; k<W; ++k) {
+                    if (crossed[k] && b+k<end) {
+                        spikes.push_back({{gids_[b+k], 0}, time_type(t_next)});
+                    }
+                }
+            }
+        }
+    }
+
+    // List of the gids of the cells in the group.
+    std::vector<cell_gid_type> gids_;
+
+    // Parameters and state of the cells.
+    Model model_;
+
+    // Summed event weights of the current step, by cell.
+    std::vector<value_type> input_;
+
+    // Index of the next event to deliver, by cell.
+    std::vector<std::size_t> next_event_;
+
+    // Time to which the cells have been advanced.
+    time_type t_ = 0;
+
+    // Spikes that are generated (not necessarily sorted).
+    std::vector<spike> spikes_;
+
+    // Chunks of cells advanced as one task.
+    cell_chunks chunks_;
+
+    task_system_handle threads_;
+};
+
+} // namespace arb
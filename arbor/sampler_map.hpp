@@ -24,6 +24,11 @@ struct sampler_association {
     schedule sched;
     sampler_function sampler;
     std::vector<cell_member_type> probe_ids;
+
+    // For bulk sampler associations, in place of sampler: the bulk sampler,
+    // and the tags of the probes in probe_ids.
+    bulk_sampler_function bulk_sampler;
+    std::vector<probe_tag> probe_tags;
 };
 
 // Maintain a set of associations paired with handles used for deletion.
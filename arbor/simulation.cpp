@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
 #include <memory>
 #include <set>
 #include <vector>
@@ -12,8 +16,10 @@
 #include "cell_group.hpp"
 #include "cell_group_factory.hpp"
 #include "communication/communicator.hpp"
+#include "event_calendar.hpp"
 #include "execution_context.hpp"
 #include "merge_events.hpp"
+#include "spike_export_queue.hpp"
 #include "thread_private_spike_store.hpp"
 #include "threading/threading.hpp"
 #include "util/double_buffer.hpp"
@@ -33,8 +39,8 @@ public:
     // integration interval.
     //
     // To overlap communication and computation, integration intervals of
-    // size Delta/2 are used, where Delta is the minimum delay in the global
-    // system.
+    // size Delta/(p+1) are used, where Delta is the minimum delay in the
+    // global system and p is the exchange pipeline depth.
     // From the frame of reference of the current integration period we
     // define three intervals: previous, current and future
     // Then we define the following :
@@ -60,6 +66,9 @@ public:
     sampler_association_handle add_sampler(cell_member_predicate probe_ids,
         schedule sched, sampler_function f, sampling_policy policy = sampling_policy::lax);
 
+    sampler_association_handle add_bulk_sampler(cell_member_predicate probe_ids,
+        schedule sched, bulk_sampler_function f, sampling_policy policy = sampling_policy::lax);
+
     void remove_sampler(sampler_association_handle);
 
     void remove_all_samplers();
@@ -68,10 +77,42 @@ public:
         return communicator_.num_spikes();
     }
 
+    std::unordered_map<cell_gid_type, double> cell_costs() const;
+
     void set_binning_policy(binning_kind policy, time_type bin_interval);
 
+    void set_spike_exchange(spike_exchange_kind kind) {
+        communicator_.set_exchange_kind(kind);
+    }
+
+    void set_exchange_pipeline_depth(unsigned depth) {
+        exchange_depth_ = std::max(depth, 1u);
+    }
+
+    void set_spike_compression(bool compress) {
+        communicator_.set_spike_compression(compress);
+    }
+
     void inject_events(const pse_vector& events);
 
+    void set_async_spike_export(std::size_t max_spikes) {
+        if (max_spikes) {
+            export_queue_.reset(new spike_export_queue(max_spikes));
+        }
+        else {
+            export_queue_.reset();
+        }
+    }
+
+    // Queued exports refer to the callbacks: complete them before a
+    // callback is replaced.
+    void set_export_callback(spike_export_function& callback, spike_export_function f) {
+        if (export_queue_) {
+            export_queue_->flush();
+        }
+        callback = std::move(f);
+    }
+
     spike_export_function global_export_callback_;
     spike_export_function local_export_callback_;
 
@@ -80,6 +121,16 @@ private:
     // See comments on implementation for more information.
     void setup_events(time_type t_from, time_type time_to, std::size_t epoch_id);
 
+    // Call f with spikes, or queue the call if export is asynchronous.
+    void export_spikes(const spike_export_function& f, const std::vector<spike>& spikes) {
+        if (export_queue_) {
+            export_queue_->push(f, spikes);
+        }
+        else {
+            f(spikes);
+        }
+    }
+
     std::vector<pse_vector>& event_lanes(std::size_t epoch_id) {
         return event_lanes_[epoch_id%2];
     }
@@ -89,8 +140,16 @@ private:
 
     time_type t_ = 0.;
     time_type min_delay_;
+
+    // Maximum number of spike exchanges in flight.
+    unsigned exchange_depth_ = 1;
     std::vector<cell_group_ptr> cell_groups_;
 
+    // The gids of the cells of each cell group, and the wall time spent
+    // advancing each cell group [s].
+    std::vector<std::vector<cell_gid_type>> group_gids_;
+    std::vector<double> group_time_;
+
     // one set of event_generators for each local cell
     std::vector<std::vector<event_generator>> event_generators_;
 
@@ -103,10 +162,17 @@ private:
 
     task_system_handle task_system_;
 
+    // Queue of spike exports for a dedicated thread, if asynchronous.
+    std::unique_ptr<spike_export_queue> export_queue_;
+
     // Pending events to be delivered.
     std::array<std::vector<pse_vector>, 2> event_lanes_;
     std::vector<pse_vector> pending_events_;
 
+    // Events due after the epoch of the most recently set up event lanes,
+    // one calendar queue for each local cell.
+    std::vector<event_calendar> event_calendars_;
+
     // Sampler associations handles are managed by a helper class.
     util::handle_set<sampler_association_handle> sassoc_handles_;
 
@@ -159,11 +225,14 @@ simulation_state::simulation_state(
 
     // Generate the cell groups in parallel, with one task per cell group.
     cell_groups_.resize(decomp.groups.size());
+    group_gids_.resize(decomp.groups.size());
+    group_time_.assign(decomp.groups.size(), 0);
     foreach_group_index(
         [&](cell_group_ptr& group, int i) {
             const auto& group_info = decomp.groups[i];
             auto factory = cell_kind_implementation(group_info.kind, group_info.backend, ctx);
             group = factory(group_info.gids, rec);
+            group_gids_[i] = group_info.gids;
         });
 
     // Create event lane buffers.
@@ -171,6 +240,7 @@ simulation_state::simulation_state(
     // For each epoch there is one lane for each cell in the cell group.
     event_lanes_[0].resize(num_local_cells);
     event_lanes_[1].resize(num_local_cells);
+    event_calendars_.resize(num_local_cells);
 }
 
 void simulation_state::reset() {
@@ -198,8 +268,14 @@ void simulation_state::reset() {
         lane.clear();
     }
 
+    for (auto& calendar: event_calendars_) {
+        calendar.clear();
+    }
+
     communicator_.reset();
 
+    std::fill(group_time_.begin(), group_time_.end(), 0.);
+
     local_spikes_->current().clear();
     local_spikes_->previous().clear();
 }
@@ -208,16 +284,40 @@ time_type simulation_state::run(time_type tfinal, time_type dt) {
     // Calculate the size of the largest possible time integration interval
     // before communication of spikes is required.
     // If spike exchange and cell update are serialized, this is the
-    // minimum delay of the network, however we use half this period
+    // minimum delay of the network, however we use a fraction of this period
     // to overlap communication and computation.
-    const time_type t_interval = min_delay_/2;
+    //
+    // The spikes of each interval are exchanged during the next interval.
+    // With a pipeline of depth p, the exchange of the spikes of interval k
+    // need only complete at the end of interval k+p, before the events for
+    // interval k+p+1 are set up, so the interval is Delta/(p+1).
+    // The depth is reduced if this would give an interval shorter than dt.
+    unsigned depth = exchange_depth_;
+    while (depth>1 && min_delay_/(depth+1)<dt) {
+        --depth;
+    }
+    const time_type t_interval = min_delay_/(depth+1);
+
+    // Bucket future events by integration interval, with enough buckets
+    // to hold the events of the longest local delay, up to a maximum:
+    // events due later wait in the overflow list of the calendar.
+    {
+        const std::size_t max_buckets = 32;
+        const std::size_t n_buckets = std::min<std::size_t>(
+            max_buckets, std::ceil(communicator_.max_local_delay()/t_interval)+2);
+        threading::parallel_for::apply(0, event_calendars_.size(), task_system_.get(),
+            threading::partitioner(threading::partition_kind::static_blocks, 256),
+            [&](cell_size_type i) { event_calendars_[i].set_intervals(t_, t_interval, n_buckets); });
+    }
 
     // task that updates cell state in parallel.
     auto update_cells = [&] () {
         foreach_group_index(
             [&](cell_group_ptr& group, int i) {
                 auto queues = util::subrange_view(event_lanes(epoch_.id), communicator_.group_queue_range(i));
+                auto start = std::chrono::steady_clock::now();
                 group->advance(epoch_, dt, queues);
+                group_time_[i] += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
 
                 PE(advance_spikes);
                 local_spikes_->current().insert(group->spikes());
@@ -226,28 +326,56 @@ time_type simulation_state::run(time_type tfinal, time_type dt) {
             });
     };
 
-    // task that performs spike exchange with the spikes generated in
-    // the previous integration period, generating the postsynaptic
-    // events that must be delivered at the start of the next
-    // integration period at the latest.
-    auto exchange = [&] () {
+    // Exchanges that have been started but not completed, oldest first.
+    std::deque<spike_gather_request> in_flight;
+
+    // Start the exchange of the spikes generated in the previous integration
+    // period.
+    auto start_exchange = [&] () {
         PE(communication_exchange_gatherlocal);
         auto local_spikes = local_spikes_->previous().gather();
         PL();
-        auto global_spikes = communicator_.exchange(local_spikes);
 
         PE(communication_spikeio);
         if (local_export_callback_) {
-            local_export_callback_(local_spikes);
+            export_spikes(local_export_callback_, local_spikes);
         }
+        PL();
+
+        in_flight.push_back(communicator_.start_exchange(std::move(local_spikes)));
+    };
+
+    // Complete the oldest exchange in flight, generating the postsynaptic
+    // events of the spikes received.
+    auto finish_exchange = [&] () {
+        auto global_spikes = communicator_.finish_exchange(in_flight.front());
+        in_flight.pop_front();
+
+        PE(communication_spikeio);
         if (global_export_callback_) {
-            global_export_callback_(global_spikes.values());
+            export_spikes(global_export_callback_, global_spikes.values());
         }
         PL();
 
         PE(communication_walkspikes);
         communicator_.make_event_queues(global_spikes, pending_events_);
         PL();
+    };
+
+    // task that performs spike exchange with the spikes generated in
+    // the previous integration period, and completes the exchange
+    // started depth-1 periods before, generating the postsynaptic
+    // events that must be delivered at the start of the next
+    // integration period at the latest.
+    auto exchange = [&] () {
+        start_exchange();
+        if (in_flight.size()>=depth) {
+            finish_exchange();
+        }
+        // Make progress on the exchanges that remain in flight.
+        for (auto& request: in_flight) {
+            request.test();
+        }
 
         const auto t0 = epoch_.tfinal;
         const auto t1 = std::min(tfinal, t0+t_interval);
@@ -277,9 +405,23 @@ time_type simulation_state::run(time_type tfinal, time_type dt) {
         epoch_.advance(tuntil);
     }
 
-    // Run the exchange one last time to ensure that all spikes are output to file.
+    // Run the exchange one last time and complete all exchanges in flight
+    // to ensure that all spikes are output to file.
+    // The spikes in the current buffer have already been exchanged: clear
+    // them, so that they are not exchanged again by a subsequent call to run.
     local_spikes_->exchange();
-    exchange();
+    local_spikes_->current().clear();
+    start_exchange();
+    while (!in_flight.empty()) {
+        finish_exchange();
+    }
+    setup_events(epoch_.tfinal, epoch_.tfinal, epoch_.id);
+
+    if (export_queue_) {
+        PE(communication_spikeio);
+        export_queue_->flush();
+        PL();
+    }
 
     return t_;
 }
@@ -296,11 +438,11 @@ auto split_sorted_range(Seq&& seq, const Value& v, Less cmp = Less{}) {
 // Populate the event lanes for epoch+1 (i.e event_lanes_[epoch+1)]
 // Update each lane in parallel, if supported by the threading backend.
 // On completion event_lanes[epoch+1] will contain sorted lists of events with
-// delivery times due in or after epoch+1. The events will be taken from the
-// following sources:
-//      event_lanes[epoch]: take all events ≥ t_from
+// delivery times due in epoch+1, that is in [t_from, t_to). The pending events
+// are added to the event calendar of their cell, which holds the events due
+// in later epochs. The events will be taken from the following sources:
+//      event_calendars   : take all events < t_to
 //      event_generators  : take all events < t_to
-//      pending_events    : take all events
 
 // merge_cell_events() is a separate function for unit testing purposes.
 void merge_cell_events(
@@ -355,17 +497,26 @@ void merge_cell_events(
 
 void simulation_state::setup_events(time_type t_from, time_type t_to, std::size_t epoch) {
     const auto n = communicator_.num_local_cells();
+    // The cost per cell is small and varies with the number of events, so
+    // use chunks of cells with guided scheduling rather than a task per cell.
     threading::parallel_for::apply(0, n, task_system_.get(),
+        threading::partitioner(threading::partition_kind::guided, 16),
         [&](cell_size_type i) {
+            auto& pending = pending_events_[i];
+            auto& lane = event_lanes(epoch+1)[i];
+
             PE(communication_enqueue_sort);
-            util::sort(pending_events_[i]);
+            event_calendars_[i].push(pending);
+            event_calendars_[i].pop_until(t_to, pending);
             PL();
 
-            event_span pending = util::range_pointer_view(pending_events_[i]);
-            event_span old_events = util::range_pointer_view(event_lanes(epoch)[i]);
-
-            merge_cell_events(t_from, t_to, old_events, pending, event_generators_[i], event_lanes(epoch+1)[i]);
-            pending_events_[i].clear();
+            if (event_generators_[i].empty()) {
+                std::swap(pending, lane);
+            }
+            else {
+                merge_cell_events(t_from, t_to, {}, util::range_pointer_view(pending), event_generators_[i], lane);
+            }
+            pending.clear();
             });
 }
 
@@ -383,6 +534,20 @@ sampler_association_handle simulation_state::add_sampler(
     return h;
 }
 
+sampler_association_handle simulation_state::add_bulk_sampler(
+        cell_member_predicate probe_ids,
+        schedule sched,
+        bulk_sampler_function f,
+        sampling_policy policy)
+{
+    sampler_association_handle h = sassoc_handles_.acquire();
+
+    foreach_group(
+        [&](cell_group_ptr& group) { group->add_bulk_sampler(h, probe_ids, sched, f, policy); });
+
+    return h;
+}
+
 void simulation_state::remove_sampler(sampler_association_handle h) {
     foreach_group(
         [h](cell_group_ptr& group) { group->remove_sampler(h); });
@@ -402,6 +567,17 @@ void simulation_state::set_binning_policy(binning_kind policy, time_type bin_int
         [&](cell_group_ptr& group) { group->set_binning_policy(policy, bin_interval); });
 }
 
+std::unordered_map<cell_gid_type, double> simulation_state::cell_costs() const {
+    std::unordered_map<cell_gid_type, double> costs;
+    for (auto i: util::count_along(group_gids_)) {
+        const auto& gids = group_gids_[i];
+        for (auto gid: gids) {
+            costs[gid] = group_time_[i]/gids.size();
+        }
+    }
+    return costs;
+}
+
 void simulation_state::inject_events(const pse_vector& events) {
     // Push all events that are to be delivered to local cells into the
     // pending event list for the event's target cell.
@@ -443,6 +619,15 @@ sampler_association_handle simulation::add_sampler(
     return impl_->add_sampler(std::move(probe_ids), std::move(sched), std::move(f), policy);
 }
 
+sampler_association_handle simulation::add_bulk_sampler(
+    cell_member_predicate probe_ids,
+    schedule sched,
+    bulk_sampler_function f,
+    sampling_policy policy)
+{
+    return impl_->add_bulk_sampler(std::move(probe_ids), std::move(sched), std::move(f), policy);
+}
+
 void simulation::remove_sampler(sampler_association_handle h) {
     impl_->remove_sampler(h);
 }
@@ -455,16 +640,36 @@ std::size_t simulation::num_spikes() const {
     return impl_->num_spikes();
 }
 
+std::unordered_map<cell_gid_type, double> simulation::cell_costs() const {
+    return impl_->cell_costs();
+}
+
 void simulation::set_binning_policy(binning_kind policy, time_type bin_interval) {
     impl_->set_binning_policy(policy, bin_interval);
 }
 
+void simulation::set_spike_exchange(spike_exchange_kind kind) {
+    impl_->set_spike_exchange(kind);
+}
+
+void simulation::set_exchange_pipeline_depth(unsigned depth) {
+    impl_->set_exchange_pipeline_depth(depth);
+}
+
+void simulation::set_spike_compression(bool compress) {
+    impl_->set_spike_compression(compress);
+}
+
 void simulation::set_global_spike_callback(spike_export_function export_callback) {
-    impl_->global_export_callback_ = std::move(export_callback);
+    impl_->set_export_callback(impl_->global_export_callback_, std::move(export_callback));
 }
 
 void simulation::set_local_spike_callback(spike_export_function export_callback) {
-    impl_->local_export_callback_ = std::move(export_callback);
+    impl_->set_export_callback(impl_->local_export_callback_, std::move(export_callback));
+}
+
+void simulation::set_async_spike_export(std::size_t max_spikes) {
+    impl_->set_async_spike_export(max_spikes);
 }
 
 void simulation::inject_events(const pse_vector& events) {
@@ -0,0 +1,86 @@
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arbor/simulation.hpp>
+#include <arbor/spike.hpp>
+
+#include "spike_export_queue.hpp"
+
+namespace arb {
+
+spike_export_queue::spike_export_queue(std::size_t max_spikes):
+    max_spikes_(max_spikes),
+    thread_([this] { run(); })
+{}
+
+spike_export_queue::~spike_export_queue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    queued_.notify_one();
+    thread_.join();
+}
+
+void spike_export_queue::push(const spike_export_function& f, std::vector<spike> spikes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return error_ || n_queued_==0 || n_queued_+spikes.size()<=max_spikes_; });
+    rethrow_error();
+
+    n_queued_ += spikes.size();
+    queue_.push_back({&f, std::move(spikes)});
+    queued_.notify_one();
+}
+
+void spike_export_queue::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&] { return error_ || (queue_.empty() && !busy_); });
+    rethrow_error();
+}
+
+// Called with mutex_ held.
+void spike_export_queue::rethrow_error() {
+    if (error_) {
+        auto e = error_;
+        error_ = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void spike_export_queue::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        queued_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) break;
+
+        entry e = std::move(queue_.front());
+        queue_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        std::exception_ptr err;
+        try {
+            (*e.f)(e.spikes);
+        }
+        catch (...) {
+            err = std::current_exception();
+        }
+
+        lock.lock();
+        busy_ = false;
+        n_queued_ -= e.spikes.size();
+        if (err) {
+            error_ = err;
+            for (auto& q: queue_) {
+                n_queued_ -= q.spikes.size();
+            }
+            queue_.clear();
+        }
+        done_.notify_all();
+    }
+}
+
+} // namespace arb
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <arbor/simulation.hpp>
+#include <arbor/spike.hpp>
+
+namespace arb {
+
+// Calls spike export functions on a dedicated thread, so that slow exports
+// do not hold up spike exchange.
+//
+// At most max_spikes spikes are queued for export: push waits until there
+// is room, unless the queue is empty, so that memory use is bounded and a
+// simulation cannot run arbitrarily far ahead of its exports.
+//
+// An exception thrown by an export function is rethrown by the next call
+// to push or flush, and the exports queued after it are discarded.
+
+class spike_export_queue {
+public:
+    explicit spike_export_queue(std::size_t max_spikes);
+
+    spike_export_queue(const spike_export_queue&) = delete;
+    spike_export_queue& operator=(const spike_export_queue&) = delete;
+
+    // Completes the queued exports.
+    ~spike_export_queue();
+
+    // Queue a call of f with spikes. The queue refers to f rather than
+    // copying it, so that the state of a stateful f is kept between calls:
+    // f must not be modified or destroyed until the export is complete.
+    void push(const spike_export_function& f, std::vector<spike> spikes);
+
+    // Wait for all queued exports to complete.
+    void flush();
+
+private:
+    struct entry {
+        const spike_export_function* f;
+        std::vector<spike> spikes;
+    };
+
+    std::size_t max_spikes_;
+
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable done_;
+
+    // Guarded by mutex_:
+    std::deque<entry> queue_;
+    std::size_t n_queued_ = 0;  // Spikes in queue, including any being exported.
+    bool busy_ = false;
+    bool stop_ = false;
+    std::exception_ptr error_;
+
+    // Started last, once the state above is initialized.
+    std::thread thread_;
+
+    void run();
+    void rethrow_error();
+};
+
+} // namespace arb
@@ -0,0 +1,110 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/spike.hpp>
+#include <arbor/spike_file.hpp>
+
+#include "util/strprintf.hpp"
+
+namespace arb {
+
+using util::pprintf;
+
+namespace {
+
+const char spike_magic[8] = {'A', 'R', 'B', 'S', 'P', 'I', 'K', 'E'};
+const std::uint32_t spike_version = 1;
+
+struct spike_file_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t padding;
+};
+
+struct spike_record {
+    std::uint32_t gid;
+    std::uint32_t index;
+    float time;
+};
+
+static_assert(sizeof(spike_record)==12, "unexpected padding in spike_record");
+
+} // anonymous namespace
+
+struct spike_file_writer::impl {
+    std::string path;
+    std::ofstream out;
+    std::vector<spike_record> buffer;
+
+    explicit impl(const std::string& path):
+        path(path),
+        out(path, std::ios::binary|std::ios::trunc)
+    {
+        spike_file_header h;
+        std::memcpy(h.magic, spike_magic, sizeof(spike_magic));
+        h.version = spike_version;
+        h.padding = 0;
+
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        check();
+    }
+
+    void check() {
+        if (!out) {
+            throw spike_file_error(path, "unable to write spike file");
+        }
+    }
+};
+
+spike_file_writer::spike_file_writer(const std::string& path):
+    impl_(std::make_shared<impl>(path))
+{}
+
+void spike_file_writer::operator()(const std::vector<spike>& spikes) {
+    auto& buffer = impl_->buffer;
+    buffer.clear();
+    for (auto& s: spikes) {
+        buffer.push_back({s.source.gid, s.source.index, s.time});
+    }
+
+    impl_->out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size()*sizeof(spike_record));
+    impl_->check();
+}
+
+void spike_file_writer::flush() {
+    impl_->out.flush();
+    impl_->check();
+}
+
+std::vector<spike> read_spike_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw spike_file_error(path, "unable to open spike file");
+    }
+
+    spike_file_header h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) ||
+        std::memcmp(h.magic, spike_magic, sizeof(spike_magic)))
+    {
+        throw spike_file_error(path, "not a spike file");
+    }
+    if (h.version!=spike_version) {
+        throw spike_file_error(path, pprintf("unsupported spike file version {}", h.version));
+    }
+
+    std::vector<spike> spikes;
+    spike_record r;
+    while (in.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+        spikes.push_back({{r.gid, r.index}, r.time});
+    }
+    if (in.gcount()!=0) {
+        throw spike_file_error(path, "truncated spike record");
+    }
+    return spikes;
+}
+
+} // namespace arb
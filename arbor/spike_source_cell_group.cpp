@@ -63,7 +63,12 @@ void spike_source_cell_group::clear_spikes() {
 }
 
 void spike_source_cell_group::add_sampler(sampler_association_handle, cell_member_predicate, schedule, sampler_function, sampling_policy) {
-    std::logic_error("A spike_source_cell group doen't support sampling of internal state!");
+    // Samplers are added to every cell group, and there is no internal
+    // state of a spike_source_cell to sample: ignore them.
+}
+
+void spike_source_cell_group::add_bulk_sampler(sampler_association_handle, cell_member_predicate, schedule, bulk_sampler_function, sampling_policy) {
+    // As for add_sampler.
 }
 
 } // namespace arb
@@ -6,111 +6,264 @@ using namespace arb::threading::impl;
 using namespace arb::threading;
 using namespace arb;
 
-task notification_queue::try_pop() {
-    task tsk;
-    lock q_lock{q_mutex_, std::try_to_lock};
-    if (q_lock && !q_tasks_.empty()) {
-        tsk = std::move(q_tasks_.front());
-        q_tasks_.pop_front();
+namespace {
+// Deque ownership of the calling thread: set on entry to
+// task_system::run_tasks_loop for worker threads.
+thread_local const task_system* current_system = nullptr;
+thread_local int current_system_index = -1;
+
+// Number of unsuccessful attempts to find work before a worker sleeps.
+constexpr unsigned spin_limit = 64;
+
+struct task_cache {
+    // Upper bound on the number of idle task objects retained per thread.
+    static constexpr std::size_t max_size = 4096;
+
+    std::vector<task*> free;
+
+    ~task_cache() {
+        for (auto t: free) delete t;
     }
+};
+
+task_cache& local_task_cache() {
+    thread_local task_cache cache;
+    return cache;
+}
+} // anonymous namespace
+
+task* arb::threading::impl::acquire_task() {
+    auto& cache = local_task_cache();
+    if (cache.free.empty()) {
+        return new task;
+    }
+    task* tsk = cache.free.back();
+    cache.free.pop_back();
     return tsk;
 }
 
-task notification_queue::pop() {
-    task tsk;
-    lock q_lock{q_mutex_};
-    while (q_tasks_.empty() && !quit_) {
-        q_tasks_available_.wait(q_lock);
+void arb::threading::impl::release_task(task* tsk) {
+    tsk->reset();
+    auto& cache = local_task_cache();
+    if (cache.free.size()<task_cache::max_size) {
+        cache.free.push_back(tsk);
+    }
+    else {
+        delete tsk;
+    }
+}
+
+task_deque::task_deque(std::size_t capacity) {
+    // Capacity must be a power of two.
+    std::int64_t n = 1;
+    while (n<(std::int64_t)capacity) n *= 2;
+
+    buffers_.emplace_back(new ring_buffer(n));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+}
+
+task_deque::ring_buffer* task_deque::grow(ring_buffer* a, std::int64_t top, std::int64_t bottom) {
+    buffers_.emplace_back(new ring_buffer(2*a->capacity));
+    ring_buffer* b = buffers_.back().get();
+    for (auto i = top; i<bottom; ++i) {
+        b->put(i, a->get(i));
     }
-    if (!q_tasks_.empty()) {
-        tsk = std::move(q_tasks_.front());
-        q_tasks_.pop_front();
+    buffer_.store(b, std::memory_order_release);
+    return b;
+}
+
+void task_deque::push(task* tsk) {
+    auto b = bottom_.load(std::memory_order_relaxed);
+    auto t = top_.load(std::memory_order_acquire);
+    auto a = buffer_.load(std::memory_order_relaxed);
+
+    if (b-t>a->capacity-1) {
+        a = grow(a, t, b);
+    }
+    a->put(b, tsk);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b+1, std::memory_order_relaxed);
+}
+
+task* task_deque::pop() {
+    auto b = bottom_.load(std::memory_order_relaxed)-1;
+    auto a = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top_.load(std::memory_order_relaxed);
+
+    task* tsk = nullptr;
+    if (t<=b) {
+        tsk = a->get(b);
+        if (t==b) {
+            // Last element: race against thieves.
+            if (!top_.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                tsk = nullptr;
+            }
+            bottom_.store(b+1, std::memory_order_relaxed);
+        }
+    }
+    else {
+        bottom_.store(b+1, std::memory_order_relaxed);
     }
     return tsk;
 }
 
-bool notification_queue::try_push(task& tsk) {
-    {
-        lock q_lock{q_mutex_, std::try_to_lock};
-        if (!q_lock) return false;
-        q_tasks_.push_back(std::move(tsk));
-        tsk = 0;
+task* task_deque::steal() {
+    auto t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom_.load(std::memory_order_acquire);
+
+    if (t<b) {
+        auto a = buffer_.load(std::memory_order_acquire);
+        task* tsk = a->get(t);
+        if (top_.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return tsk;
+        }
     }
-    q_tasks_available_.notify_all();
-    return true;
+    return nullptr;
 }
 
-void notification_queue::push(task&& tsk) {
-    {
-        lock q_lock{q_mutex_};
-        q_tasks_.push_back(std::move(tsk));
+bool task_deque::empty() const {
+    auto b = bottom_.load(std::memory_order_relaxed);
+    auto t = top_.load(std::memory_order_relaxed);
+    return b<=t;
+}
+
+int task_system::current_index() const {
+    if (current_system==this) return current_system_index;
+    if (std::this_thread::get_id()==owner_id_) return 0;
+    return -1;
+}
+
+void task_system::push(task* tsk) {
+    int i = current_index();
+    if (i>=0) {
+        q_[i].push(tsk);
+    }
+    else {
+        lock q_lock{inject_mutex_};
+        inject_.push_back(tsk);
+        inject_empty_.store(false, std::memory_order_relaxed);
     }
-    q_tasks_available_.notify_all();
+    notify();
 }
 
-void notification_queue::quit() {
-    {
-        lock q_lock{q_mutex_};
-        quit_ = true;
+void task_system::notify() {
+    // Pairs with the increment of sleepers_ in run_tasks_loop: either the
+    // sleeping thread sees the new task, or we see the sleeping thread.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed)) {
+        {
+            lock w_lock{wake_mutex_};
+            ++wake_epoch_;
+        }
+        wake_.notify_one();
     }
-    q_tasks_available_.notify_all();
+}
+
+// Look for a task: first in the deque of thread i (if any), then in the
+// injection queue, then steal from the other threads' deques.
+task* task_system::find_task(int i) {
+    task* tsk = nullptr;
+    if (i>=0 && (tsk = q_[i].pop())) return tsk;
+
+    if (!inject_empty_.load(std::memory_order_relaxed)) {
+        lock q_lock{inject_mutex_};
+        if (!inject_.empty()) {
+            tsk = inject_.front();
+            inject_.pop_front();
+        }
+        inject_empty_.store(inject_.empty(), std::memory_order_relaxed);
+        if (tsk) return tsk;
+    }
+
+    unsigned start = i<0? 0: i+1;
+    for (unsigned n = 0; n!=count_; ++n) {
+        unsigned j = (start+n)%count_;
+        if ((int)j==i) continue;
+        if ((tsk = q_[j].steal())) return tsk;
+    }
+    return nullptr;
+}
+
+void task_system::execute(task* tsk) {
+    (*tsk)();
+    release_task(tsk);
 }
 
 void task_system::run_tasks_loop(int i){
+    current_system = this;
+    current_system_index = i;
+
+    unsigned misses = 0;
     while (true) {
-        task tsk;
-        for (unsigned n = 0; n != count_; n++) {
-            tsk = q_[(i + n) % count_].try_pop();
-            if (tsk) break;
+        if (task* tsk = find_task(i)) {
+            execute(tsk);
+            misses = 0;
+            continue;
+        }
+        if (++misses<spin_limit) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Register as sleeping, then check once more for work before blocking.
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        lock w_lock{wake_mutex_};
+        auto epoch = wake_epoch_;
+        w_lock.unlock();
+
+        task* tsk = find_task(i);
+        if (!tsk) {
+            w_lock.lock();
+            wake_.wait(w_lock, [&]{ return quit_ || wake_epoch_!=epoch; });
+            bool quit = quit_;
+            w_lock.unlock();
+            if (quit) {
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
         }
-        if (!tsk) tsk = q_[i].pop();
-        if (!tsk) break;
-        tsk();
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        misses = 0;
+        if (tsk) execute(tsk);
     }
 }
 
 void task_system::try_run_task() {
-    auto nthreads = get_num_threads();
-    task tsk;
-    for (int n = 0; n != nthreads; n++) {
-        tsk = q_[n % nthreads].try_pop();
-        if (tsk) {
-            tsk();
-            break;
-        }
+    if (task* tsk = find_task(current_index())) {
+        execute(tsk);
     }
 }
 
 // Default construct with one thread.
 task_system::task_system(): task_system(1) {}
 
-task_system::task_system(int nthreads): count_(nthreads), q_(nthreads) {
+task_system::task_system(int nthreads): count_(nthreads) {
     if (nthreads <= 0)
         throw std::runtime_error("Non-positive number of threads in thread pool");
 
+    q_.reset(new task_deque[count_]);
+
     // Main thread
-    auto tid = std::this_thread::get_id();
-    thread_ids_[tid] = 0;
+    owner_id_ = std::this_thread::get_id();
+    thread_ids_[owner_id_] = 0;
 
     for (unsigned i = 1; i < count_; i++) {
         threads_.emplace_back([this, i]{run_tasks_loop(i);});
-        tid = threads_.back().get_id();
+        auto tid = threads_.back().get_id();
         thread_ids_[tid] = i;
     }
 }
 
 task_system::~task_system() {
-    for (auto& e: q_) e.quit();
-    for (auto& e: threads_) e.join();
-}
-
-void task_system::async(task tsk) {
-    auto i = index_++;
-
-    for (unsigned n = 0; n != count_; n++) {
-        if (q_[(i + n) % count_].try_push(tsk)) return;
+    {
+        lock w_lock{wake_mutex_};
+        quit_ = true;
     }
-    q_[i % count_].push(std::move(tsk));
+    wake_.notify_all();
+    for (auto& e: threads_) e.join();
 }
 
 int task_system::get_num_threads() const {
@@ -5,11 +5,13 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
-#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
 #include <utility>
@@ -23,32 +25,180 @@ class task_group;
 using std::mutex;
 using lock = std::unique_lock<mutex>;
 using std::condition_variable;
-using task = std::function<void()>;
 
-namespace impl {
-class notification_queue {
+// Type-erased, move-only nullary callable.
+//
+// Callables that fit in the inline buffer are stored in place, so that
+// constructing a task does not allocate; larger callables fall back to
+// heap storage.
+class task {
+public:
+    static constexpr std::size_t buffer_size = 8*sizeof(void*);
+
+    task() = default;
+
+    template <
+        typename F,
+        typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, task>::value>::type
+    >
+    task(F&& f) {
+        emplace(std::forward<F>(f));
+    }
+
+    task(task&& other) {
+        if (other.ops_) {
+            other.ops_->relocate(&buffer_, &other.buffer_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    task& operator=(task&& other) {
+        if (this!=&other) {
+            reset();
+            if (other.ops_) {
+                other.ops_->relocate(&buffer_, &other.buffer_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task() { reset(); }
+
+    template <typename F>
+    void emplace(F&& f) {
+        using callable = typename std::decay<F>::type;
+        using storage = typename std::conditional<fits_inline<callable>::value,
+              inline_storage<callable>, heap_storage<callable>>::type;
+
+        reset();
+        storage::construct(&buffer_, std::forward<F>(f));
+        ops_ = &storage::ops;
+    }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(&buffer_);
+            ops_ = nullptr;
+        }
+    }
+
+    void operator()() { ops_->invoke(&buffer_); }
+
+    explicit operator bool() const { return ops_; }
+
 private:
-    // FIFO of pending tasks.
-    std::deque<task> q_tasks_;
+    using buffer_type = typename std::aligned_storage<buffer_size, alignof(std::max_align_t)>::type;
+
+    struct task_ops {
+        void (*invoke)(void*);
+        void (*relocate)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
 
-    // Lock and signal on task availability change this is the crucial bit.
-    mutex q_mutex_;
-    condition_variable q_tasks_available_;
+    template <typename F>
+    struct fits_inline: std::integral_constant<bool,
+        sizeof(F)<=buffer_size &&
+        alignof(std::max_align_t)%alignof(F)==0 &&
+        std::is_nothrow_move_constructible<F>::value> {};
 
-    // Flag to handle exit from all threads.
-    bool quit_ = false;
+    template <typename F>
+    struct inline_storage {
+        template <typename F2>
+        static void construct(void* p, F2&& f) { new (p) F(std::forward<F2>(f)); }
+
+        static void invoke(void* p) { (*static_cast<F*>(p))(); }
+        static void relocate(void* dst, void* src) {
+            new (dst) F(std::move(*static_cast<F*>(src)));
+            static_cast<F*>(src)->~F();
+        }
+        static void destroy(void* p) { static_cast<F*>(p)->~F(); }
+
+        static constexpr task_ops ops = {invoke, relocate, destroy};
+    };
+
+    template <typename F>
+    struct heap_storage {
+        template <typename F2>
+        static void construct(void* p, F2&& f) { *static_cast<F**>(p) = new F(std::forward<F2>(f)); }
+
+        static void invoke(void* p) { (**static_cast<F**>(p))(); }
+        static void relocate(void* dst, void* src) { *static_cast<F**>(dst) = *static_cast<F**>(src); }
+        static void destroy(void* p) { delete *static_cast<F**>(p); }
+
+        static constexpr task_ops ops = {invoke, relocate, destroy};
+    };
+
+    buffer_type buffer_;
+    const task_ops* ops_ = nullptr;
+};
+
+template <typename F>
+constexpr task::task_ops task::inline_storage<F>::ops;
 
+template <typename F>
+constexpr task::task_ops task::heap_storage<F>::ops;
+
+namespace impl {
+// Tasks submitted to the task_system are taken from, and on completion returned
+// to, a cache local to the calling thread. Task objects may migrate between
+// thread caches, but each cache is only accessed by its own thread, so in the
+// steady state neither submission nor execution touches the heap.
+task* acquire_task();
+void release_task(task*);
+
+// Chase-Lev work-stealing deque of task pointers.
+//
+// The owning thread pushes and pops at the bottom; any other thread may steal
+// from the top. All operations are lock-free. Storage grows as required;
+// superseded buffers are retained until the deque is destroyed, as a
+// concurrent thief may still be reading from them.
+class task_deque {
 public:
-    // Pops a task from the task queue returns false when queue is empty.
-    task try_pop();
-    task pop();
+    explicit task_deque(std::size_t capacity = 256);
+
+    task_deque(const task_deque&) = delete;
+    task_deque& operator=(const task_deque&) = delete;
+
+    // Owner only.
+    void push(task* tsk);
+    task* pop();
+
+    // Any thread; returns nullptr if empty or if it lost a race with
+    // another thief or the owner.
+    task* steal();
+
+    bool empty() const;
+
+private:
+    struct ring_buffer {
+        explicit ring_buffer(std::int64_t n): capacity(n), mask(n-1), slots(new std::atomic<task*>[n]) {}
+
+        std::int64_t capacity;
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<task*>[]> slots;
+
+        task* get(std::int64_t i) const { return slots[i&mask].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, task* t) { slots[i&mask].store(t, std::memory_order_relaxed); }
+    };
 
-    // Pushes a task into the task queue and increases task group counter.
-    void push(task&& tsk); // TODO: need to use value?
-    bool try_push(task& tsk);
+    ring_buffer* grow(ring_buffer* a, std::int64_t top, std::int64_t bottom);
 
-    // Finish popping all waiting tasks on queue then stop trying to pop new tasks
-    void quit();
+    // Keep top (touched by thieves) and bottom (touched by the owner)
+    // on separate cache lines.
+    std::atomic<std::int64_t> top_{0};
+    char pad_top_[64];
+    std::atomic<std::int64_t> bottom_{0};
+    char pad_bottom_[64];
+    std::atomic<ring_buffer*> buffer_;
+
+    // Owner only: all buffers ever allocated, including the current one.
+    std::vector<std::unique_ptr<ring_buffer>> buffers_;
 };
 }// namespace impl
 
@@ -58,14 +208,35 @@ private:
 
     std::vector<std::thread> threads_;
 
-    // queue of tasks
-    std::vector<impl::notification_queue> q_;
+    // Per-thread work-stealing deques; deque 0 belongs to the thread that
+    // constructed the task_system.
+    std::unique_ptr<impl::task_deque[]> q_;
+
+    // Tasks submitted from threads that do not own a deque.
+    std::deque<task*> inject_;
+    mutex inject_mutex_;
+    std::atomic<bool> inject_empty_{true};
+
+    // Idle worker threads block on wake_ until new tasks are submitted
+    // or the task_system is destroyed.
+    mutex wake_mutex_;
+    condition_variable wake_;
+    std::atomic<unsigned> sleepers_{0};
+    unsigned long wake_epoch_ = 0;
+    bool quit_ = false;
+
+    std::thread::id owner_id_;
 
     // threads -> index
     std::unordered_map<std::thread::id, std::size_t> thread_ids_;
 
-    // total number of tasks pushed in all queues
-    std::atomic<unsigned> index_{0};
+    // Index of the calling thread's deque, or -1 if it owns none.
+    int current_index() const;
+
+    void push(task* tsk);
+    task* find_task(int i);
+    void execute(task* tsk);
+    void notify();
 
 public:
     task_system();
@@ -78,8 +249,14 @@ public:
 
     ~task_system();
 
-    // Pushes tasks into notification queue.
-    void async(task tsk);
+    // Submit a task: it is pushed onto the calling thread's deque,
+    // from which idle threads may steal it.
+    template <typename F>
+    void async(F&& f) {
+        task* tsk = impl::acquire_task();
+        tsk->emplace(std::forward<F>(f));
+        push(tsk);
+    }
 
     // Runs tasks until quit is true.
     void run_tasks_loop(int i);
@@ -157,20 +334,12 @@ public:
                 exception_status_(ex)
         {}
 
-        wrap(wrap&& other):
+        wrap(wrap&& other) noexcept(std::is_nothrow_move_constructible<F>::value):
                 f_(std::move(other.f_)),
                 counter_(other.counter_),
                 exception_status_(other.exception_status_)
         {}
 
-        // std::function is not guaranteed to not copy the contents on move construction,
-        // but the class is safe because we don't call operator() more than once on the same wrapped task.
-        wrap(const wrap& other):
-                f_(other.f_),
-                counter_(other.counter_),
-                exception_status_(other.exception_status_)
-        {}
-
         void operator()() {
             if (!exception_status_) {
                 try {
@@ -219,7 +388,31 @@ public:
 ///////////////////////////////////////////////////////////////////////
 // algorithms
 ///////////////////////////////////////////////////////////////////////
+
+// Scheduling policies for a parallel_for over [left, right) with a given
+// grain size, i.e. the minimum number of consecutive indices per chunk:
+//   static_blocks: the range is split up front into contiguous blocks of
+//                  equal size, at most one per thread, with no fewer than
+//                  grain_size indices per block.
+//   dynamic:       one task per thread; tasks repeatedly claim the next
+//                  grain_size indices until the range is exhausted.
+//   guided:        as dynamic, but each claim takes a share of the remaining
+//                  indices proportional to 1/(number of threads), and no
+//                  fewer than grain_size.
+enum class partition_kind {
+    static_blocks, dynamic, guided
+};
+
+struct partitioner {
+    partition_kind kind = partition_kind::dynamic;
+    int grain_size = 1;
+
+    partitioner() = default;
+    partitioner(partition_kind k, int grain): kind(k), grain_size(grain) {}
+};
+
 struct parallel_for {
+    // One task per index.
     template <typename F>
     static void apply(int left, int right, task_system* ts, F f) {
         task_group g(ts);
@@ -228,6 +421,75 @@ struct parallel_for {
         }
         g.wait();
     }
+
+    // One task per chunk of indices, as determined by the partitioner.
+    template <typename F>
+    static void apply(int left, int right, task_system* ts, partitioner part, F f) {
+        if (right<=left) return;
+
+        const int n = right-left;
+        const int grain = std::max(1, part.grain_size);
+        const int nthreads = ts->get_num_threads();
+        const int nchunks = std::min(nthreads, (n-1)/grain+1);
+
+        // Nothing to distribute: run in the calling thread.
+        if (nchunks==1) {
+            for (int i = left; i < right; ++i) {
+                f(i);
+            }
+            return;
+        }
+
+        task_group g(ts);
+        switch (part.kind) {
+        case partition_kind::static_blocks: {
+            // With at most n/grain blocks, each has at least grain indices.
+            const int nblocks = std::max(1, std::min(nthreads, n/grain));
+            for (int c = 0; c < nblocks; ++c) {
+                const int b = left + (int)((long long)n*c/nblocks);
+                const int e = left + (int)((long long)n*(c+1)/nblocks);
+                g.run([=, &f] {
+                    for (int i = b; i < e; ++i) f(i);
+                });
+            }
+            g.wait();
+            break;
+        }
+        case partition_kind::dynamic: {
+            // The counter is wider than int, as each task overshoots right
+            // by up to grain when claiming its last chunk.
+            std::atomic<long long> next{left};
+            for (int c = 0; c < nchunks; ++c) {
+                g.run([=, &f, &next] {
+                    long long b;
+                    while ((b = next.fetch_add(grain, std::memory_order_relaxed)) < right) {
+                        const int e = (int)std::min<long long>(right, b+grain);
+                        for (int i = (int)b; i < e; ++i) f(i);
+                    }
+                });
+            }
+            g.wait();
+            break;
+        }
+        case partition_kind::guided: {
+            std::atomic<int> next{left};
+            for (int c = 0; c < nchunks; ++c) {
+                g.run([=, &f, &next] {
+                    int b = next.load(std::memory_order_relaxed);
+                    while (b < right) {
+                        const int e = b + std::min(right-b, std::max(grain, (right-b)/(2*nthreads)));
+                        if (next.compare_exchange_weak(b, e, std::memory_order_relaxed)) {
+                            for (int i = b; i < e; ++i) f(i);
+                            b = next.load(std::memory_order_relaxed);
+                        }
+                    }
+                });
+            }
+            g.wait();
+            break;
+        }
+        }
+    }
 };
 } // namespace threading
 
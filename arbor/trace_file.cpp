@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+extern "C" {
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+}
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/sampling.hpp>
+#include <arbor/trace_file.hpp>
+#include <arbor/util/any_ptr.hpp>
+
+#include "util/strprintf.hpp"
+
+namespace arb {
+
+using util::pprintf;
+
+namespace {
+
+const char trace_magic[8] = {'A', 'R', 'B', 'T', 'R', 'A', 'C', 'E'};
+const std::uint32_t trace_version = 1;
+
+struct trace_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t n_probes;
+    std::uint64_t capacity;
+};
+
+struct trace_index_entry {
+    std::uint32_t gid;
+    std::uint32_t index;
+    std::int32_t tag;
+    std::uint32_t padding;
+    std::uint64_t n_samples;
+    std::uint64_t offset;
+};
+
+// A shared memory mapping of a whole file; the file descriptor is not
+// required once the mapping is made.
+
+struct file_mapping {
+    char* base = nullptr;
+    std::size_t size = 0;
+
+    file_mapping() = default;
+
+    // Map the file at path read-only if size is zero, else truncate it to
+    // size bytes and map it for writing.
+    file_mapping(const std::string& path, std::size_t sz) {
+        bool writable = sz>0;
+        int fd = writable? ::open(path.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644): ::open(path.c_str(), O_RDONLY);
+        if (fd<0) {
+            throw trace_file_error(path, std::strerror(errno));
+        }
+
+        if (writable) {
+            if (::ftruncate(fd, sz)) {
+                int err = errno;
+                ::close(fd);
+                throw trace_file_error(path, std::strerror(err));
+            }
+        }
+        else {
+            struct stat st;
+            if (::fstat(fd, &st)) {
+                int err = errno;
+                ::close(fd);
+                throw trace_file_error(path, std::strerror(err));
+            }
+            sz = st.st_size;
+            if (sz<sizeof(trace_header)) {
+                ::close(fd);
+                throw trace_file_error(path, "not a trace file");
+            }
+        }
+
+        void* p = ::mmap(nullptr, sz, writable? PROT_READ|PROT_WRITE: PROT_READ, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if (p==MAP_FAILED) {
+            throw trace_file_error(path, std::strerror(err));
+        }
+
+        base = static_cast<char*>(p);
+        size = sz;
+    }
+
+    file_mapping(file_mapping&& other) {
+        *this = std::move(other);
+    }
+
+    file_mapping& operator=(file_mapping&& other) {
+        std::swap(base, other.base);
+        std::swap(size, other.size);
+        return *this;
+    }
+
+    ~file_mapping() {
+        if (base) {
+            ::munmap(base, size);
+        }
+    }
+
+    trace_header* header() const {
+        return reinterpret_cast<trace_header*>(base);
+    }
+
+    trace_index_entry* index() const {
+        return reinterpret_cast<trace_index_entry*>(base+sizeof(trace_header));
+    }
+
+    double* times(const trace_index_entry& e) const {
+        return reinterpret_cast<double*>(base+e.offset);
+    }
+
+    double* values(const trace_index_entry& e) const {
+        return times(e)+header()->capacity;
+    }
+};
+
+} // anonymous namespace
+
+// trace_writer implementation
+
+struct trace_writer::impl {
+    // Samples of one probe waiting to be written, from position pos in the
+    // probe columns; the times and then the values are stored in the queued
+    // data from offset data.
+    struct pending {
+        std::size_t slot;
+        probe_tag tag;
+        std::size_t pos;
+        std::size_t n;
+        std::size_t data;
+    };
+
+    std::string path;
+    file_mapping map;
+    std::vector<cell_member_type> probe_ids;
+    std::unordered_map<cell_member_type, std::size_t> slot;
+
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable written;
+    std::thread writer;
+
+    // Guarded by mutex:
+    std::vector<std::size_t> reserved;  // Number of samples queued per probe.
+    std::vector<pending> queue;
+    std::vector<double> queue_data;
+    bool busy = false;
+    bool stop = false;
+    bool closed = false;
+
+    impl(const std::string& path, std::vector<cell_member_type> ids, std::size_t capacity):
+        path(path),
+        probe_ids(std::move(ids)),
+        reserved(probe_ids.size(), 0)
+    {
+        std::size_t n = probe_ids.size();
+        std::size_t chunk_size = 2*capacity*sizeof(double);
+        std::size_t data_offset = sizeof(trace_header)+n*sizeof(trace_index_entry);
+
+        map = file_mapping(path, data_offset+n*chunk_size);
+
+        auto h = map.header();
+        std::copy(std::begin(trace_magic), std::end(trace_magic), h->magic);
+        h->version = trace_version;
+        h->n_probes = n;
+        h->capacity = capacity;
+
+        auto index = map.index();
+        for (std::size_t i = 0; i<n; ++i) {
+            slot.insert({probe_ids[i], i});
+            index[i] = {probe_ids[i].gid, probe_ids[i].index, 0, 0, 0, data_offset+i*chunk_size};
+        }
+
+        writer = std::thread([this] { run(); });
+    }
+
+    void enqueue(const sample_block& block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) {
+            throw trace_file_error(path, "sample written to closed trace file");
+        }
+
+        std::size_t capacity = map.header()->capacity;
+        for (std::size_t i = 0; i<block.n_probes; ++i) {
+            auto id = block.probe_ids[i];
+            auto it = slot.find(id);
+            if (it==slot.end()) {
+                throw bad_probe_id(id);
+            }
+
+            std::size_t k = it->second;
+            std::size_t pos = reserved[k];
+            if (pos+block.n_samples>capacity) {
+                throw trace_file_error(path, pprintf("capacity of {} samples exceeded for probe {}", capacity, id));
+            }
+            reserved[k] += block.n_samples;
+
+            queue.push_back({k, block.tags[i], pos, block.n_samples, queue_data.size()});
+
+            auto time = block.time+i*block.n_samples;
+            auto value = block.value+i*block.n_samples;
+            queue_data.insert(queue_data.end(), time, time+block.n_samples);
+            queue_data.insert(queue_data.end(), value, value+block.n_samples);
+        }
+        queued.notify_one();
+    }
+
+    // Writer thread: copy queued samples into the mapping until stopped.
+    void run() {
+        std::vector<pending> batch;
+        std::vector<double> batch_data;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            queued.wait(lock, [this] { return stop || !queue.empty(); });
+            if (queue.empty()) break;
+
+            std::swap(batch, queue);
+            std::swap(batch_data, queue_data);
+            busy = true;
+            lock.unlock();
+
+            auto index = map.index();
+            for (auto& p: batch) {
+                auto& e = index[p.slot];
+                const double* data = batch_data.data()+p.data;
+                std::copy(data, data+p.n, map.times(e)+p.pos);
+                std::copy(data+p.n, data+2*p.n, map.values(e)+p.pos);
+                e.tag = p.tag;
+                e.n_samples = p.pos+p.n;
+            }
+            batch.clear();
+            batch_data.clear();
+
+            lock.lock();
+            busy = false;
+            written.notify_all();
+        }
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        written.wait(lock, [this] { return queue.empty() && !busy; });
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed) return;
+            closed = true;
+            stop = true;
+        }
+        queued.notify_one();
+        writer.join();
+
+        ::msync(map.base, map.size, MS_SYNC);
+        map = file_mapping();
+    }
+};
+
+trace_writer::trace_writer(const std::string& path, std::vector<cell_member_type> probe_ids, std::size_t capacity):
+    impl_(std::make_shared<impl>(path, std::move(probe_ids), capacity))
+{}
+
+trace_writer::~trace_writer() {
+    impl_->close();
+}
+
+bulk_sampler_function trace_writer::bulk_sampler() {
+    auto p = impl_;
+    return [p](const sample_block& block) { p->enqueue(block); };
+}
+
+sampler_function trace_writer::sampler() {
+    auto p = impl_;
+    return [p](cell_member_type probe_id, probe_tag tag, std::size_t n, const sample_record* recs) {
+        std::vector<double> time(n), value(n);
+        for (std::size_t i = 0; i<n; ++i) {
+            if (auto v = util::any_cast<const double*>(recs[i].data)) {
+                time[i] = recs[i].time;
+                value[i] = *v;
+            }
+            else {
+                throw std::runtime_error("unexpected sample type in trace_writer");
+            }
+        }
+        p->enqueue({1, n, &probe_id, &tag, time.data(), value.data()});
+    };
+}
+
+void trace_writer::flush() {
+    impl_->flush();
+}
+
+void trace_writer::close() {
+    impl_->close();
+}
+
+// trace_reader implementation
+
+struct trace_reader::impl {
+    file_mapping map;
+
+    explicit impl(const std::string& path): map(path, 0) {
+        auto h = map.header();
+        if (!std::equal(std::begin(trace_magic), std::end(trace_magic), h->magic)) {
+            throw trace_file_error(path, "not a trace file");
+        }
+        if (h->version!=trace_version) {
+            throw trace_file_error(path, pprintf("unsupported trace file version {}", h->version));
+        }
+
+        std::size_t n = h->n_probes;
+        std::size_t chunk_size = 2*h->capacity*sizeof(double);
+        if (map.size<sizeof(trace_header)+n*sizeof(trace_index_entry)) {
+            throw trace_file_error(path, "truncated trace file index");
+        }
+
+        auto index = map.index();
+        for (std::size_t i = 0; i<n; ++i) {
+            if (index[i].offset+chunk_size>map.size || index[i].n_samples>h->capacity) {
+                throw trace_file_error(path, pprintf("bad trace file index entry for probe {}", i));
+            }
+        }
+    }
+};
+
+trace_reader::trace_reader(const std::string& path):
+    impl_(new impl(path))
+{}
+
+trace_reader::trace_reader(trace_reader&&) = default;
+trace_reader& trace_reader::operator=(trace_reader&&) = default;
+trace_reader::~trace_reader() = default;
+
+std::size_t trace_reader::num_probes() const {
+    return impl_->map.header()->n_probes;
+}
+
+std::size_t trace_reader::capacity() const {
+    return impl_->map.header()->capacity;
+}
+
+cell_member_type trace_reader::probe_id(std::size_t i) const {
+    const auto& e = impl_->map.index()[i];
+    return {e.gid, e.index};
+}
+
+probe_tag trace_reader::tag(std::size_t i) const {
+    return impl_->map.index()[i].tag;
+}
+
+std::size_t trace_reader::num_samples(std::size_t i) const {
+    return impl_->map.index()[i].n_samples;
+}
+
+const double* trace_reader::times(std::size_t i) const {
+    return impl_->map.times(impl_->map.index()[i]);
+}
+
+const double* trace_reader::values(std::size_t i) const {
+    return impl_->map.values(impl_->map.index()[i]);
+}
+
+} // namespace arb
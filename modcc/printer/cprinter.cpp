@@ -209,6 +209,9 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
         "void nrn_current() override;\n"
         "void write_ions() override;\n";
 
+    !with_simd && out <<
+        "bool supports_instance_range() const override { return true; }\n";
+
     net_receive && out <<
         "void deliver_events(deliverable_event_stream::state events) override;\n"
         "void net_receive(int i_, value_type weight);\n";
@@ -504,8 +507,8 @@ void emit_api_body(std::ostream& out, APIMethod* method) {
 
     if (!body->statements().empty()) {
         out <<
-            "int n_ = width_;\n"
-            "for (int i_ = 0; i_ < n_; ++i_) {\n" << indent;
+            "int n_ = instance_end_;\n"
+            "for (int i_ = instance_begin_; i_ < n_; ++i_) {\n" << indent;
 
         for (auto& sym: indexed_vars) {
             emit_state_read(out, sym);
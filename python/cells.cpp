@@ -1,8 +1,10 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <arbor/adex_cell.hpp>
 #include <arbor/benchmark_cell.hpp>
 #include <arbor/cable_cell.hpp>
+#include <arbor/izhikevich_cell.hpp>
 #include <arbor/lif_cell.hpp>
 #include <arbor/schedule.hpp>
 #include <arbor/spike_source_cell.hpp>
@@ -34,6 +36,12 @@ arb::util::unique_any convert_cell(pybind11::object o) {
     if (isinstance<arb::lif_cell>(o)) {
         return arb::util::unique_any(cast<arb::lif_cell>(o));
     }
+    if (isinstance<arb::adex_cell>(o)) {
+        return arb::util::unique_any(cast<arb::adex_cell>(o));
+    }
+    if (isinstance<arb::izhikevich_cell>(o)) {
+        return arb::util::unique_any(cast<arb::izhikevich_cell>(o));
+    }
     if (isinstance<arb::cable_cell>(o)) {
         return arb::util::unique_any(cast<arb::cable_cell>(o));
     }
@@ -151,6 +159,18 @@ std::string lif_str(const arb::lif_cell& c){
                 c.tau_m, c.V_th, c.C_m, c.E_L, c.V_m, c.t_ref, c.V_reset);
 }
 
+std::string adex_str(const arb::adex_cell& c){
+    return util::pprintf(
+                "<arbor.adex_cell: C_m {}, g_L {}, E_L {}, V_T {}, delta_T {}, V_peak {}, V_reset {}, t_ref {}, a {}, b {}, tau_w {}, I_e {}, V_m {}, w {}>",
+                c.C_m, c.g_L, c.E_L, c.V_T, c.delta_T, c.V_peak, c.V_reset, c.t_ref, c.a, c.b, c.tau_w, c.I_e, c.V_m, c.w);
+}
+
+std::string izhikevich_str(const arb::izhikevich_cell& c){
+    return util::pprintf(
+                "<arbor.izhikevich_cell: a {}, b {}, c {}, d {}, V_peak {}, I_e {}, V_m {}, u {}>",
+                c.a, c.b, c.c, c.d, c.V_peak, c.I_e, c.V_m, c.u);
+}
+
 void register_cells(pybind11::module& m) {
     using namespace pybind11::literals;
 
@@ -214,6 +234,44 @@ void register_cells(pybind11::module& m) {
         .def("__repr__", &lif_str)
         .def("__str__",  &lif_str);
 
+    pybind11::class_<arb::adex_cell> adex_cell(m, "adex_cell",
+        "An adaptive exponential integrate and fire neuron, integrated with fixed time steps.");
+
+    adex_cell
+        .def(pybind11::init<>())
+        .def_readwrite("C_m",       &arb::adex_cell::C_m,       "Membrane capacitance [pF].")
+        .def_readwrite("g_L",       &arb::adex_cell::g_L,       "Leak conductance [nS].")
+        .def_readwrite("E_L",       &arb::adex_cell::E_L,       "Resting potential [mV].")
+        .def_readwrite("V_T",       &arb::adex_cell::V_T,       "Threshold of the exponential term [mV].")
+        .def_readwrite("delta_T",   &arb::adex_cell::delta_T,   "Slope factor of the exponential term, positive [mV].")
+        .def_readwrite("V_peak",    &arb::adex_cell::V_peak,    "Firing threshold [mV].")
+        .def_readwrite("V_reset",   &arb::adex_cell::V_reset,   "Reset potential [mV].")
+        .def_readwrite("t_ref",     &arb::adex_cell::t_ref,     "Refractory period [ms].")
+        .def_readwrite("a",         &arb::adex_cell::a,         "Subthreshold adaptation conductance [nS].")
+        .def_readwrite("b",         &arb::adex_cell::b,         "Spike-triggered adaptation current [pA].")
+        .def_readwrite("tau_w",     &arb::adex_cell::tau_w,     "Adaptation time constant [ms].")
+        .def_readwrite("I_e",       &arb::adex_cell::I_e,       "Constant external current [pA].")
+        .def_readwrite("V_m",       &arb::adex_cell::V_m,       "Initial value of the membrane potential [mV].")
+        .def_readwrite("w",         &arb::adex_cell::w,         "Initial value of the adaptation current [pA].")
+        .def("__repr__", &adex_str)
+        .def("__str__",  &adex_str);
+
+    pybind11::class_<arb::izhikevich_cell> izhikevich_cell(m, "izhikevich_cell",
+        "An Izhikevich neuron, integrated with fixed time steps.");
+
+    izhikevich_cell
+        .def(pybind11::init<>())
+        .def_readwrite("a",         &arb::izhikevich_cell::a,       "Time scale of the recovery variable [1/ms].")
+        .def_readwrite("b",         &arb::izhikevich_cell::b,       "Sensitivity of the recovery variable to the membrane potential [1/ms].")
+        .def_readwrite("c",         &arb::izhikevich_cell::c,       "Reset potential [mV].")
+        .def_readwrite("d",         &arb::izhikevich_cell::d,       "Increment of the recovery variable after a spike [mV/ms].")
+        .def_readwrite("V_peak",    &arb::izhikevich_cell::V_peak,  "Firing threshold [mV].")
+        .def_readwrite("I_e",       &arb::izhikevich_cell::I_e,     "Constant external input [mV/ms].")
+        .def_readwrite("V_m",       &arb::izhikevich_cell::V_m,     "Initial value of the membrane potential [mV].")
+        .def_readwrite("u",         &arb::izhikevich_cell::u,       "Initial value of the recovery variable [mV/ms].")
+        .def("__repr__", &izhikevich_str)
+        .def("__str__",  &izhikevich_str);
+
     pybind11::class_<cell_parameters> cell_params(m, "cell_parameters", "Parameters used to generate the random cell morphologies.");
     cell_params
         .def(pybind11::init<>())
@@ -78,6 +78,14 @@ void register_domain_decomposition(pybind11::module& m) {
         "Construct a domain_decomposition that distributes the cells in the model described by recipe\n"
         "over the distributed and local hardware resources described by context.",
         "recipe"_a, "context"_a);
+    m.def("partition_graph_load_balance",
+        [](std::shared_ptr<py_recipe>& recipe, const context_shim& ctx) {
+            return arb::partition_graph_load_balance(py_recipe_shim(recipe), ctx.context);
+        },
+        "Construct a domain_decomposition that distributes the cells in the model described by recipe\n"
+        "over the distributed and local hardware resources described by context, such that few\n"
+        "connections are between cells on different domains.",
+        "recipe"_a, "context"_a);
 }
 
 } // namespace pyarb
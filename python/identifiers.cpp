@@ -38,10 +38,14 @@ void register_identifiers(pybind11::module& m) {
 
     pybind11::enum_<arb::cell_kind>(m, "cell_kind",
         "Enumeration used to identify the cell kind, used by the model to group equal kinds in the same cell group.")
+        .value("adex", arb::cell_kind::adex,
+            "Adaptive exponential integrate and fire neuron.")
         .value("benchmark", arb::cell_kind::benchmark,
             "Proxy cell used for benchmarking.")
         .value("cable", arb::cell_kind::cable,
             "A cell with morphology described by branching 1D cable segments.")
+        .value("izhikevich", arb::cell_kind::izhikevich,
+            "Izhikevich neuron.")
         .value("lif", arb::cell_kind::lif,
             "Leaky-integrate and fire neuron.")
         .value("spike_source", arb::cell_kind::spike_source,
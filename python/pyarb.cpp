@@ -17,6 +17,7 @@ void register_recipe(pybind11::module& m);
 void register_schedules(pybind11::module& m);
 void register_simulation(pybind11::module& m);
 void register_spike_handling(pybind11::module& m);
+void register_trace_file(pybind11::module& m);
 
 #ifdef ARB_MPI_ENABLED
 void register_mpi(pybind11::module& m);
@@ -38,6 +39,7 @@ PYBIND11_MODULE(arbor, m) {
     pyarb::register_schedules(m);
     pyarb::register_simulation(m);
     pyarb::register_spike_handling(m);
+    pyarb::register_trace_file(m);
     
     #ifdef ARB_MPI_ENABLED
     pyarb::register_mpi(m);
@@ -129,6 +129,9 @@ void register_recipe(pybind11::module& m) {
         .def("cell_kind", &py_recipe::cell_kind,
             "gid"_a,
             "The kind of cell with global identifier gid.")
+        .def("cell_cost", &py_recipe::cell_cost,
+            "gid"_a,
+            "The estimated cost of advancing gid relative to other cells, used to balance the load of domains, 1 by default.")
         .def("num_sources", &py_recipe::num_sources,
             "gid"_a,
             "The number of spike sources on gid, 0 by default.")
@@ -29,6 +29,9 @@ public:
     virtual pybind11::object cell_description(arb::cell_gid_type gid) const = 0;
     virtual arb::cell_kind cell_kind(arb::cell_gid_type gid) const = 0;
 
+    virtual double cell_cost(arb::cell_gid_type) const {
+        return 1;
+    }
     virtual arb::cell_size_type num_sources(arb::cell_gid_type) const {
         return 0;
     }
@@ -67,6 +70,10 @@ public:
         PYBIND11_OVERLOAD_PURE(arb::cell_kind, py_recipe, cell_kind, gid);
     }
 
+    double cell_cost(arb::cell_gid_type gid) const override {
+        PYBIND11_OVERLOAD(double, py_recipe, cell_cost, gid);
+    }
+
     arb::cell_size_type num_sources(arb::cell_gid_type gid) const override {
         PYBIND11_OVERLOAD(arb::cell_size_type, py_recipe, num_sources, gid);
     }
@@ -122,6 +129,10 @@ public:
         return impl_->cell_kind(gid);
     }
 
+    double get_cell_cost(arb::cell_gid_type gid) const override {
+        return impl_->cell_cost(gid);
+    }
+
     arb::cell_size_type num_sources(arb::cell_gid_type gid) const override {
         return impl_->num_sources(gid);
     }
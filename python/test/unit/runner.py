@@ -15,6 +15,7 @@ try:
     import test_identifiers
     import test_tests
     import test_schedules
+    import test_trace_file
     # add more if needed
 except ModuleNotFoundError:
     from test import options
@@ -22,13 +23,15 @@ except ModuleNotFoundError:
     from test.unit import test_event_generators
     from test.unit import test_identifiers
     from test.unit import test_schedules
+    from test.unit import test_trace_file
     # add more if needed
 
 test_modules = [\
     test_contexts,\
     test_event_generators,\
     test_identifiers,\
-    test_schedules\
+    test_schedules,\
+    test_trace_file\
 ] # add more if needed
 
 def suite():
@@ -0,0 +1,88 @@
+# -*- coding: utf-8 -*-
+#
+# test_trace_file.py
+
+import unittest
+
+import arbor as arb
+
+# to be able to run .py file from child directory
+import sys, os, struct, tempfile
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '../../')))
+
+try:
+    import options
+except ModuleNotFoundError:
+    from test import options
+
+"""
+all tests for trace files
+"""
+
+def write_trace_file(path, capacity, probes):
+    # probes: list of (gid, index, tag, times, values), in the layout
+    # documented in arbor/trace_file.hpp.
+    header_size = struct.calcsize('=8sIIQ')
+    entry_size = struct.calcsize('=IIiIQQ')
+    chunk_size = 2*capacity*struct.calcsize('d')
+    offset = header_size+len(probes)*entry_size
+
+    with open(path, 'wb') as f:
+        f.write(struct.pack('=8sIIQ', b'ARBTRACE', 1, len(probes), capacity))
+        for i, (gid, index, tag, times, values) in enumerate(probes):
+            f.write(struct.pack('=IIiIQQ', gid, index, tag, 0, len(times), offset+i*chunk_size))
+        for gid, index, tag, times, values in probes:
+            pad = [0.]*(capacity-len(times))
+            f.write(struct.pack('=%dd'%capacity, *(list(times)+pad)))
+            f.write(struct.pack('=%dd'%capacity, *(list(values)+pad)))
+
+class TraceFile(unittest.TestCase):
+    def setUp(self):
+        fd, self.path = tempfile.mkstemp(prefix='arbor-trace-')
+        os.close(fd)
+        write_trace_file(self.path, 4, [
+            (0, 0, 1, [0.5, 1.0, 1.5], [-65., -64., -63.]),
+            (3, 1, 2, [0.25], [10.])])
+
+    def tearDown(self):
+        os.remove(self.path)
+
+    def test_read_trace_file(self):
+        tf = arb.trace_file(self.path)
+        self.assertEqual(tf.num_probes, 2)
+        self.assertEqual(tf.capacity, 4)
+        self.assertEqual(tf.probe_id(1).gid, 3)
+        self.assertEqual(tf.probe_id(1).index, 1)
+        self.assertEqual(tf.tag(0), 1)
+        self.assertEqual(tf.num_samples(0), 3)
+        self.assertEqual(list(memoryview(tf.times(0))), [0.5, 1.0, 1.5])
+        self.assertEqual(list(memoryview(tf.values(1))), [10.])
+
+    def test_read_only_trace_column(self):
+        tf = arb.trace_file(self.path)
+        view = memoryview(tf.values(0))
+        self.assertTrue(view.readonly)
+        with self.assertRaises(TypeError):
+            view[0] = 0.
+        self.assertEqual(view[0], -65.)
+
+    def test_exceptions_trace_file(self):
+        with self.assertRaises(RuntimeError):
+            arb.trace_file(self.path+'.missing')
+        tf = arb.trace_file(self.path)
+        with self.assertRaisesRegex(RuntimeError,
+            "probe index out of range"):
+            tf.values(2)
+
+def suite():
+    # specify class and test functions in tuple (here: all tests starting with 'test' from class TraceFile
+    suite = unittest.makeSuite(TraceFile, ('test'))
+    return suite
+
+def run():
+    v = options.parse_arguments().verbosity
+    runner = unittest.TextTestRunner(verbosity = v)
+    runner.run(suite())
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,87 @@
+#include <memory>
+#include <string>
+
+#include <pybind11/pybind11.h>
+
+#include <arbor/trace_file.hpp>
+
+#include "error.hpp"
+#include "strprintf.hpp"
+
+namespace pyarb {
+
+using util::pprintf;
+
+// A column of a trace file, exposed through the buffer protocol so that
+// the samples can be viewed in place, e.g. with memoryview or numpy.asarray.
+// Holds a shared pointer to the reader, which keeps the file mapped for the
+// lifetime of any view of the column.
+struct trace_column {
+    std::shared_ptr<arb::trace_reader> reader;
+    const double* data;
+    std::size_t size;
+};
+
+static std::size_t probe_index(const arb::trace_reader& r, std::size_t i) {
+    assert_throw(i<r.num_probes(), "probe index out of range");
+    return i;
+}
+
+void register_trace_file(pybind11::module& m) {
+    using namespace pybind11::literals;
+    using reader_ptr = std::shared_ptr<arb::trace_reader>;
+
+    pybind11::class_<trace_column> column(m, "trace_column", pybind11::buffer_protocol(),
+        "A read-only column of samples in a trace file, viewed without copying through the buffer protocol.");
+    column
+        .def_buffer([](trace_column& c) {
+            return pybind11::buffer_info(
+                const_cast<double*>(c.data), sizeof(double),
+                pybind11::format_descriptor<double>::format(),
+                1, {pybind11::ssize_t(c.size)}, {pybind11::ssize_t(sizeof(double))},
+                true); // The file is mapped read-only.
+        })
+        .def("__len__", [](const trace_column& c) { return c.size; });
+
+    pybind11::class_<arb::trace_reader, reader_ptr> trace_file(m, "trace_file",
+        "A binary trace file of probe samples, as written by arbor's trace_writer, mapped read-only.");
+    trace_file
+        .def(pybind11::init(
+            [](const std::string& path) { return std::make_shared<arb::trace_reader>(path); }),
+            "path"_a,
+            "Open the trace file at path.")
+        .def_property_readonly("num_probes", &arb::trace_reader::num_probes,
+            "The number of probes in the file.")
+        .def_property_readonly("capacity", &arb::trace_reader::capacity,
+            "The maximum number of samples per probe.")
+        .def("probe_id",
+            [](const arb::trace_reader& r, std::size_t i) { return r.probe_id(probe_index(r, i)); },
+            "i"_a,
+            "The id of probe i.")
+        .def("tag",
+            [](const arb::trace_reader& r, std::size_t i) { return r.tag(probe_index(r, i)); },
+            "i"_a,
+            "The tag of probe i.")
+        .def("num_samples",
+            [](const arb::trace_reader& r, std::size_t i) { return r.num_samples(probe_index(r, i)); },
+            "i"_a,
+            "The number of samples of probe i.")
+        .def("times",
+            [](const reader_ptr& r, std::size_t i) {
+                i = probe_index(*r, i);
+                return trace_column{r, r->times(i), r->num_samples(i)};
+            },
+            "i"_a,
+            "The sample times of probe i [ms].")
+        .def("values",
+            [](const reader_ptr& r, std::size_t i) {
+                i = probe_index(*r, i);
+                return trace_column{r, r->values(i), r->num_samples(i)};
+            },
+            "i"_a,
+            "The sample values of probe i.")
+        .def("__str__",  [](const arb::trace_reader& r) { return pprintf("<arbor.trace_file: {} probes>", r.num_probes()); })
+        .def("__repr__", [](const arb::trace_reader& r) { return pprintf("<arbor.trace_file: {} probes>", r.num_probes()); });
+}
+
+} // namespace pyarb
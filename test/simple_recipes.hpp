@@ -50,6 +50,10 @@ public:
         return catalogue_;
     }
 
+    cable_cell_global_properties& cable_global_properties() {
+        return cell_gprop_;
+    }
+
     void add_ion(const char* name, int charge, double iconc, double econc) {
         cell_gprop_.ion_default[name] = {charge, iconc, econc};
     }
@@ -0,0 +1,76 @@
+// Compare methods for sorting the pending events of a cell in setup_events.
+//
+// comparison_sort: std::sort with spike_event::operator<, as used before
+//     the radix sort was introduced.
+// radix_sort: arb::sort_events, which uses an LSD radix sort for sequences
+//     that are long enough.
+//
+// The events are for a single target cell, with random delivery times in a
+// window of one min_delay, and a small number of synapses, as is typical of
+// the events generated for a cell with high fan-in.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <arbor/spike_event.hpp>
+
+#include "merge_events.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace arb;
+
+pse_vector generate_events(std::size_t n, unsigned n_synapses) {
+    std::mt19937 gen;
+    std::uniform_real_distribution<float> time_dist(10.f, 11.f);
+    std::uniform_int_distribution<cell_lid_type> lid_dist(0, n_synapses-1);
+
+    pse_vector events;
+    events.reserve(n);
+    for (std::size_t i=0; i<n; ++i) {
+        events.push_back({{42u, lid_dist(gen)}, time_dist(gen), 0.1f});
+    }
+    return events;
+}
+
+void comparison_sort(benchmark::State& state) {
+    const auto events = generate_events(state.range(0), state.range(1));
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        auto v = events;
+        state.ResumeTiming();
+
+        std::sort(v.begin(), v.end());
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()*events.size());
+}
+
+void radix_sort(benchmark::State& state) {
+    const auto events = generate_events(state.range(0), state.range(1));
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        auto v = events;
+        state.ResumeTiming();
+
+        sort_events(v);
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()*events.size());
+}
+
+void run_custom_arguments(benchmark::internal::Benchmark* b) {
+    for (auto n_events: {128, 512, 1024, 4096, 16384, 65536}) {
+        for (auto n_synapses: {1, 16, 1024}) {
+            b->Args({n_events, n_synapses});
+        }
+    }
+}
+
+BENCHMARK(comparison_sort)->Apply(run_custom_arguments);
+BENCHMARK(radix_sort)->Apply(run_custom_arguments);
+
+BENCHMARK_MAIN();
@@ -1,10 +1,17 @@
-// Test performance of vectorization for mechanism implementations.
+// Test performance of the task system.
 //
-// Start with pas (passive dendrite) mechanism
+// task_test: tasks of fixed duration, measures scheduling at coarse grain.
+// task_overhead: empty tasks, measures the per-task cost of submission,
+//     scheduling and completion (queue contention and allocation).
+// nested_overhead: nested parallel_for with empty tasks, exercising
+//     work stealing from threads blocked in task_group::wait.
+// partitioned_overhead: as task_overhead, with chunked scheduling by
+//     static, dynamic and guided partitioners.
 
 #include <chrono>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include <arbor/version.hpp>
 
@@ -33,11 +40,83 @@ void task_test(benchmark::State& state) {
     }
 }
 
+void task_overhead(benchmark::State& state) {
+    const unsigned num_tasks = state.range(0);
+    const unsigned nthreads = state.range(1);
+    arb::threading::task_system ts(nthreads);
+
+    std::vector<unsigned> v(num_tasks);
+    while (state.KeepRunning()) {
+        arb::threading::parallel_for::apply(0, num_tasks, &ts, [&](unsigned i) { v[i] = i; });
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()*num_tasks);
+}
+
+void nested_overhead(benchmark::State& state) {
+    const unsigned num_tasks = state.range(0);
+    const unsigned nthreads = state.range(1);
+    const unsigned num_outer = 64;
+    arb::threading::task_system ts(nthreads);
+
+    std::vector<unsigned> v(num_outer*num_tasks);
+    while (state.KeepRunning()) {
+        arb::threading::parallel_for::apply(0, num_outer, &ts, [&](unsigned i) {
+            arb::threading::parallel_for::apply(0, num_tasks, &ts, [&](unsigned j) { v[i*num_tasks+j] = j; });
+        });
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()*num_outer*num_tasks);
+}
+
+void partitioned_overhead(benchmark::State& state) {
+    using arb::threading::partition_kind;
+    using arb::threading::partitioner;
+
+    const unsigned num_tasks = state.range(0);
+    const unsigned nthreads = state.range(1);
+    const auto kind = static_cast<partition_kind>(state.range(2));
+    const int grain = 64;
+    arb::threading::task_system ts(nthreads);
+
+    std::vector<unsigned> v(num_tasks);
+    while (state.KeepRunning()) {
+        arb::threading::parallel_for::apply(0, num_tasks, &ts, partitioner(kind, grain), [&](unsigned i) { v[i] = i; });
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()*num_tasks);
+}
+
 void us_per_task(benchmark::internal::Benchmark *b) {
     for (auto ncomps: {100, 250, 500, 1000, 10000}) {
         b->Args({ncomps});
     }
 }
 
+void tasks_threads(benchmark::internal::Benchmark *b) {
+    const int max_threads = std::thread::hardware_concurrency();
+    for (auto ntasks: {1000, 10000, 100000}) {
+        for (int nthreads = 1; nthreads<=max_threads; nthreads *= 2) {
+            b->Args({ntasks, nthreads});
+        }
+    }
+}
+
+void tasks_threads_kinds(benchmark::internal::Benchmark *b) {
+    using arb::threading::partition_kind;
+
+    const int max_threads = std::thread::hardware_concurrency();
+    for (auto kind: {partition_kind::static_blocks, partition_kind::dynamic, partition_kind::guided}) {
+        for (auto ntasks: {1000, 10000, 100000}) {
+            for (int nthreads = 1; nthreads<=max_threads; nthreads *= 2) {
+                b->Args({ntasks, nthreads, static_cast<int>(kind)});
+            }
+        }
+    }
+}
+
 BENCHMARK(task_test)->Apply(us_per_task);
+BENCHMARK(task_overhead)->Apply(tasks_threads)->UseRealTime();
+BENCHMARK(nested_overhead)->Apply(tasks_threads)->UseRealTime();
+BENCHMARK(partitioned_overhead)->Apply(tasks_threads_kinds)->UseRealTime();
 BENCHMARK_MAIN();
@@ -1,6 +1,8 @@
 #include "../gtest.h"
 #include "test.hpp"
 
+#include <memory>
+#include <set>
 #include <stdexcept>
 #include <vector>
 
@@ -140,6 +142,82 @@ TEST(communicator, gather_spikes_variant) {
     }
 }
 
+// Test that several non-blocking spike gathers can be in flight at once,
+// and that each gives the same result as the blocking gather.
+TEST(communicator, gather_spikes_async) {
+    const auto rank = g_context->distributed->id();
+    constexpr int num_requests = 3;
+
+    // Request k gathers k+rank spikes from each rank.
+    std::vector<std::vector<spike>> local_spikes(num_requests);
+    std::vector<spike_gather_request> requests;
+    for (auto k=0; k<num_requests; ++k) {
+        for (auto i=0; i<k+rank; ++i) {
+            local_spikes[k].push_back(gen_spike(i, 10*k+rank));
+        }
+        requests.push_back(g_context->distributed->gather_spikes_async(local_spikes[k]));
+        requests.back().test();
+    }
+
+    for (auto k=0; k<num_requests; ++k) {
+        const auto expected = g_context->distributed->gather_spikes(local_spikes[k]);
+        const auto global_spikes = requests[k].finish();
+
+        EXPECT_EQ(expected.partition(), global_spikes.partition());
+        ASSERT_EQ(expected.size(), global_spikes.size());
+        for (auto i=0u; i<expected.size(); ++i) {
+            EXPECT_EQ(expected.values()[i].source, global_spikes.values()[i].source);
+        }
+    }
+}
+
+// Test that the compressed spike gather matches the full gather.
+TEST(communicator, gather_spikes_compressed) {
+    const auto rank = g_context->distributed->id();
+
+    std::vector<spike> local_spikes;
+    for (auto i=0; i<10*rank; ++i) {
+        spike s = gen_spike(3*i+rank, rank);
+        s.time = 10.1+0.0123*i;
+        local_spikes.push_back(s);
+    }
+
+    const auto expected = g_context->distributed->gather_spikes(local_spikes);
+    auto request = g_context->distributed->gather_spikes_compressed_async(local_spikes);
+    const auto global_spikes = request.finish();
+
+    EXPECT_EQ(expected.partition(), global_spikes.partition());
+    ASSERT_EQ(expected.size(), global_spikes.size());
+    for (auto i=0u; i<expected.size(); ++i) {
+        EXPECT_EQ(expected.values()[i].source, global_spikes.values()[i].source);
+        EXPECT_EQ(expected.values()[i].time, global_spikes.values()[i].time);
+    }
+}
+
+// Test that test() on a non-blocking gather does not wait for the other
+// domains: domain 0 starts its gather and tests it before the others have
+// started theirs, which they only do after a barrier that domain 0 joins
+// after the test.
+TEST(communicator, gather_spikes_async_test_does_not_wait) {
+    const auto& dist = g_context->distributed;
+    const auto rank = dist->id();
+    std::vector<spike> local_spikes = {gen_spike(0, rank)};
+
+    if (rank==0) {
+        auto request = dist->gather_spikes_async(local_spikes);
+        if (dist->size()>1) {
+            EXPECT_FALSE(request.test());
+        }
+        dist->barrier();
+        EXPECT_EQ(unsigned(dist->size()), request.finish().size());
+    }
+    else {
+        dist->barrier();
+        auto request = dist->gather_spikes_async(local_spikes);
+        EXPECT_EQ(unsigned(dist->size()), request.finish().size());
+    }
+}
+
 // Test low level gids_gather function when the number of gids per domain
 // are not equal.
 TEST(communicator, gather_gids_variant) {
@@ -179,6 +257,37 @@ TEST(communicator, gather_gids_variant) {
     }
 }
 
+// Test low level alltoall_spikes function: each domain sends one spike
+// to every domain, with the destination domain recorded in the spike.
+TEST(communicator, alltoall_spikes) {
+    const auto num_domains = g_context->distributed->size();
+    const auto rank = g_context->distributed->id();
+
+    std::vector<spike> send_spikes;
+    std::vector<unsigned> send_part = {0u};
+    for (auto d=0; d<num_domains; ++d) {
+        // rank d gets d+1 spikes
+        for (auto i=0; i<=d; ++i) {
+            send_spikes.push_back(gen_spike(rank, d));
+        }
+        send_part.push_back(send_spikes.size());
+    }
+
+    const auto received = g_context->distributed->alltoall_spikes(send_spikes, send_part);
+
+    // Every domain sends rank+1 spikes to this domain.
+    const auto& part = received.partition();
+    EXPECT_EQ(unsigned(num_domains+1), part.size());
+    for (auto d=0; d<num_domains; ++d) {
+        EXPECT_EQ(unsigned(rank+1), received.count(d));
+        for (auto i=part[d]; i<part[d+1]; ++i) {
+            const auto& s = received.values()[i];
+            EXPECT_EQ(d, get_source(s));
+            EXPECT_EQ(rank, get_value(s));
+        }
+    }
+}
+
 namespace {
     // Population of cable and rss cells with ring connection topology.
     // Even gid are rss, and odd gid are cable cells.
@@ -316,6 +425,38 @@ namespace {
     }
 }
 
+// With all-gather exchange, every spike is received on every domain.
+// With sparse exchange, only spikes from sources of local connections are
+// received, once each.
+::testing::AssertionResult
+check_exchanged(const communicator& C, const std::vector<spike>& local_spikes, const gathered_vector<spike>& exchanged) {
+    if (C.exchange_kind()==spike_exchange_kind::all_gather) {
+        if (exchanged.size()!=g_context->distributed->sum(local_spikes.size())) {
+            return ::testing::AssertionFailure() << "the number of gathered spikes "
+                << exchanged.size() << " doesn't match the expected "
+                << g_context->distributed->sum(local_spikes.size());
+        }
+    }
+    else {
+        std::set<cell_gid_type> sources;
+        for (const auto& c: C.connections()) {
+            sources.insert(c.source().gid);
+        }
+        std::set<cell_gid_type> received;
+        for (const auto& s: exchanged.values()) {
+            if (!sources.count(s.source.gid)) {
+                return ::testing::AssertionFailure() << "received spike from "
+                    << s.source << " which is not connected to the local domain";
+            }
+            received.insert(s.source.gid);
+        }
+        if (received.size()!=exchanged.size()) {
+            return ::testing::AssertionFailure() << "duplicate spikes received";
+        }
+    }
+    return ::testing::AssertionSuccess();
+}
+
 template <typename F>
 ::testing::AssertionResult
 test_ring(const domain_decomposition& D, communicator& C, F&& f) {
@@ -333,10 +474,9 @@ test_ring(const domain_decomposition& D, communicator& C, F&& f) {
 
     // gather the global set of spikes
     auto global_spikes = C.exchange(local_spikes);
-    if (global_spikes.size()!=g_context->distributed->sum(local_spikes.size())) {
-        return ::testing::AssertionFailure() << "the number of gathered spikes "
-            << global_spikes.size() << " doesn't match the expected "
-            << g_context->distributed->sum(local_spikes.size());
+    auto exchanged = check_exchanged(C, local_spikes, global_spikes);
+    if (!exchanged) {
+        return exchanged;
     }
 
     // generate the events
@@ -403,6 +543,73 @@ TEST(communicator, ring)
     EXPECT_TRUE(test_ring(D, C, [](cell_gid_type g){return g%2==1;}));
 }
 
+TEST(communicator, ring_sparse)
+{
+    unsigned N = g_context->distributed->size();
+
+    unsigned n_local = 10u;
+    unsigned n_global = n_local*N;
+
+    auto R = ring_recipe(n_global);
+    const auto D = partition_load_balance(R, g_context);
+    auto C = communicator(R, D, *g_context);
+    C.set_exchange_kind(spike_exchange_kind::sparse);
+
+    // every cell fires
+    EXPECT_TRUE(test_ring(D, C, [](cell_gid_type g){return true;}));
+    // last cell in each domain fires
+    EXPECT_TRUE(test_ring(D, C, [n_local](cell_gid_type g){return (g+1)%n_local == 0u;}));
+    // even-numbered cells fire
+    EXPECT_TRUE(test_ring(D, C, [](cell_gid_type g){return g%2==0;}));
+    // odd-numbered cells fire
+    EXPECT_TRUE(test_ring(D, C, [](cell_gid_type g){return g%2==1;}));
+}
+
+// The connections reconstructed from the connection table match the recipe.
+// Enough cells and threads are used for the table to be built from several
+// batches of cells.
+TEST(communicator, all2all_connections)
+{
+    unsigned N = g_context->distributed->size();
+
+    unsigned n_local = 600u;
+    unsigned n_global = n_local*N;
+
+    execution_context ctx = *g_context;
+    ctx.thread_pool = std::make_shared<threading::task_system>(4);
+
+    auto R = all2all_recipe(n_global);
+    const auto D = partition_load_balance(R, g_context);
+    auto C = communicator(R, D, ctx);
+
+    auto gids = get_gids(D);
+    auto cons = C.connections();
+    ASSERT_EQ(gids.size()*n_global, cons.size());
+
+    std::set<std::pair<cell_gid_type, cell_gid_type>> edges;
+    for (const auto& c: cons) {
+        const auto src = c.source().gid;
+        const auto dst = c.destination();
+        EXPECT_EQ(0u, c.source().index);
+        EXPECT_EQ(src, dst.index);
+        EXPECT_EQ(gids[c.index_on_domain()], dst.gid);
+        EXPECT_EQ(float(dst.gid+src), c.weight());
+        EXPECT_EQ(1.0f, c.delay());
+        edges.insert({src, dst.gid});
+    }
+    EXPECT_EQ(cons.size(), edges.size());
+
+    // Connections are sorted by source within each source domain.
+    for (auto i=1u; i<cons.size(); ++i) {
+        const auto prev = cons[i-1].source().gid;
+        const auto next = cons[i].source().gid;
+        if (D.gid_domain(prev)==D.gid_domain(next)) {
+            EXPECT_LE(prev, next);
+        }
+    }
+    EXPECT_EQ(1.0f, C.min_delay());
+}
+
 template <typename F>
 ::testing::AssertionResult
 test_all2all(const domain_decomposition& D, communicator& C, F&& f) {
@@ -424,10 +631,9 @@ test_all2all(const domain_decomposition& D, communicator& C, F&& f) {
 
     // gather the global set of spikes
     auto global_spikes = C.exchange(local_spikes);
-    if (global_spikes.size()!=g_context->distributed->sum(local_spikes.size())) {
-        return ::testing::AssertionFailure() << "the number of gathered spikes "
-            << global_spikes.size() << " doesn't match the expected "
-            << g_context->distributed->sum(local_spikes.size());
+    auto exchanged = check_exchanged(C, local_spikes, global_spikes);
+    if (!exchanged) {
+        return exchanged;
     }
 
     // generate the events
@@ -497,3 +703,46 @@ TEST(communicator, all2all)
     // odd-numbered cells fire
     EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g%2==1;}));
 }
+
+TEST(communicator, all2all_sparse)
+{
+    unsigned N = g_context->distributed->size();
+
+    unsigned n_local = 10u;
+    unsigned n_global = n_local*N;
+
+    auto R = all2all_recipe(n_global);
+    const auto D = partition_load_balance(R, g_context);
+    auto C = communicator(R, D, *g_context);
+    C.set_exchange_kind(spike_exchange_kind::sparse);
+
+    // every cell fires
+    EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return true;}));
+    // only cell 0 fires
+    EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g==0u;}));
+    // even-numbered cells fire
+    EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g%2==0;}));
+}
+
+// Events are generated in parallel when there are enough spikes and threads.
+TEST(communicator, all2all_threaded)
+{
+    unsigned N = g_context->distributed->size();
+
+    unsigned n_local = 100u;
+    unsigned n_global = n_local*N;
+
+    execution_context ctx = *g_context;
+    ctx.thread_pool = std::make_shared<threading::task_system>(4);
+
+    auto R = all2all_recipe(n_global);
+    const auto D = partition_load_balance(R, g_context);
+    auto C = communicator(R, D, ctx);
+
+    // every cell fires
+    EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return true;}));
+    // even-numbered cells fire
+    EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g%2==0;}));
+    // only cell 0 fires
+    EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g==0u;}));
+}
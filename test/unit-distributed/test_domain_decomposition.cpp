@@ -1,10 +1,12 @@
 #include "../gtest.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <arbor/context.hpp>
@@ -142,6 +144,40 @@ namespace {
         unsigned groups_;
         cell_size_type size_;
     };
+
+    // Two clusters per rank of eight cells each, with the cells of cluster c
+    // those with gid%n_clusters equal to c. Each cell has a connection from
+    // every other cell in its cluster.
+    class cluster_recipe: public recipe {
+    public:
+        cluster_recipe(unsigned num_ranks): n_clusters_(2*num_ranks), size_(8*n_clusters_) {}
+
+        cell_size_type num_cells() const override {
+            return size_;
+        }
+
+        arb::util::unique_any get_cell_description(cell_gid_type) const override {
+            return {};
+        }
+
+        cell_kind get_cell_kind(cell_gid_type gid) const override {
+            return cell_kind::cable;
+        }
+
+        std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+            std::vector<cell_connection> conns;
+            for (auto src = gid%n_clusters_; src<size_; src += n_clusters_) {
+                if (src!=gid) {
+                    conns.push_back(cell_connection({src, 0}, {gid, 0}, 0.1f, 1.f));
+                }
+            }
+            return conns;
+        }
+
+    private:
+        cell_size_type n_clusters_;
+        cell_size_type size_;
+    };
 }
 
 TEST(domain_decomposition, homogeneous_population_mc) {
@@ -415,3 +451,102 @@ TEST(domain_decomposition, non_symmetric_groups)
         }
     }
 }
+
+TEST(domain_decomposition, graph_partition)
+{
+    proc_allocation resources{1, -1};
+#ifdef TEST_MPI
+    auto ctx = make_context(resources, MPI_COMM_WORLD);
+#else
+    auto ctx = make_context(resources);
+#endif
+
+    const unsigned N = arb::num_ranks(ctx);
+    const unsigned I = arb::rank(ctx);
+
+    // Each rank has two whole clusters.
+    cluster_recipe rec(N);
+    const auto D = partition_graph_load_balance(rec, ctx);
+
+    EXPECT_EQ(rec.num_cells(), D.num_global_cells);
+    EXPECT_EQ(16u, D.num_local_cells);
+
+    for (auto& g: D.groups) {
+        for (auto gid: g.gids) {
+            EXPECT_EQ(I, (unsigned)D.gid_domain(gid));
+        }
+    }
+    for (auto gid: util::make_span(rec.num_cells())) {
+        EXPECT_EQ(D.gid_domain(gid%(2*N)), D.gid_domain(gid));
+    }
+}
+
+TEST(domain_decomposition, gather_cell_costs)
+{
+    proc_allocation resources{1, -1};
+#ifdef TEST_MPI
+    auto ctx = make_context(resources, MPI_COMM_WORLD);
+#else
+    auto ctx = make_context(resources);
+#endif
+
+    const unsigned N = arb::num_ranks(ctx);
+    const unsigned I = arb::rank(ctx);
+
+    // Each rank measures the costs of three cells, and the cell with the
+    // highest gid has no measured cost.
+    std::unordered_map<cell_gid_type, double> local_costs;
+    for (auto gid: util::make_span(3*I, 3*I+3)) {
+        if (gid+1<3*N) local_costs[gid] = gid+1;
+    }
+
+    auto cost = gather_cell_costs(ctx, local_costs);
+    for (auto gid: util::make_span(3*N-1)) {
+        EXPECT_EQ(gid+1., cost(gid));
+    }
+    EXPECT_DOUBLE_EQ(3*N/2., cost(3*N-1));
+}
+
+TEST(domain_decomposition, cell_costs)
+{
+    proc_allocation resources{1, -1};
+#ifdef TEST_MPI
+    auto ctx = make_context(resources, MPI_COMM_WORLD);
+#else
+    auto ctx = make_context(resources);
+#endif
+
+    const unsigned N = arb::num_ranks(ctx);
+    const unsigned I = arb::rank(ctx);
+
+    // Cell 0 costs more than the mean cost per domain, and so takes a
+    // domain to itself when there are several; the other cells cost one.
+    homo_recipe rec(4*N, dummy_cell{});
+    std::vector<cell_gid_type> evaluated;
+    auto cost = [&](cell_gid_type gid) {
+        evaluated.push_back(gid);
+        return gid? 1.: 10.*N;
+    };
+    const auto D = partition_load_balance(rec, ctx, cost);
+
+    // Each domain evaluates the costs of four cells.
+    std::vector<cell_gid_type> expected_evaluated = {4*I, 4*I+1, 4*I+2, 4*I+3};
+    EXPECT_EQ(expected_evaluated, evaluated);
+
+    std::vector<cell_gid_type> gids;
+    for (auto& g: D.groups) {
+        gids.insert(gids.end(), g.gids.begin(), g.gids.end());
+    }
+    std::sort(gids.begin(), gids.end());
+    if (N>1 && I==0) {
+        EXPECT_EQ((std::vector<cell_gid_type>{0}), gids);
+    }
+
+    // The domains take contiguous ranges of gids, in order.
+    for (auto gid: util::make_span(1, rec.num_cells())) {
+        EXPECT_LE(D.gid_domain(gid-1), D.gid_domain(gid));
+    }
+    for (auto gid: gids) {
+        EXPECT_EQ(int(I), D.gid_domain(gid));
+    }
+}
@@ -6,9 +6,15 @@
  */
 
 #include <cmath>
+#include <cstdio>
 #include <string>
 #include <utility>
 
+extern "C" {
+    #include <stdlib.h>
+    #include <unistd.h>
+}
+
 #include "../gtest.h"
 
 namespace testing {
@@ -115,6 +121,26 @@ int nomove<V>::copy_ctor_count;
 template <typename V>
 int nomove<V>::copy_assign_count;
 
+// Path of a new empty temporary file, removed on destruction.
+
+struct scoped_temp_path {
+    std::string path;
+
+    scoped_temp_path() {
+        char name[] = "/tmp/arbor-test-XXXXXX";
+        int fd = ::mkstemp(name);
+        if (fd>=0) ::close(fd);
+        path = name;
+    }
+
+    scoped_temp_path(const scoped_temp_path&) = delete;
+    scoped_temp_path& operator=(const scoped_temp_path&) = delete;
+
+    ~scoped_temp_path() {
+        std::remove(path.c_str());
+    }
+};
+
 
 // Subvert class access protections. Demo:
 //
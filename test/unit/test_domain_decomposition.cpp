@@ -1,11 +1,16 @@
 #include "../gtest.h"
 
+#include <algorithm>
 #include <stdexcept>
 
+#include <arbor/cable_cell.hpp>
 #include <arbor/context.hpp>
 #include <arbor/domain_decomposition.hpp>
+#include <arbor/lif_cell.hpp>
 #include <arbor/load_balance.hpp>
+#include <arbor/simulation.hpp>
 
+#include "fvm_layout.hpp"
 #include "util/span.hpp"
 
 #include "../simple_recipes.hpp"
@@ -110,6 +115,88 @@ namespace {
     private:
         cell_size_type size_ = 15;
     };
+
+    // Spike source cells, of which the first five cost ten times as much as
+    // the others.
+    class costly_recipe: public recipe {
+    public:
+        costly_recipe(cell_size_type s): size_(s) {}
+
+        cell_size_type num_cells() const override {
+            return size_;
+        }
+
+        util::unique_any get_cell_description(cell_gid_type) const override {
+            return {};
+        }
+
+        cell_kind get_cell_kind(cell_gid_type gid) const override {
+            return cell_kind::spike_source;
+        }
+
+        double get_cell_cost(cell_gid_type gid) const override {
+            return gid<5? 10: 1;
+        }
+
+    private:
+        cell_size_type size_;
+    };
+
+    // Clusters of cells, with the cells of cluster c those with gid%n_clusters
+    // equal to c. Each cell has a connection from every other cell in its
+    // cluster, and optionally a gap junction with the cell n_clusters gids
+    // away.
+    class cluster_recipe: public recipe {
+    public:
+        cluster_recipe(cell_size_type n_clusters, cell_size_type cluster_size, bool gap_junctions = false):
+            n_clusters_(n_clusters), size_(n_clusters*cluster_size), gap_junctions_(gap_junctions)
+        {}
+
+        cell_size_type num_cells() const override {
+            return size_;
+        }
+
+        util::unique_any get_cell_description(cell_gid_type) const override {
+            return {};
+        }
+
+        cell_kind get_cell_kind(cell_gid_type gid) const override {
+            return cell_kind::cable;
+        }
+
+        std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+            std::vector<cell_connection> conns;
+            for (auto src = gid%n_clusters_; src<size_; src += n_clusters_) {
+                if (src!=gid) {
+                    conns.push_back(cell_connection({src, 0}, {gid, 0}, 0.1f, 1.f));
+                }
+            }
+            return conns;
+        }
+
+        std::vector<gap_junction_connection> gap_junctions_on(cell_gid_type gid) const override {
+            if (!gap_junctions_) return {};
+
+            // Cells 2k*n_clusters+c and (2k+1)*n_clusters+c are paired.
+            cell_gid_type peer = (gid/n_clusters_)%2? gid-n_clusters_: gid+n_clusters_;
+            if (peer>=size_) return {};
+            return {gap_junction_connection({gid, 0}, {peer, 0}, 0.1)};
+        }
+
+    private:
+        cell_size_type n_clusters_;
+        cell_size_type size_;
+        bool gap_junctions_;
+    };
+
+    std::vector<cell_gid_type> local_gids(const domain_decomposition& D) {
+        std::vector<cell_gid_type> gids;
+        for (auto& g: D.groups) {
+            gids.insert(gids.end(), g.gids.begin(), g.gids.end());
+        }
+        std::sort(gids.begin(), gids.end());
+        return gids;
+    }
 }
 
 // test assumes one domain
@@ -353,3 +440,198 @@ TEST(domain_decomposition, compulsory_groups)
     EXPECT_EQ(expected_groups2, D2.groups[0].gids);
 
 }
+
+TEST(domain_decomposition, cell_costs)
+{
+    proc_allocation resources;
+    resources.num_threads = 1;
+    resources.gpu_id = -1;
+
+    // Each domain evaluates the costs of its share of the cells only. In a
+    // dry run, every tile has the costs of the first, here 10, 10, 10, 10,
+    // 10, 1, 1, 1, 1, 1, so that the tiles have equal costs.
+    costly_recipe rec(20);
+    std::vector<cell_gid_type> evaluated;
+    auto recorded_cost = [&](cell_gid_type gid) {
+        evaluated.push_back(gid);
+        return rec.get_cell_cost(gid);
+    };
+    auto D = partition_load_balance(rec, make_context(resources, dry_run_info(2, 10)), recorded_cost);
+    EXPECT_EQ((std::vector<cell_gid_type>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), evaluated);
+    EXPECT_EQ(evaluated, local_gids(D));
+
+    evaluated.clear();
+    D = partition_graph_load_balance(rec, make_context(resources, dry_run_info(4, 5)), recorded_cost);
+    EXPECT_EQ((std::vector<cell_gid_type>{0, 1, 2, 3, 4}), evaluated);
+
+    // With equal costs, the numbers of cells differ by at most one, and the
+    // first domains take the extra cells.
+    auto unit_cost = [](cell_gid_type) { return 1.; };
+    D = partition_load_balance(costly_recipe(10), make_context(resources, dry_run_info(3, 3)), unit_cost);
+    EXPECT_EQ((std::vector<cell_gid_type>{0, 1, 2, 3}), local_gids(D));
+
+    D = partition_load_balance(costly_recipe(10), make_context(resources, dry_run_info(2, 5)), unit_cost);
+    EXPECT_EQ((std::vector<cell_gid_type>{0, 1, 2, 3, 4}), local_gids(D));
+
+    for (double cost: {1., 0.1}) {
+        D = partition_load_balance(costly_recipe(5), make_context(resources, dry_run_info(4, 1)),
+            [cost](cell_gid_type) { return cost; });
+        EXPECT_EQ((std::vector<cell_gid_type>{0, 1}), local_gids(D));
+    }
+
+    // Groups are closed when they reach the group cost.
+    partition_hint_map hints;
+    hints[cell_kind::spike_source].cpu_group_size = 12;
+    hints[cell_kind::spike_source].cpu_group_cost = 20;
+    D = partition_load_balance(costly_recipe(20), make_context(resources), hints);
+
+    std::vector<std::vector<cell_gid_type>> expected = {
+        {0, 1}, {2, 3}, {4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14}, {15, 16, 17, 18, 19}};
+    std::vector<std::vector<cell_gid_type>> groups;
+    for (auto& g: D.groups) {
+        groups.push_back(g.gids);
+    }
+    EXPECT_EQ(expected, groups);
+}
+
+TEST(domain_decomposition, cv_count_cost)
+{
+    cable_cell soma;
+    soma.add_soma(6);
+
+    cable_cell dend = soma;
+    dend.add_cable(0, section_kind::dendrite, 0.5, 0.5, 100)->set_compartments(4);
+
+    cable1d_recipe rec(std::vector<cable_cell>{soma, dend});
+    auto cost = cv_count_cell_cost(rec);
+    EXPECT_EQ(1., cost(0));
+    EXPECT_EQ(double(fvm_discretize({dend}).ncv), cost(1));
+    EXPECT_LT(cost(0), cost(1));
+
+    EXPECT_EQ(1., cv_count_cell_cost(costly_recipe(2))(1));
+}
+
+TEST(domain_decomposition, measured_cost)
+{
+    homogeneous_recipe<cell_kind::lif, lif_cell> rec(10, lif_cell());
+    auto ctx = make_context();
+
+    partition_hint_map hints;
+    hints[cell_kind::lif].cpu_group_size = 3;
+    simulation sim(rec, partition_load_balance(rec, ctx, hints), ctx);
+    sim.run(10, 0.1);
+
+    // Each cell has the cost of its group, divided among its cells.
+    auto costs = sim.cell_costs();
+    ASSERT_EQ(10u, costs.size());
+    for (auto gid: make_span(10)) {
+        ASSERT_EQ(1u, costs.count(gid));
+        EXPECT_LE(0., costs[gid]);
+    }
+    EXPECT_EQ(costs[0], costs[2]);
+    EXPECT_EQ(costs[3], costs[5]);
+
+    // Shared between domains, cells without a measured cost take the mean.
+    costs.erase(9);
+    auto cost = gather_cell_costs(ctx, costs);
+    double total = 0;
+    for (auto gid: make_span(9)) {
+        EXPECT_EQ(costs[gid], cost(gid));
+        total += costs[gid];
+    }
+    EXPECT_DOUBLE_EQ(total/9, cost(9));
+    EXPECT_EQ(1., gather_cell_costs(ctx, {})(0));
+
+    auto D = partition_load_balance(rec, ctx, cost);
+    EXPECT_EQ(10u, D.num_local_cells);
+
+    // Reset clears the measured costs.
+    sim.reset();
+    for (auto& gid_cost: sim.cell_costs()) {
+        EXPECT_EQ(0., gid_cost.second);
+    }
+}
+
+TEST(domain_decomposition, graph_partition)
+{
+    proc_allocation resources;
+    resources.num_threads = 1;
+    resources.gpu_id = -1;
+
+    // With contiguous ranges of gids, every cluster spans the two domains;
+    // partitioned by connectivity, each domain has two whole clusters.
+    const cell_size_type n_clusters = 4, cluster_size = 10;
+    cluster_recipe rec(n_clusters, cluster_size);
+
+    partition_hint_map hints;
+    hints[cell_kind::cable].cpu_group_size = 4;
+    auto D = partition_graph_load_balance(rec, make_context(resources, dry_run_info(2, 20)), hints);
+
+    EXPECT_EQ(2, D.num_domains);
+    EXPECT_EQ(0, D.domain_id);
+    EXPECT_EQ(20u, D.num_local_cells);
+    EXPECT_EQ(40u, D.num_global_cells);
+
+    std::vector<cell_gid_type> expected_local;
+    unsigned clusters_on_0 = 0;
+    for (auto gid: make_span(rec.num_cells())) {
+        auto dom = D.gid_domain(gid);
+        EXPECT_TRUE(dom==0 || dom==1);
+        EXPECT_EQ(D.gid_domain(gid%n_clusters), dom);
+        if (dom==0) {
+            expected_local.push_back(gid);
+            if (gid<n_clusters) ++clusters_on_0;
+        }
+    }
+    EXPECT_EQ(2u, clusters_on_0);
+    EXPECT_EQ(expected_local, local_gids(D));
+    EXPECT_EQ(-1, D.gid_domain(rec.num_cells()));
+
+    ASSERT_EQ(5u, D.groups.size());
+    for (auto& g: D.groups) {
+        EXPECT_EQ(4u, g.gids.size());
+        EXPECT_EQ(cell_kind::cable, g.kind);
+        EXPECT_EQ(backend_kind::multicore, g.backend);
+    }
+
+    // On a single domain, all cells are local.
+    D = partition_graph_load_balance(rec, make_context(resources));
+    EXPECT_EQ(40u, D.num_local_cells);
+    for (auto gid: make_span(rec.num_cells())) {
+        EXPECT_EQ(0, D.gid_domain(gid));
+    }
+}
+
+TEST(domain_decomposition, graph_partition_gap_junctions)
+{
+    proc_allocation resources;
+    resources.num_threads = 1;
+    resources.gpu_id = -1;
+
+    // Cells connected by gap junctions are on the same domain, and in the
+    // same cell group, across clusters.
+    const cell_size_type n_clusters = 5, cluster_size = 8;
+    cluster_recipe rec(n_clusters, cluster_size, true);
+
+    for (unsigned num_domains: {2u, 3u}) {
+        auto D = partition_graph_load_balance(rec, make_context(resources, dry_run_info(num_domains, 1)));
+
+        std::vector<cell_gid_type> expected_local;
+        for (auto gid: make_span(rec.num_cells())) {
+            auto peer = (gid/n_clusters)%2? gid-n_clusters: gid+n_clusters;
+            EXPECT_EQ(D.gid_domain(gid), D.gid_domain(peer));
+            if (D.gid_domain(gid)==0) {
+                expected_local.push_back(gid);
+            }
+        }
+        EXPECT_EQ(expected_local, local_gids(D));
+        EXPECT_LT(0u, D.num_local_cells);
+
+        for (auto& g: D.groups) {
+            for (auto gid: g.gids) {
+                auto peer = (gid/n_clusters)%2? gid-n_clusters: gid+n_clusters;
+                EXPECT_NE(g.gids.end(), std::find(g.gids.begin(), g.gids.end(), peer));
+            }
+        }
+    }
+}
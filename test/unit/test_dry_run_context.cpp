@@ -117,3 +117,71 @@ TEST(dry_run_context, gather_gids)
     EXPECT_EQ(part[3], gids.size()*3);
     EXPECT_EQ(part[4], gids.size()*4);
 }
+
+TEST(dry_run_context, gather_cell_costs)
+{
+    distributed_context_handle ctx = arb::make_dry_run_context(4, 4);
+
+    std::vector<double> costs = {0.5, 1.0, 1.5, 2.0};
+
+    auto s = ctx->gather_cell_costs(costs);
+    auto& part = s.partition();
+
+    EXPECT_EQ(16u, s.values().size());
+    EXPECT_EQ(part.size(), 5u);
+    for (unsigned i = 0; i<4; ++i) {
+        EXPECT_EQ(part[i], costs.size()*i);
+        EXPECT_EQ(costs, std::vector<double>(s.values().begin()+part[i], s.values().begin()+part[i+1]));
+    }
+}
+
+TEST(dry_run_context, alltoall_gids)
+{
+    distributed_context_handle ctx = arb::make_dry_run_context(4, 4);
+    using gvec = std::vector<arb::cell_gid_type>;
+
+    // Rank 0 requests gid 1 from rank 0, nothing from rank 1, gids 8 and 9
+    // from rank 2 and gid 13 from rank 3. Rank i sends the same values
+    // shifted by i tiles to rank (i+j)%4, so rank 0 receives from rank i
+    // what rank 0 sends to rank (4-i)%4, shifted by i tiles modulo the
+    // 16 gids: i.e. requests for gids on rank 0.
+    gvec gids = {1, 8, 9, 13};
+    std::vector<unsigned> send_part = {0, 1, 1, 3, 4};
+
+    gvec received_gids = {1, 1, 0, 1};
+
+    auto s = ctx->alltoall_gids(gids, send_part);
+    auto& part = s.partition();
+
+    EXPECT_EQ(received_gids, s.values());
+    EXPECT_EQ((std::vector<unsigned>{0, 1, 2, 4, 4}), part);
+}
+
+TEST(dry_run_context, alltoall_spikes)
+{
+    distributed_context_handle ctx = arb::make_dry_run_context(4, 4);
+    using svec = std::vector<arb::spike>;
+
+    // Spikes from the cells on rank 0 are sent to all ranks, to ranks 1 and 3,
+    // and to rank 2 respectively.
+    svec spikes = {
+        {{0u,1u}, 1.f},
+        {{0u,1u}, 1.f}, {{2u,0u}, 2.f},
+        {{0u,1u}, 1.f}, {{3u,0u}, 3.f},
+        {{0u,1u}, 1.f}, {{2u,0u}, 2.f},
+    };
+    std::vector<unsigned> send_part = {0, 1, 3, 5, 7};
+
+    svec received_spikes = {
+        {{0u,1u}, 1.f},
+        {{4u,1u}, 1.f}, {{6u,0u}, 2.f},
+        {{8u,1u}, 1.f}, {{11u,0u}, 3.f},
+        {{12u,1u}, 1.f}, {{14u,0u}, 2.f},
+    };
+
+    auto s = ctx->alltoall_spikes(spikes, send_part);
+    auto& part = s.partition();
+
+    EXPECT_EQ(received_spikes, s.values());
+    EXPECT_EQ((std::vector<unsigned>{0, 1, 3, 5, 7}), part);
+}
@@ -0,0 +1,114 @@
+#include "../gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <arbor/spike_event.hpp>
+
+#include "event_calendar.hpp"
+
+using namespace arb;
+
+namespace {
+    // Random events with times uniformly distributed in [t0, t1).
+    pse_vector random_events(std::size_t n, time_type t0, time_type t1, unsigned seed) {
+        std::minstd_rand R(seed);
+        std::uniform_real_distribution<time_type> time_dist(t0, t1);
+        std::uniform_int_distribution<cell_gid_type> gid_dist(0, 10);
+
+        pse_vector events;
+        for (std::size_t i=0; i<n; ++i) {
+            events.push_back({{gid_dist(R), 0u}, time_dist(R), 1.f});
+        }
+        return events;
+    }
+
+    // The events in `events` that are due in [t0, t1), sorted.
+    pse_vector due(const pse_vector& events, time_type t0, time_type t1) {
+        pse_vector result;
+        for (auto& e: events) {
+            if (e.time>=t0 && e.time<t1) result.push_back(e);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+TEST(event_calendar, empty) {
+    event_calendar q;
+    pse_vector out = {{{1u, 0u}, 1.f, 1.f}};
+
+    EXPECT_TRUE(q.empty());
+    q.pop_until(10.f, out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(event_calendar, pop_until) {
+    event_calendar q;
+    q.set_intervals(0.f, 1.f, 4);
+
+    // Events in and beyond the span of the ring.
+    auto events = random_events(1000, 0.f, 20.f, 42);
+    q.push(events);
+    EXPECT_EQ(events.size(), q.size());
+
+    // Intervals of the width of the buckets, and of other widths.
+    pse_vector out;
+    time_type t = 0;
+    for (time_type dt: {1.f, 1.f, 0.5f, 0.25f, 1.75f, 3.f, 5.5f, 7.f}) {
+        q.pop_until(t+dt, out);
+        EXPECT_EQ(due(events, t, t+dt), out);
+        t += dt;
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(event_calendar, push_between_pops) {
+    event_calendar q;
+    const time_type dt = 0.1f;
+    q.set_intervals(0.f, dt, 8);
+
+    // Push new events due at least min_delay after the start of each
+    // interval, as generated by spike exchange.
+    const time_type min_delay = 2*dt;
+    pse_vector all, out;
+    time_type t = 0;
+    for (unsigned i=0; i<100; ++i) {
+        auto events = random_events(50, t+min_delay, t+3.f, i);
+        q.push(events);
+        all.insert(all.end(), events.begin(), events.end());
+
+        q.pop_until(t+dt, out);
+        EXPECT_EQ(due(all, t, t+dt), out);
+        t += dt;
+    }
+    q.pop_until(100.f, out);
+    EXPECT_EQ(due(all, t, 100.f), out);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(event_calendar, set_intervals) {
+    event_calendar q;
+    q.set_intervals(0.f, 1.f, 2);
+
+    auto events = random_events(200, 0.f, 10.f, 7);
+    q.push(events);
+
+    pse_vector out;
+    q.pop_until(2.5f, out);
+    EXPECT_EQ(due(events, 0.f, 2.5f), out);
+
+    // Change the origin and width of the intervals: events held are kept.
+    q.set_intervals(2.5f, 0.3f, 16);
+    EXPECT_EQ(due(events, 2.5f, 10.f).size(), q.size());
+
+    q.pop_until(2.8f, out);
+    EXPECT_EQ(due(events, 2.5f, 2.8f), out);
+    q.pop_until(10.f, out);
+    EXPECT_EQ(due(events, 2.8f, 10.f), out);
+
+    q.push(events);
+    q.clear();
+    EXPECT_TRUE(q.empty());
+}
@@ -46,6 +46,9 @@ ACCESS_BIND(matrix fvm_cell::*, private_matrix_ptr, &fvm_cell::matrix_)
 
 ACCESS_BIND(std::vector<arb::mechanism_ptr> fvm_cell::*, private_mechanisms_ptr, &fvm_cell::mechanisms_)
 
+using mechanism_pipeline = backend::mechanism_pipeline;
+ACCESS_BIND(mechanism_pipeline fvm_cell::*, private_pipeline_ptr, &fvm_cell::mechanism_pipeline_)
+
 arb::mechanism* find_mechanism(fvm_cell& fvcell, const std::string& name) {
     for (auto& mech: fvcell.*private_mechanisms_ptr) {
         if (mech->internal_name()==name) {
@@ -1038,3 +1041,136 @@ TEST(fvm_lowered, integration_domains) {
     }
 }
 
+
+// Test that running the mechanism kernels tile by tile gives the same
+// results as running each kernel over all of its instances.
+
+TEST(fvm_lowered, mechanism_tiling) {
+    execution_context context;
+
+    std::vector<cable_cell> cells;
+    for (int i = 0; i<4; ++i) {
+        cells.push_back(make_cell_ball_and_3stick());
+        cells.back().add_synapse({2, 0.2}, "expsyn");
+        cells.back().add_synapse({1, 0.7}, "exp2syn");
+    }
+
+    std::vector<target_handle> targets;
+    std::vector<fvm_index_type> cell_to_intdom;
+    probe_association_map<probe_handle> probe_map;
+
+    fvm_cell untiled(context);
+    untiled.initialize({0, 1, 2, 3}, cable1d_recipe(cells), cell_to_intdom, targets, probe_map);
+    untiled.*private_pipeline_ptr = mechanism_pipeline(untiled.*private_mechanisms_ptr, 0);
+    EXPECT_EQ(0u, (untiled.*private_pipeline_ptr).num_tiles());
+
+    fvm_cell tiled(context);
+    tiled.initialize({0, 1, 2, 3}, cable1d_recipe(cells), cell_to_intdom, targets, probe_map);
+
+    auto& mechs = tiled.*private_mechanisms_ptr;
+    auto n_cv = (tiled.*private_state_ptr)->n_cv;
+    tiled.*private_pipeline_ptr = mechanism_pipeline(mechs, n_cv, 1024);
+
+    // Tiling is supported only by mechanisms without explicit vectorization.
+    bool supported = util::all_of(mechs, [](auto& m) {
+        auto mm = dynamic_cast<multicore::mechanism*>(m.get());
+        return mm && mm->supports_instance_range();
+    });
+    if (supported) {
+        EXPECT_LT(1u, (tiled.*private_pipeline_ptr).num_tiles());
+    }
+
+    std::vector<deliverable_event> events;
+    for (unsigned i = 0; i<targets.size(); ++i) {
+        events.push_back({1.f+i, targets[i], 0.1f});
+    }
+
+    untiled.integrate(20, 0.025, events, {});
+    tiled.integrate(20, 0.025, events, {});
+
+    auto& untiled_state = *(untiled.*private_state_ptr);
+    auto& tiled_state = *(tiled.*private_state_ptr);
+    EXPECT_TRUE(std::equal(untiled_state.voltage.begin(), untiled_state.voltage.end(), tiled_state.voltage.begin()));
+    EXPECT_TRUE(std::equal(untiled_state.current_density.begin(), untiled_state.current_density.end(), tiled_state.current_density.begin()));
+}
+
+// Test that with adaptive time steps quiescent cells take long steps, while
+// spike times and voltages stay close to those with fixed steps.
+
+using step_controller = backend::step_controller;
+ACCESS_BIND(step_controller fvm_cell::*, private_step_controller_ptr, &fvm_cell::step_controller_)
+ACCESS_BIND(std::size_t fvm_cell::*, private_num_steps_ptr, &fvm_cell::num_steps_)
+
+TEST(fvm_lowered, adaptive_time_step) {
+    execution_context context;
+
+    // Cells 0 and 2 are stimulated from 5 ms, and spike; 1 and 3 are quiet.
+    std::vector<cable_cell> cells;
+    for (int i = 0; i<4; ++i) {
+        cells.push_back(make_cell_ball_and_3stick(i%2==0));
+        cells.back().add_detector({0, 0}, 0);
+    }
+
+    std::vector<target_handle> targets;
+    std::vector<fvm_index_type> cell_to_intdom;
+    probe_association_map<probe_handle> probe_map;
+
+    const fvm_value_type dt = 0.025;
+    const fvm_value_type max_factor = 8;
+
+    fvm_cell fixed(context);
+    fixed.initialize({0, 1, 2, 3}, cable1d_recipe(cells), cell_to_intdom, targets, probe_map);
+
+    cable1d_recipe rec(cells);
+    rec.cable_global_properties().adaptive_dt_tolerance_mV = 0.001;
+    rec.cable_global_properties().adaptive_dt_max_factor = max_factor;
+
+    fvm_cell adaptive(context);
+    adaptive.initialize({0, 1, 2, 3}, rec, cell_to_intdom, targets, probe_map);
+
+    auto& controller = adaptive.*private_step_controller_ptr;
+    ASSERT_TRUE(controller.adaptive());
+
+    // Integrate in periods, as in a simulation.
+    std::vector<threshold_crossing> fixed_spikes, adaptive_spikes;
+    for (fvm_value_type t = 2; t<=30; t += 2) {
+        auto fixed_result = fixed.integrate(t, dt, {}, {});
+        util::append(fixed_spikes, fixed_result.crossings);
+
+        auto adaptive_result = adaptive.integrate(t, dt, {}, {});
+        util::append(adaptive_spikes, adaptive_result.crossings);
+
+        EXPECT_EQ(t, adaptive.time());
+    }
+
+    // The quiet cells take the longest steps, and the spiking cells
+    // take shorter ones.
+    const auto& steps = controller.steps();
+    EXPECT_DOUBLE_EQ(max_factor*dt, steps[1]);
+    EXPECT_DOUBLE_EQ(max_factor*dt, steps[3]);
+    EXPECT_LT(steps[0], max_factor*dt);
+
+    // Integration stops once all domains reach the end of each period,
+    // taking fewer steps than with a fixed time step.
+    EXPECT_LT(adaptive.*private_num_steps_ptr, fixed.*private_num_steps_ptr);
+
+    // Crossings are reported in order of step, which differs between the two.
+    auto by_index_time = [](const threshold_crossing& a, const threshold_crossing& b) {
+        return a.index<b.index || (a.index==b.index && a.time<b.time);
+    };
+    std::sort(fixed_spikes.begin(), fixed_spikes.end(), by_index_time);
+    std::sort(adaptive_spikes.begin(), adaptive_spikes.end(), by_index_time);
+
+    ASSERT_LT(0u, fixed_spikes.size());
+    ASSERT_EQ(fixed_spikes.size(), adaptive_spikes.size());
+    for (unsigned i = 0; i<fixed_spikes.size(); ++i) {
+        EXPECT_EQ(fixed_spikes[i].index, adaptive_spikes[i].index);
+        EXPECT_NEAR(fixed_spikes[i].time, adaptive_spikes[i].time, 0.05);
+    }
+
+    auto& fixed_state = *(fixed.*private_state_ptr);
+    auto& adaptive_state = *(adaptive.*private_state_ptr);
+    for (unsigned i = 0; i<fixed_state.n_cv; ++i) {
+        EXPECT_NEAR(fixed_state.voltage[i], adaptive_state.voltage[i], 1.);
+    }
+}
@@ -0,0 +1,129 @@
+#include "../gtest.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "graph_partition.hpp"
+#include "util/span.hpp"
+
+using namespace arb;
+using util::make_span;
+
+namespace {
+    // A grid of nx by ny unit weight vertices, with edges between neighbours.
+    weighted_graph grid_graph(unsigned nx, unsigned ny) {
+        std::vector<std::pair<unsigned, unsigned>> edges;
+        for (auto i: make_span(nx)) {
+            for (auto j: make_span(ny)) {
+                unsigned v = i*ny+j;
+                if (i+1<nx) edges.push_back({v, v+ny});
+                if (j+1<ny) edges.push_back({v, v+1});
+            }
+        }
+        return make_weighted_graph(std::vector<double>(nx*ny, 1.), edges);
+    }
+
+    std::vector<double> part_weights(const weighted_graph& g, const std::vector<unsigned>& part, unsigned num_parts) {
+        std::vector<double> w(num_parts, 0);
+        for (auto v: make_span(g.size())) {
+            EXPECT_LT(part[v], num_parts);
+            w[part[v]] += g.vertex_weights[v];
+        }
+        return w;
+    }
+}
+
+TEST(graph_partition, make_weighted_graph) {
+    // Parallel edges in either direction are merged, self loops dropped.
+    auto g = make_weighted_graph({1, 2, 3}, {{0, 1}, {1, 0}, {1, 2}, {2, 2}, {0, 1}});
+
+    ASSERT_EQ(3u, g.size());
+    EXPECT_EQ((std::vector<std::size_t>{0, 1, 3, 4}), g.offsets);
+    EXPECT_EQ((std::vector<unsigned>{1, 0, 2, 1}), g.adjacency);
+    EXPECT_EQ((std::vector<double>{3, 3, 1, 1}), g.edge_weights);
+    EXPECT_EQ((std::vector<double>{1, 2, 3}), g.vertex_weights);
+
+    EXPECT_EQ(0., edge_cut(g, {0, 0, 0}));
+    EXPECT_EQ(1., edge_cut(g, {0, 0, 1}));
+    EXPECT_EQ(4., edge_cut(g, {0, 1, 0}));
+}
+
+TEST(graph_partition, trivial) {
+    auto g = grid_graph(3, 4);
+    EXPECT_EQ(std::vector<unsigned>(12, 0), partition_graph(g, 1));
+    EXPECT_TRUE(partition_graph(weighted_graph{}, 4).empty());
+
+    // More parts than vertices: each vertex is in a part of its own.
+    auto part = partition_graph(g, 20);
+    std::sort(part.begin(), part.end());
+    EXPECT_EQ(part.end(), std::adjacent_find(part.begin(), part.end()));
+}
+
+TEST(graph_partition, grid) {
+    const unsigned nx = 64, ny = 64;
+    auto g = grid_graph(nx, ny);
+
+    for (unsigned num_parts: {2u, 4u, 7u, 16u}) {
+        auto part = partition_graph(g, num_parts);
+        ASSERT_EQ(g.size(), part.size());
+
+        auto w = part_weights(g, part, num_parts);
+        double mean = double(nx*ny)/num_parts;
+        for (auto x: w) {
+            EXPECT_LE(x, mean*1.03+1) << num_parts << " parts";
+        }
+
+        // A split into strips cuts (num_parts-1)*nx edges, which is optimal
+        // for two parts; a random partition cuts about 2*nx*ny*(1-1/num_parts).
+        EXPECT_LE(edge_cut(g, part), 1.2*(num_parts-1)*nx) << num_parts << " parts";
+
+        // The partition depends only on the arguments.
+        EXPECT_EQ(part, partition_graph(g, num_parts));
+    }
+}
+
+TEST(graph_partition, clusters) {
+    // Eight cliques of ten vertices, with the vertices of the cliques
+    // interleaved, and a single edge between consecutive cliques.
+    const unsigned n_cliques = 8, clique_size = 10;
+    std::vector<std::pair<unsigned, unsigned>> edges;
+    for (auto c: make_span(n_cliques)) {
+        for (auto i: make_span(clique_size)) {
+            for (auto j: make_span(i)) {
+                edges.push_back({i*n_cliques+c, j*n_cliques+c});
+            }
+        }
+        if (c+1<n_cliques) edges.push_back({c, c+1});
+    }
+    auto g = make_weighted_graph(std::vector<double>(n_cliques*clique_size, 1.), edges);
+
+    auto part = partition_graph(g, 4);
+    EXPECT_EQ(3., edge_cut(g, part));
+    for (auto x: part_weights(g, part, 4)) {
+        EXPECT_EQ(20., x);
+    }
+    for (auto v: make_span(g.size())) {
+        EXPECT_EQ(part[v%n_cliques], part[v]);
+    }
+}
+
+TEST(graph_partition, vertex_weights) {
+    // A chain of vertices, of which a few are much heavier than the others.
+    const unsigned n = 400;
+    std::vector<double> weights(n, 1.);
+    std::vector<std::pair<unsigned, unsigned>> edges;
+    for (auto v: make_span(n)) {
+        if (v%50==0) weights[v] = 20;
+        if (v+1<n) edges.push_back({v, v+1});
+    }
+    auto g = make_weighted_graph(weights, edges);
+
+    const unsigned num_parts = 5;
+    auto part = partition_graph(g, num_parts);
+    double mean = (n+8*19)/double(num_parts);
+    for (auto x: part_weights(g, part, num_parts)) {
+        EXPECT_LE(x, mean+20);
+    }
+    EXPECT_GE(8., edge_cut(g, part));
+}
@@ -1,5 +1,12 @@
 #include "../gtest.h"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
 #include <arbor/domain_decomposition.hpp>
 #include <arbor/lif_cell.hpp>
 #include <arbor/load_balance.hpp>
@@ -8,7 +15,11 @@
 #include <arbor/simulation.hpp>
 #include <arbor/spike_source_cell.hpp>
 
+#include "cell_chunks.hpp"
+#include "epoch.hpp"
 #include "lif_cell_group.hpp"
+#include "threading/threading.hpp"
+#include "util/rangeutil.hpp"
 
 using namespace arb;
 // Simple ring network of LIF neurons.
@@ -225,3 +236,317 @@ TEST(lif_cell_group, ring)
     }
 }
 
+
+// Spikes must not depend on the depth of the spike exchange pipeline.
+TEST(lif_cell_group, ring_pipelined)
+{
+    cell_size_type num_lif_cells = 99;
+    double weight = 1000;
+    double delay = 1;
+    time_type simulation_time = 100;
+
+    auto context = make_context(proc_allocation(2, -1));
+    auto recipe = ring_recipe(num_lif_cells, weight, delay);
+    auto decomp = partition_load_balance(recipe, context);
+
+    std::vector<spike> expected;
+    for (unsigned depth: {1u, 2u, 3u, 4u}) {
+        simulation sim(recipe, decomp, context);
+        sim.set_exchange_pipeline_depth(depth);
+
+        std::vector<spike> spike_buffer;
+        sim.set_global_spike_callback(
+            [&spike_buffer](const std::vector<spike>& spikes) {
+                spike_buffer.insert(spike_buffer.end(), spikes.begin(), spikes.end());
+            }
+        );
+
+        // Run in two parts to check that exchanges in flight are completed
+        // at the end of each run.
+        sim.run(simulation_time/2, 0.01);
+        sim.run(simulation_time, 0.01);
+
+        std::sort(spike_buffer.begin(), spike_buffer.end(),
+            [](const spike& a, const spike& b) { return a.source<b.source; });
+
+        EXPECT_EQ(num_lif_cells+1u, sim.num_spikes());
+        if (depth==1) {
+            expected = spike_buffer;
+        }
+        else {
+            ASSERT_EQ(expected.size(), spike_buffer.size());
+            for (auto i=0u; i<expected.size(); ++i) {
+                EXPECT_EQ(expected[i].source, spike_buffer[i].source);
+                EXPECT_EQ(expected[i].time, spike_buffer[i].time);
+            }
+        }
+    }
+}
+
+// LIF cells with parameters varying by gid, without connections.
+class varied_lif_recipe: public arb::recipe {
+public:
+    varied_lif_recipe(cell_size_type n): ncells_(n) {}
+
+    cell_size_type num_cells() const override {
+        return ncells_;
+    }
+
+    cell_kind get_cell_kind(cell_gid_type gid) const override {
+        return cell_kind::lif;
+    }
+
+    util::unique_any get_cell_description(cell_gid_type gid) const override {
+        return make_cell(gid);
+    }
+
+    static lif_cell make_cell(cell_gid_type gid) {
+        lif_cell c;
+        c.tau_m = 5+gid%7;
+        c.V_th = 8+gid%5;
+        c.C_m = 10+gid%3;
+        c.E_L = -double(gid%4);
+        c.V_m = c.E_L;
+        c.t_ref = 1+gid%2;
+        return c;
+    }
+
+private:
+    cell_size_type ncells_;
+};
+
+// Cells advanced in blocks and chunks must spike as when advanced one at a
+// time, event by event.
+TEST(lif_cell_group, batched)
+{
+    const cell_size_type n = 2*cell_chunks::chunk_cells+7;
+    varied_lif_recipe rec(n);
+    std::vector<cell_gid_type> gids(n);
+    std::iota(gids.begin(), gids.end(), 0u);
+
+    auto threads = std::make_shared<threading::task_system>(4);
+    lif_cell_group group(gids, rec, threads);
+
+    // Random events, with some coincident pairs.
+    std::minstd_rand R;
+    std::uniform_real_distribution<float> time_dist(0, 20), weight_dist(0, 120);
+    std::vector<pse_vector> lanes(n);
+    for (auto gid: gids) {
+        for (unsigned i = 0; i<gid%11; ++i) {
+            float t = time_dist(R);
+            lanes[gid].push_back({{gid, 0}, t, weight_dist(R)});
+            if (i%4==0) lanes[gid].push_back({{gid, 0}, t, weight_dist(R)});
+        }
+        util::sort_by(lanes[gid], [](const spike_event& e) { return e.time; });
+    }
+
+    // Reference: cells advanced one at a time.
+    std::vector<spike> expected;
+    for (auto gid: gids) {
+        auto cell = varied_lif_recipe::make_cell(gid);
+        time_type t = 0;
+        auto& lane = lanes[gid];
+        for (unsigned i = 0; i<lane.size(); ++i) {
+            auto time = lane[i].time;
+            auto weight = lane[i].weight;
+            if (time<t) continue;
+            while (i+1<lane.size() && lane[i+1].time<=time) {
+                weight += lane[++i].weight;
+            }
+            cell.V_m = cell.V_m*std::exp(-(time-t)/cell.tau_m) + weight/cell.C_m;
+            t = time;
+            if (cell.V_m>=cell.V_th) {
+                expected.push_back({{gid, 0}, t});
+                t += cell.t_ref;
+                cell.V_m = cell.E_L;
+            }
+        }
+    }
+
+    auto by_source_time = [](const spike& s) { return std::make_pair(s.source, s.time); };
+    util::sort_by(expected, by_source_time);
+    ASSERT_LT(0u, expected.size());
+
+    // The events of each of two epochs.
+    std::vector<pse_vector> epoch_lanes[2];
+    for (auto& lane: lanes) {
+        auto mid = std::lower_bound(lane.begin(), lane.end(), 10.f,
+            [](const spike_event& e, float t) { return e.time<t; });
+        epoch_lanes[0].emplace_back(lane.begin(), mid);
+        epoch_lanes[1].emplace_back(mid, lane.end());
+    }
+
+    for (int pass = 0; pass<2; ++pass) {
+        epoch ep(0, 10);
+        group.advance(ep, 0.01, util::subrange_view(epoch_lanes[0], 0, n));
+        ep.advance(30);
+        group.advance(ep, 0.01, util::subrange_view(epoch_lanes[1], 0, n));
+
+        auto spikes = group.spikes();
+        util::sort_by(spikes, by_source_time);
+        EXPECT_EQ(expected, spikes);
+
+        // Reset restores the initial state.
+        group.reset();
+        EXPECT_TRUE(group.spikes().empty());
+    }
+}
+
+// Varied LIF cells with one membrane potential probe each.
+class probe_lif_recipe: public varied_lif_recipe {
+public:
+    using varied_lif_recipe::varied_lif_recipe;
+
+    cell_size_type num_probes(cell_gid_type) const override {
+        return 1;
+    }
+
+    probe_info get_probe(cell_member_type probe_id) const override {
+        return {probe_id, int(probe_id.gid), lif_probe_voltage{}};
+    }
+};
+
+// Samples are taken from the exact solution at the sample times.
+TEST(lif_cell_group, sampling)
+{
+    const cell_size_type n = 2*lif_cell_group::simd_width+3;
+    probe_lif_recipe rec(n);
+    std::vector<cell_gid_type> gids(n);
+    std::iota(gids.begin(), gids.end(), 0u);
+    lif_cell_group group(gids, rec);
+
+    std::minstd_rand R;
+    std::uniform_real_distribution<float> time_dist(0, 20), weight_dist(0, 120);
+    std::vector<pse_vector> lanes(n);
+    for (auto gid: gids) {
+        for (unsigned i = 0; i<gid%7; ++i) {
+            lanes[gid].push_back({{gid, 0}, time_dist(R), weight_dist(R)});
+        }
+        util::sort_by(lanes[gid], [](const spike_event& e) { return e.time; });
+    }
+
+    // Reference membrane potential of cell gid at time ts, with the events
+    // before ts, or at ts, applied.
+    auto reference = [&](cell_gid_type gid, time_type ts) {
+        auto cell = varied_lif_recipe::make_cell(gid);
+        time_type t = 0;
+        for (auto& e: lanes[gid]) {
+            if (e.time>ts) break;
+            if (e.time<t) continue;
+            cell.V_m = cell.V_m*std::exp(-(e.time-t)/cell.tau_m) + e.weight/cell.C_m;
+            t = e.time;
+            if (cell.V_m>=cell.V_th) {
+                t += cell.t_ref;
+                cell.V_m = cell.E_L;
+            }
+        }
+        return ts<=t? cell.V_m: cell.V_m*std::exp(-(ts-t)/cell.tau_m);
+    };
+
+    // A sampler on the odd cells, and a bulk sampler on all cells.
+    std::vector<std::vector<std::pair<time_type, double>>> samples(n);
+    group.add_sampler(0, [](cell_member_type pid) { return pid.gid%2; }, regular_schedule(0.5),
+        [&](cell_member_type pid, probe_tag tag, std::size_t k, const sample_record* recs) {
+            EXPECT_EQ(int(pid.gid), tag);
+            for (std::size_t i = 0; i<k; ++i) {
+                samples[pid.gid].push_back({recs[i].time, *util::any_cast<const double*>(recs[i].data)});
+            }
+        },
+        sampling_policy::lax);
+
+    std::vector<std::vector<std::pair<double, double>>> bulk_samples(n);
+    group.add_bulk_sampler(1, all_probes, regular_schedule(0.75),
+        [&](const sample_block& block) {
+            for (std::size_t p = 0; p<block.n_probes; ++p) {
+                auto gid = block.probe_ids[p].gid;
+                for (std::size_t j = 0; j<block.n_samples; ++j) {
+                    auto i = p*block.n_samples+j;
+                    bulk_samples[gid].push_back({block.time[i], block.value[i]});
+                }
+            }
+        },
+        sampling_policy::lax);
+
+    std::vector<pse_vector> epoch_lanes[2];
+    for (auto& lane: lanes) {
+        auto mid = std::lower_bound(lane.begin(), lane.end(), 10.f,
+            [](const spike_event& e, float t) { return e.time<t; });
+        epoch_lanes[0].emplace_back(lane.begin(), mid);
+        epoch_lanes[1].emplace_back(mid, lane.end());
+    }
+
+    epoch ep(0, 10);
+    group.advance(ep, 0.01, util::subrange_view(epoch_lanes[0], 0, n));
+    ep.advance(20);
+    group.advance(ep, 0.01, util::subrange_view(epoch_lanes[1], 0, n));
+
+    for (auto gid: gids) {
+        ASSERT_EQ(gid%2? 40u: 0u, samples[gid].size());
+        for (unsigned i = 0; i<samples[gid].size(); ++i) {
+            auto ts = samples[gid][i].first;
+            EXPECT_EQ(time_type(0.5*i), ts);
+            EXPECT_NEAR(reference(gid, ts), samples[gid][i].second, 1e-9);
+        }
+
+        ASSERT_EQ(27u, bulk_samples[gid].size());
+        for (unsigned i = 0; i<bulk_samples[gid].size(); ++i) {
+            auto ts = bulk_samples[gid][i].first;
+            EXPECT_EQ(time_type(0.75*i), ts);
+            EXPECT_NEAR(reference(gid, ts), bulk_samples[gid][i].second, 1e-9);
+        }
+    }
+
+    // After a reset, the same samples are taken again.
+    for (auto& s: samples) s.clear();
+    group.remove_sampler(1);
+    group.reset();
+    group.advance(epoch(0, 10), 0.01, util::subrange_view(epoch_lanes[0], 0, n));
+    EXPECT_EQ(20u, samples[1].size());
+    EXPECT_NEAR(reference(1, 9.5f), samples[1].back().second, 1e-9);
+}
+
+// Probes of a LIF cell other than lif_probe_voltage are rejected.
+TEST(lif_cell_group, bad_probe)
+{
+    struct bad_probe_recipe: probe_lif_recipe {
+        using probe_lif_recipe::probe_lif_recipe;
+
+        probe_info get_probe(cell_member_type probe_id) const override {
+            return {probe_id, 0, probe_id.gid};
+        }
+    };
+
+    bad_probe_recipe rec(3);
+    try {
+        lif_cell_group group({0, 1, 2}, rec);
+        FAIL() << "expected bad_probe_id";
+    }
+    catch (bad_probe_id& e) {
+        EXPECT_EQ((cell_member_type{0, 0}), e.probe_id);
+    }
+}
+
+// Event times are binned according to the binning policy.
+TEST(lif_cell_group, binning)
+{
+    varied_lif_recipe rec(1);
+    auto cell = varied_lif_recipe::make_cell(0);
+    lif_cell_group group({0}, rec);
+
+    // Each event alone makes the cell spike.
+    float w = 2*cell.V_th*cell.C_m;
+    std::vector<pse_vector> lanes = {{{{0, 0}, 2.7f, w}, {{0, 0}, 6.2f, w}}};
+
+    group.set_binning_policy(binning_kind::regular, 1);
+    group.advance(epoch(0, 10), 0.01, util::subrange_view(lanes, 0, 1));
+
+    std::vector<spike> expected = {{{0, 0}, 2.f}, {{0, 0}, 6.f}};
+    EXPECT_EQ(expected, group.spikes());
+
+    group.reset();
+    group.set_binning_policy(binning_kind::none, 0);
+    group.advance(epoch(0, 10), 0.01, util::subrange_view(lanes, 0, 1));
+
+    expected = {{{0, 0}, 2.7f}, {{0, 0}, 6.2f}};
+    EXPECT_EQ(expected, group.spikes());
+}
@@ -93,3 +93,61 @@ TEST(local_context, gather_gids)
     EXPECT_EQ(part[0], 0u);
     EXPECT_EQ(part[1], gids.size());
 }
+
+TEST(local_context, gather_cell_costs)
+{
+    arb::local_context ctx;
+
+    std::vector<double> costs = {0.5, 1.0, 1.5};
+
+    auto s = ctx.gather_cell_costs(costs);
+
+    auto& part = s.partition();
+    EXPECT_EQ(s.values(), costs);
+    EXPECT_EQ(part.size(), 2u);
+    EXPECT_EQ(part[0], 0u);
+    EXPECT_EQ(part[1], costs.size());
+}
+
+TEST(local_context, alltoall_spikes)
+{
+    arb::local_context ctx;
+    using svec = std::vector<arb::spike>;
+
+    svec spikes = {
+        {{0u,3u}, 42.f},
+        {{1u,2u}, 42.f},
+        {{2u,1u}, 42.f},
+    };
+
+    auto s = ctx.alltoall_spikes(spikes, {0u, 3u});
+
+    auto& part = s.partition();
+    EXPECT_EQ(s.values(), spikes);
+    EXPECT_EQ(part.size(), 2u);
+    EXPECT_EQ(part[0], 0u);
+    EXPECT_EQ(part[1], spikes.size());
+}
+
+TEST(local_context, gather_spikes_compressed)
+{
+    arb::local_context ctx;
+    using svec = std::vector<arb::spike>;
+
+    svec spikes = {
+        {{0u,3u}, 40.},
+        {{1u,2u}, 40.5},
+        {{2u,1u}, 41.25},
+        {{3u,0u}, 42.},
+    };
+
+    auto request = ctx.gather_spikes_compressed_async(spikes);
+    EXPECT_TRUE(request.test());
+    auto s = request.finish();
+
+    auto& part = s.partition();
+    EXPECT_EQ(s.values(), spikes);
+    EXPECT_EQ(part.size(), 2u);
+    EXPECT_EQ(part[0], 0u);
+    EXPECT_EQ(part[1], spikes.size());
+}
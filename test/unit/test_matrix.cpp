@@ -1,4 +1,6 @@
+#include <memory>
 #include <numeric>
+#include <random>
 #include <vector>
 
 #include "../gtest.h"
@@ -7,6 +9,7 @@
 
 #include "matrix.hpp"
 #include "backends/multicore/fvm.hpp"
+#include "threading/threading.hpp"
 #include "util/rangeutil.hpp"
 #include "util/span.hpp"
 
@@ -182,3 +185,237 @@ TEST(matrix, zero_diagonal_assembled)
     EXPECT_TRUE(testing::seq_almost_eq<double>(expected, x));
 }
 
+
+TEST(matrix, branch_schedule)
+{
+    // Cell with CVs:
+    //
+    //   0 - 1 - 2 - 3 - 4
+    //           |   |
+    //           5   6 - 7
+    //           |
+    //           8
+    //
+    // Branches by level: {0, 1, 2}; {5, 8}, {3}; {6, 7}, {4}.
+
+    std::vector<index_type> p = {0, 0, 1, 2, 3, 2, 3, 6, 5};
+    multicore::branch_schedule<index_type> s(p, 0, 9);
+
+    EXPECT_EQ(5, s.num_branches());
+    EXPECT_EQ(3, s.num_levels());
+    EXPECT_EQ((std::vector<index_type>{0, 1, 3, 5}), s.level_divs);
+    EXPECT_EQ((std::vector<index_type>{0, 3, 5, 6, 8, 9}), s.node_divs);
+    EXPECT_EQ((std::vector<index_type>{0, 1, 2, 5, 8, 3, 6, 7, 4}), s.nodes);
+}
+
+TEST(matrix, solve_threaded)
+{
+    using util::assign;
+    using array = matrix_type::array;
+
+    // One large cell with random branching between two small cells, solved
+    // in parallel; the results should be identical to the serial solution.
+
+    std::minstd_rand R(17);
+    std::vector<index_type> p, c = {0};
+    for (index_type n: {10, 8000, 20}) {
+        index_type first = p.size();
+        p.push_back(first);
+        for (index_type i = 1; i<n; ++i) {
+            // Mostly unbranched, with frequent branch points.
+            index_type back = std::uniform_int_distribution<index_type>(1, 10)(R);
+            p.push_back(first+std::max(0, i-(back>3? 1: back*7)));
+        }
+        c.push_back(p.size());
+    }
+    const index_type n = p.size();
+
+    std::uniform_real_distribution<value_type> U(0.5, 2);
+    vvec Cm, g, area;
+    array v(n), i(n), mg(n);
+    for (index_type k = 0; k<n; ++k) {
+        Cm.push_back(U(R));
+        g.push_back(k? U(R): 0);
+        area.push_back(U(R));
+        v[k] = -65*U(R);
+        i[k] = U(R);
+        mg[k] = U(R);
+    }
+    std::vector<index_type> s = {0, 1, 2};
+    array dt(3, 0.025);
+
+    auto threads = std::make_shared<threading::task_system>(4);
+
+    matrix_type serial(p, c, Cm, g, area, s);
+    matrix_type threaded(p, c, Cm, g, area, s, threads);
+
+    serial.assemble(dt, v, i, mg);
+    serial.solve();
+    threaded.assemble(dt, v, i, mg);
+    threaded.solve();
+
+    vvec x_serial, x_threaded;
+    assign(x_serial, serial.solution());
+    assign(x_threaded, threaded.solution());
+    EXPECT_EQ(x_serial, x_threaded);
+}
+
+TEST(matrix, solve_lanes)
+{
+    using util::assign;
+    using array = matrix_type::array;
+
+    // Eleven cells with the same tree, solved in lane-interleaved blocks,
+    // and two cells with a different tree; one cell has a zero dt.
+    // Compare against the solution of each cell on its own.
+
+    std::minstd_rand R(23);
+    std::uniform_real_distribution<value_type> U(0.5, 2);
+
+    std::vector<index_type> tree = {0};
+    for (index_type i = 1; i<50; ++i) {
+        tree.push_back(i%7? i-1: i/2);
+    }
+    std::vector<std::vector<index_type>> trees(11, tree);
+    trees.push_back({0, 0, 1});
+    trees.push_back({0, 0, 0, 1});
+
+    std::vector<index_type> p, c = {0}, s;
+    for (auto& t: trees) {
+        index_type first = p.size();
+        for (auto i: t) p.push_back(first+i);
+        c.push_back(p.size());
+        s.push_back(s.size());
+    }
+    const index_type n = p.size();
+    const index_type ncells = trees.size();
+
+    vvec Cm, g, area, v, i, mg;
+    for (index_type k = 0; k<n; ++k) {
+        Cm.push_back(U(R));
+        g.push_back(p[k]==k? 0: U(R)); // no face conductance at cell roots
+        area.push_back(U(R));
+        v.push_back(-65*U(R));
+        i.push_back(U(R));
+        mg.push_back(U(R));
+    }
+    vvec dt(ncells, 0.025);
+    dt[4] = 0;
+
+    matrix_type m(p, c, Cm, g, area, s);
+    m.assemble(array(dt.begin(), dt.end()), array(v.begin(), v.end()), array(i.begin(), i.end()), array(mg.begin(), mg.end()));
+    m.solve();
+
+    vvec x;
+    assign(x, m.solution());
+
+    for (index_type k = 0; k<ncells; ++k) {
+        auto first = c[k], last = c[k+1];
+        auto slice = [&](const vvec& a) { return array(a.begin()+first, a.begin()+last); };
+        auto vslice = [&](const vvec& a) { return vvec(a.begin()+first, a.begin()+last); };
+
+        matrix_type mk(trees[k], {0, last-first}, vslice(Cm), vslice(g), vslice(area), {0});
+        mk.assemble(array(1, dt[k]), slice(v), slice(i), slice(mg));
+        mk.solve();
+
+        vvec xk;
+        assign(xk, mk.solution());
+        EXPECT_TRUE(testing::seq_almost_eq<double>(xk, vslice(x)));
+    }
+}
+
+TEST(matrix, reuse_factorization)
+{
+    using util::assign;
+    using array = matrix_type::array;
+
+    // Three cells with the same tree, solved in a lane block, a small cell,
+    // one with zero dt, and a large cell solved by branch. Solutions with
+    // reuse of the factorization are identical to those without while the
+    // diagonal is unchanged or refactored, and close within the tolerance.
+
+    std::minstd_rand R(29);
+    std::uniform_real_distribution<value_type> U(0.5, 2);
+
+    std::vector<std::vector<index_type>> trees;
+    std::vector<index_type> tree = {0};
+    for (index_type i = 1; i<50; ++i) {
+        tree.push_back(i%7? i-1: i/2);
+    }
+    trees.assign(3, tree);
+    trees.push_back({0, 0, 1});
+    trees.push_back({0, 0, 0, 1});
+
+    tree = {0};
+    for (index_type i = 1; i<5000; ++i) {
+        tree.push_back(i%5? i-1: i/3);
+    }
+    trees.push_back(tree);
+
+    std::vector<index_type> p, c = {0}, s;
+    for (auto& t: trees) {
+        index_type first = p.size();
+        for (auto i: t) p.push_back(first+i);
+        c.push_back(p.size());
+        s.push_back(s.size());
+    }
+    const index_type n = p.size();
+    const index_type ncells = trees.size();
+
+    vvec Cm, g, area;
+    array v(n), i(n), mg(n);
+    for (index_type k = 0; k<n; ++k) {
+        Cm.push_back(U(R));
+        g.push_back(p[k]==k? 0: U(R));
+        area.push_back(U(R));
+        mg[k] = U(R);
+    }
+    array dt(ncells, 0.025);
+    dt[4] = 0;
+
+    auto threads = std::make_shared<threading::task_system>(4);
+    matrix_type full(p, c, Cm, g, area, s, threads);
+    matrix_type reuse(p, c, Cm, g, area, s, threads, true);
+
+    auto step = [&]() {
+        for (index_type k = 0; k<n; ++k) {
+            v[k] = -65*U(R);
+            i[k] = U(R);
+        }
+        full.assemble(dt, v, i, mg);
+        full.solve();
+        reuse.assemble(dt, v, i, mg);
+        reuse.solve();
+
+        vvec x_full, x_reuse;
+        assign(x_full, full.solution());
+        assign(x_reuse, reuse.solution());
+        return std::make_pair(x_full, x_reuse);
+    };
+
+    // First factorization.
+    auto x = step();
+    EXPECT_EQ(x.first, x.second);
+
+    // Unchanged diagonal.
+    x = step();
+    EXPECT_EQ(x.first, x.second);
+
+    // Changed conductivity in a cell of the lane block and the large cell,
+    // and a cell with dt no longer zero.
+    mg[c[1]+3] *= 2;
+    mg[c[5]+100] *= 2;
+    dt[4] = 0.025;
+    x = step();
+    EXPECT_EQ(x.first, x.second);
+
+    x = step();
+    EXPECT_EQ(x.first, x.second);
+
+    // Change of dt within the tolerance.
+    for (auto& t: dt) t *= 1+1e-12;
+    x = step();
+    for (index_type k = 0; k<n; ++k) {
+        EXPECT_NEAR(x.first[k], x.second[k], 1e-9*std::abs(x.first[k]));
+    }
+}
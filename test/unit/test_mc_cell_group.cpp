@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <map>
+#include <utility>
+
 #include "../gtest.h"
 
 #include <arbor/common_types.hpp>
 
+#include "backends/event.hpp"
+
 #include "epoch.hpp"
 #include "fvm_lowered_cell.hpp"
 #include "mc_cell_group.hpp"
@@ -35,6 +41,16 @@ ACCESS_BIND(
     private_spike_sources_ptr,
     &mc_cell_group::spike_sources_)
 
+ACCESS_BIND(
+    std::vector<deliverable_event> mc_cell_group::*,
+    private_staged_events_ptr,
+    &mc_cell_group::staged_events_)
+
+ACCESS_BIND(
+    std::vector<fvm_index_type> mc_cell_group::*,
+    private_cell_to_intdom_ptr,
+    &mc_cell_group::cell_to_intdom_)
+
 TEST(mc_cell_group, get_kind) {
     mc_cell_group group{{0}, cable1d_recipe(make_cell()), lowered_cell()};
 
@@ -85,3 +101,119 @@ TEST(mc_cell_group, sources) {
     }
 }
 
+
+TEST(mc_cell_group, staged_events) {
+    // Cells 0, 2 and 4 are joined by gap junctions in one integration
+    // domain, and cells 1 and 3 are each in their own.
+    struct gj_recipe: cable1d_recipe {
+        using cable1d_recipe::cable1d_recipe;
+
+        std::vector<gap_junction_connection> gap_junctions_on(cell_gid_type gid) const override {
+            switch (gid) {
+            case 0: return {gap_junction_connection({0, 0}, {2, 0}, 0.1)};
+            case 2: return {gap_junction_connection({0, 0}, {2, 0}, 0.1), gap_junction_connection({2, 0}, {4, 0}, 0.1)};
+            case 4: return {gap_junction_connection({2, 0}, {4, 0}, 0.1)};
+            default: return {};
+            }
+        }
+    };
+
+    std::vector<cable_cell> cells;
+    for (int i = 0; i<5; ++i) {
+        cells.push_back(make_cell());
+        cells.back().add_gap_junction({0, 0.5});
+        cells.back().add_synapse({1, 0.5}, "expsyn");
+        cells.back().add_synapse({1, 0.9}, "expsyn");
+    }
+
+    mc_cell_group group{{0, 1, 2, 3, 4}, gj_recipe(cells), lowered_cell()};
+    const auto& cell_to_intdom = group.*private_cell_to_intdom_ptr;
+    ASSERT_EQ(cell_to_intdom[0], cell_to_intdom[2]);
+    ASSERT_EQ(cell_to_intdom[0], cell_to_intdom[4]);
+    ASSERT_NE(cell_to_intdom[1], cell_to_intdom[3]);
+
+    // Sorted lanes with interleaved times; events at or after the end of
+    // the epoch are not staged.
+    std::vector<pse_vector> lanes(5);
+    for (unsigned i = 0; i<5; ++i) {
+        for (unsigned j = 0; j<6; ++j) {
+            lanes[i].push_back({{i, j%2}, float(0.1*i+0.5*j), float(j)});
+        }
+    }
+
+    for (int epoch_index = 0; epoch_index<2; ++epoch_index) {
+        group.advance(epoch(epoch_index, 2.0), 0.025, util::subrange_view(lanes, 0, lanes.size()));
+
+        const auto& staged = group.*private_staged_events_ptr;
+        std::size_t n_expected = 0;
+        for (auto& lane: lanes) {
+            n_expected += std::count_if(lane.begin(), lane.end(), [](const spike_event& e) { return e.time<2.0; });
+        }
+        ASSERT_EQ(n_expected, staged.size());
+
+        for (std::size_t k = 1; k<staged.size(); ++k) {
+            auto d0 = staged[k-1].handle.intdom_index;
+            auto d1 = staged[k].handle.intdom_index;
+            EXPECT_LE(d0, d1);
+            if (d0==d1) {
+                EXPECT_LE(staged[k-1].time, staged[k].time);
+            }
+        }
+        group.reset();
+    }
+}
+
+TEST(mc_cell_group, bulk_sampler) {
+    std::vector<cable_cell> cells = {make_cell(), make_cell(), make_cell()};
+    cable1d_recipe rec(cells);
+    for (cell_gid_type gid = 0; gid<3; ++gid) {
+        rec.add_probe(gid, 10, cell_probe_address{{0, 0.5}, cell_probe_address::membrane_voltage});
+        rec.add_probe(gid, 20, cell_probe_address{{1, 0.5}, cell_probe_address::membrane_current});
+    }
+
+    mc_cell_group group{{0, 1, 2}, rec, lowered_cell()};
+
+    // Samples by probe from a sampler and from a bulk sampler on the
+    // same probes and schedule.
+    std::map<cell_member_type, std::vector<std::pair<time_type, double>>> expected, bulk;
+    std::map<cell_member_type, probe_tag> expected_tags, bulk_tags;
+
+    group.add_sampler(0, all_probes, regular_schedule(0.5),
+        [&](cell_member_type pid, probe_tag tag, std::size_t n, const sample_record* records) {
+            expected_tags[pid] = tag;
+            for (std::size_t i = 0; i<n; ++i) {
+                expected[pid].push_back({records[i].time, *util::any_cast<const double*>(records[i].data)});
+            }
+        },
+        sampling_policy::lax);
+
+    unsigned n_calls = 0;
+    group.add_bulk_sampler(1, all_probes, regular_schedule(0.5),
+        [&](const sample_block& block) {
+            ++n_calls;
+            for (std::size_t p = 0; p<block.n_probes; ++p) {
+                auto pid = block.probe_ids[p];
+                bulk_tags[pid] = block.tags[p];
+                for (std::size_t j = 0; j<block.n_samples; ++j) {
+                    auto k = p*block.n_samples+j;
+                    bulk[pid].push_back({time_type(block.time[k]), block.value[k]});
+                }
+            }
+        },
+        sampling_policy::lax);
+
+    group.advance(epoch(0, 5.0), 0.025, {});
+    group.advance(epoch(1, 10.0), 0.025, {});
+
+    // One call per epoch for all six probes.
+    EXPECT_EQ(2u, n_calls);
+    EXPECT_EQ(6u, bulk.size());
+    EXPECT_EQ(expected_tags, bulk_tags);
+    EXPECT_EQ(expected, bulk);
+
+    // Removing the bulk sampler leaves the other in place.
+    group.remove_sampler(1);
+    group.advance(epoch(2, 15.0), 0.025, {});
+    EXPECT_EQ(2u, n_calls);
+    EXPECT_EQ(30u, expected[cell_member_type({0, 0})].size());
+}
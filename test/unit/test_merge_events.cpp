@@ -1,5 +1,7 @@
 #include "../gtest.h"
 
+#include <algorithm>
+#include <random>
 #include <vector>
 
 #include <arbor/event_generator.hpp>
@@ -273,3 +275,81 @@ TEST(merge_events, tourney_poisson)
     EXPECT_TRUE(std::is_sorted(lf.begin(), lf.end()));
     EXPECT_EQ(lf, expected);
 }
+
+// Test tree_merge_events with few non-empty sources, which are merged
+// without the tournament tree.
+TEST(merge_events, tree_merge_few)
+{
+    pse_vector evs1 = {
+        {{0, 0}, 1, 1},
+        {{0, 0}, 3, 3},
+    };
+    pse_vector evs2 = {
+        {{0, 0}, 2, 2},
+        {{0, 0}, 3, 1},
+    };
+    pse_vector empty;
+
+    auto span = [](const pse_vector& v) { return util::range_pointer_view(v); };
+
+    // No non-empty sources.
+    {
+        std::vector<event_span> spans = {span(empty), span(empty)};
+        pse_vector lf = {{{1, 0}, 0, 0}};
+        tree_merge_events(spans, lf);
+        EXPECT_EQ(1u, lf.size());
+    }
+    // One non-empty source, appended to existing output.
+    {
+        std::vector<event_span> spans = {span(empty), span(evs1), span(empty)};
+        pse_vector lf = {{{1, 0}, 0, 0}};
+        tree_merge_events(spans, lf);
+        pse_vector expected = {{{1, 0}, 0, 0}};
+        util::append(expected, evs1);
+        EXPECT_EQ(expected, lf);
+    }
+    // Two non-empty sources.
+    {
+        std::vector<event_span> spans = {span(evs2), span(empty), span(evs1)};
+        pse_vector lf;
+        tree_merge_events(spans, lf);
+        pse_vector expected = evs1;
+        util::append(expected, evs2);
+        util::sort(expected);
+        EXPECT_EQ(expected, lf);
+    }
+}
+
+// Test that sort_events gives the same order as a comparison sort, for
+// sequences that are sorted with and without the radix sort.
+TEST(merge_events, sort_events)
+{
+    std::mt19937 gen;
+    std::uniform_int_distribution<int> time_dist(-4, 40);
+    std::uniform_int_distribution<cell_gid_type> gid_dist(0, 3);
+    std::uniform_int_distribution<cell_lid_type> lid_dist(0, 300);
+    std::uniform_int_distribution<int> weight_dist(-2, 2);
+
+    for (std::size_t n: {0, 1, 10, 1000, 5000}) {
+        pse_vector events;
+        for (std::size_t i=0; i<n; ++i) {
+            // Coarse times and weights give many ties in time and target.
+            // Weights include -0 and +0, which compare equal.
+            float w = weight_dist(gen)*0.5f;
+            if (w==0 && i%2) w = -0.f;
+            events.push_back({{gid_dist(gen), lid_dist(gen)}, time_dist(gen)*0.25f, w});
+        }
+
+        auto expected = events;
+        std::sort(expected.begin(), expected.end());
+
+        sort_events(events);
+        EXPECT_TRUE(std::is_sorted(events.begin(), events.end()));
+        ASSERT_EQ(expected.size(), events.size());
+        for (std::size_t i=0; i<n; ++i) {
+            EXPECT_EQ(expected[i].target, events[i].target);
+            EXPECT_EQ(expected[i].time, events[i].time);
+            EXPECT_EQ(expected[i].weight, events[i].weight);
+        }
+    }
+}
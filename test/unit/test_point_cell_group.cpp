@@ -0,0 +1,298 @@
+#include "../gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <arbor/adex_cell.hpp>
+#include <arbor/arbexcept.hpp>
+#include <arbor/izhikevich_cell.hpp>
+#include <arbor/load_balance.hpp>
+#include <arbor/recipe.hpp>
+#include <arbor/schedule.hpp>
+#include <arbor/simulation.hpp>
+#include <arbor/spike_source_cell.hpp>
+
+#include "adex_cell_group.hpp"
+#include "cell_chunks.hpp"
+#include "epoch.hpp"
+#include "izhikevich_cell_group.hpp"
+#include "threading/threading.hpp"
+#include "util/rangeutil.hpp"
+
+using namespace arb;
+
+namespace {
+    adex_cell make_adex_cell(cell_gid_type gid) {
+        adex_cell c;
+        c.C_m = 200+10*(gid%5);
+        c.a = 2*(gid%3);
+        c.b = 40+20*(gid%4);
+        c.t_ref = 0.5*(gid%3);
+        c.I_e = 100*(gid%9);
+        return c;
+    }
+
+    izhikevich_cell make_izhikevich_cell(cell_gid_type gid) {
+        // Regular spiking, fast spiking and chattering cells.
+        izhikevich_cell c;
+        switch (gid%3) {
+        case 1:
+            c.a = 0.1;
+            break;
+        case 2:
+            c.c = -50;
+            c.d = 2;
+            break;
+        }
+        c.I_e = gid%5;
+        c.u = c.b*c.V_m;
+        return c;
+    }
+
+    // Point neurons of one kind with parameters varying by gid, without
+    // connections.
+    class point_recipe: public arb::recipe {
+    public:
+        point_recipe(cell_size_type n, cell_kind kind): ncells_(n), kind_(kind) {}
+
+        cell_size_type num_cells() const override {
+            return ncells_;
+        }
+
+        cell_kind get_cell_kind(cell_gid_type gid) const override {
+            return kind_;
+        }
+
+        util::unique_any get_cell_description(cell_gid_type gid) const override {
+            if (kind_==cell_kind::adex) {
+                return make_adex_cell(gid);
+            }
+            return make_izhikevich_cell(gid);
+        }
+
+    private:
+        cell_size_type ncells_;
+        cell_kind kind_;
+    };
+
+    // Reference forward Euler steps of a single cell.
+    void step_cell(adex_cell& c, double& refractory_end, double t, double h, double x, std::vector<spike>& spikes, cell_gid_type gid) {
+        double dV = (c.g_L*(c.E_L-c.V_m+c.delta_T*std::exp((c.V_m-c.V_T)/c.delta_T)) - c.w + c.I_e)/c.C_m;
+        double dw = (c.a*(c.V_m-c.E_L) - c.w)/c.tau_w;
+        c.V_m += h*dV + x/c.C_m;
+        c.w += h*dw;
+        if (t<refractory_end) {
+            c.V_m = c.V_reset;
+        }
+        if (c.V_m>=c.V_peak) {
+            spikes.push_back({{gid, 0}, time_type(t+h)});
+            c.V_m = c.V_reset;
+            c.w += c.b;
+            refractory_end = t+h+c.t_ref;
+        }
+    }
+
+    void step_cell(izhikevich_cell& c, double&, double t, double h, double x, std::vector<spike>& spikes, cell_gid_type gid) {
+        double dV = (0.04*c.V_m+5)*c.V_m + 140 - c.u + c.I_e;
+        double du = c.a*(c.b*c.V_m - c.u);
+        c.V_m += h*dV + x;
+        c.u += h*du;
+        if (c.V_m>=c.V_peak) {
+            spikes.push_back({{gid, 0}, time_type(t+h)});
+            c.V_m = c.c;
+            c.u += c.d;
+        }
+    }
+
+    // Cells advanced in blocks and chunks must spike as when advanced one
+    // at a time, step by step.
+    template <typename Group, typename MakeCell>
+    void check_batched(cell_kind kind, MakeCell make_cell, float max_weight) {
+        const cell_size_type n = cell_chunks::chunk_cells+7;
+        const double dt = 0.025;
+        const time_type tmid = 10, tfinal = 30;
+
+        point_recipe rec(n, kind);
+        std::vector<cell_gid_type> gids(n);
+        std::iota(gids.begin(), gids.end(), 0u);
+
+        auto threads = std::make_shared<threading::task_system>(4);
+        Group group(gids, rec, threads);
+        EXPECT_EQ(kind, group.get_cell_kind());
+
+        // Random events, with some in the same step.
+        std::minstd_rand R;
+        std::uniform_real_distribution<float> time_dist(0, tfinal), weight_dist(0, max_weight);
+        std::vector<pse_vector> lanes(n);
+        for (auto gid: gids) {
+            for (unsigned i = 0; i<gid%13; ++i) {
+                float t = time_dist(R);
+                lanes[gid].push_back({{gid, 0}, t, weight_dist(R)});
+                if (i%4==0) lanes[gid].push_back({{gid, 0}, t+0.001f, weight_dist(R)});
+            }
+            util::sort_by(lanes[gid], [](const spike_event& e) { return e.time; });
+        }
+
+        // Reference: cells advanced one at a time over the steps of the
+        // two epochs.
+        std::vector<spike> expected;
+        for (auto gid: gids) {
+            auto cell = make_cell(gid);
+            double refractory_end = 0;
+            auto& lane = lanes[gid];
+            unsigned i = 0;
+            for (auto ep: {std::make_pair(time_type(0), tmid), std::make_pair(tmid, tfinal)}) {
+                double t0 = ep.first, span = ep.second-t0;
+                auto n_steps = std::max(1.0, std::ceil(span/dt-1e-6));
+                double h = span/n_steps;
+                for (unsigned s = 0; s<n_steps; ++s) {
+                    double x = 0;
+                    for (; i<lane.size() && lane[i].time<t0+(s+1)*h; ++i) {
+                        x += lane[i].weight;
+                    }
+                    step_cell(cell, refractory_end, t0+s*h, h, x, expected, gid);
+                }
+            }
+        }
+
+        auto by_source_time = [](const spike& s) { return std::make_pair(s.source, s.time); };
+        util::sort_by(expected, by_source_time);
+        ASSERT_LT(0u, expected.size());
+
+        // The events of each of the two epochs.
+        std::vector<pse_vector> epoch_lanes[2];
+        for (auto& lane: lanes) {
+            auto mid = std::lower_bound(lane.begin(), lane.end(), tmid,
+                [](const spike_event& e, float t) { return e.time<t; });
+            epoch_lanes[0].emplace_back(lane.begin(), mid);
+            epoch_lanes[1].emplace_back(mid, lane.end());
+        }
+
+        for (int pass = 0; pass<2; ++pass) {
+            epoch ep(0, tmid);
+            group.advance(ep, dt, util::subrange_view(epoch_lanes[0], 0, n));
+            ep.advance(tfinal);
+            group.advance(ep, dt, util::subrange_view(epoch_lanes[1], 0, n));
+
+            auto spikes = group.spikes();
+            util::sort_by(spikes, by_source_time);
+            EXPECT_EQ(expected, spikes);
+
+            // Reset restores the initial state.
+            group.reset();
+            EXPECT_TRUE(group.spikes().empty());
+        }
+    }
+
+    // Cells advanced without event lanes must spike as with empty lanes.
+    template <typename Group>
+    void check_no_events(cell_kind kind) {
+        const cell_size_type n = cell_chunks::chunk_cells+7;
+        point_recipe rec(n, kind);
+        std::vector<cell_gid_type> gids(n);
+        std::iota(gids.begin(), gids.end(), 0u);
+
+        Group group(gids, rec);
+        std::vector<pse_vector> lanes(n);
+        group.advance(epoch(0, 30), 0.025, util::subrange_view(lanes, 0, n));
+        auto expected = group.spikes();
+        ASSERT_LT(0u, expected.size());
+
+        group.reset();
+        group.advance(epoch(0, 30), 0.025, {});
+        EXPECT_EQ(expected, group.spikes());
+    }
+
+    // A spike source driving a chain of Izhikevich cells.
+    class izhikevich_chain_recipe: public arb::recipe {
+    public:
+        izhikevich_chain_recipe(cell_size_type n): ncells_(n) {}
+
+        cell_size_type num_cells() const override {
+            return ncells_+1;
+        }
+
+        cell_kind get_cell_kind(cell_gid_type gid) const override {
+            return gid? cell_kind::izhikevich: cell_kind::spike_source;
+        }
+
+        util::unique_any get_cell_description(cell_gid_type gid) const override {
+            if (!gid) {
+                return spike_source_cell{regular_schedule(0, 20)};
+            }
+            return izhikevich_cell{};
+        }
+
+        cell_size_type num_sources(cell_gid_type) const override {
+            return 1;
+        }
+
+        cell_size_type num_targets(cell_gid_type gid) const override {
+            return gid? 1: 0;
+        }
+
+        std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+            if (!gid) return {};
+            return {cell_connection({gid-1, 0}, {gid, 0}, 40.f, 2.f)};
+        }
+
+    private:
+        cell_size_type ncells_;
+    };
+}
+
+TEST(point_cell_group, adex_batched) {
+    check_batched<adex_cell_group>(cell_kind::adex, make_adex_cell, 3000);
+}
+
+TEST(point_cell_group, izhikevich_batched) {
+    check_batched<izhikevich_cell_group>(cell_kind::izhikevich, make_izhikevich_cell, 15);
+}
+
+TEST(point_cell_group, no_events) {
+    check_no_events<adex_cell_group>(cell_kind::adex);
+    check_no_events<izhikevich_cell_group>(cell_kind::izhikevich);
+}
+
+TEST(point_cell_group, bad_description) {
+    point_recipe rec(2, cell_kind::adex);
+    EXPECT_THROW(izhikevich_cell_group({0, 1}, rec), bad_cell_description);
+}
+
+TEST(point_cell_group, chain) {
+    const cell_size_type n = 5;
+    izhikevich_chain_recipe recipe(n);
+    auto context = make_context();
+    auto decomp = partition_load_balance(recipe, context);
+    simulation sim(recipe, decomp, context);
+
+    std::vector<spike> spikes;
+    sim.set_global_spike_callback(
+        [&spikes](const std::vector<spike>& s) {
+            spikes.insert(spikes.end(), s.begin(), s.end());
+        });
+    sim.run(100, 0.025);
+
+    // Each spike of a cell makes the next cell in the chain spike, a
+    // little more than the connection delay later.
+    std::vector<std::vector<time_type>> times(n+1);
+    for (auto& s: spikes) {
+        times[s.source.gid].push_back(s.time);
+    }
+    for (auto& t: times) {
+        std::sort(t.begin(), t.end());
+    }
+
+    ASSERT_EQ(5u, times[0].size());
+    for (cell_gid_type gid = 1; gid<=n; ++gid) {
+        ASSERT_EQ(times[0].size(), times[gid].size()) << "gid " << gid;
+        for (unsigned i = 0; i<times[gid].size(); ++i) {
+            auto latency = times[gid][i]-times[gid-1][i];
+            EXPECT_LT(2.f, latency);
+            EXPECT_GT(4.f, latency);
+        }
+    }
+}
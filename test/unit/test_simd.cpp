@@ -490,6 +490,27 @@ TYPED_TEST_P(simd_value, mask_unpack) {
     }
 }
 
+TYPED_TEST_P(simd_value, mask_pack) {
+    using simd = TypeParam;
+    using mask = typename simd::simd_mask;
+    constexpr unsigned N = simd::width;
+
+    std::minstd_rand rng(1036);
+
+    for (unsigned i = 0; i<nrounds; ++i) {
+        bool b[N];
+        unsigned long long packed = 0;
+        for (unsigned j = 0; j<N; ++j) {
+            b[j] = rng()&1;
+            packed |= (unsigned long long)b[j]<<j;
+        }
+
+        EXPECT_EQ(packed, mask(b).pack());
+        EXPECT_EQ(packed, mask::unpack(packed).pack());
+    }
+    EXPECT_EQ(0u, mask(false).pack());
+}
+
 TYPED_TEST_P(simd_value, maths) {
     // min, max, abs tests valid for both fp and int types.
 
@@ -565,7 +586,7 @@ TYPED_TEST_P(simd_value, simd_array_cast) {
     }
 }
 
-REGISTER_TYPED_TEST_CASE_P(simd_value, elements, element_lvalue, copy_to_from, copy_to_from_masked, construct_masked, arithmetic, compound_assignment, comparison, mask_elements, mask_element_lvalue, mask_copy_to_from, mask_unpack, maths, simd_array_cast, reductions);
+REGISTER_TYPED_TEST_CASE_P(simd_value, elements, element_lvalue, copy_to_from, copy_to_from_masked, construct_masked, arithmetic, compound_assignment, comparison, mask_elements, mask_element_lvalue, mask_copy_to_from, mask_unpack, mask_pack, maths, simd_array_cast, reductions);
 
 typedef ::testing::Types<
 
@@ -0,0 +1,95 @@
+#include "../gtest.h"
+
+#include <vector>
+
+#include <arbor/spike.hpp>
+
+#include "communication/gathered_vector.hpp"
+#include "communication/spike_codec.hpp"
+#include "util/span.hpp"
+
+using namespace arb;
+
+TEST(spike_codec, empty) {
+    std::vector<spike> spikes;
+    auto encoded = encode_spikes(spikes);
+    EXPECT_TRUE(encoded.empty());
+    EXPECT_TRUE(decode_spikes(encoded).empty());
+}
+
+TEST(spike_codec, round_trip) {
+    // Sorted by source, with gids and indices that need multi-byte varints.
+    std::vector<spike> spikes = {
+        {{0u, 0u}, 10.125},
+        {{0u, 1u}, 10.},
+        {{5u, 0u}, 11.5},
+        {{300u, 200u}, 10.75},
+        {{100000u, 0u}, 12.},
+        {{4000000000u, 70000u}, 10.25},
+    };
+
+    auto decoded = decode_spikes(encode_spikes(spikes));
+    EXPECT_EQ(spikes, decoded);
+}
+
+TEST(spike_codec, unsorted) {
+    std::vector<spike> spikes = {
+        {{7u, 1u}, 3.},
+        {{2u, 0u}, 2.},
+        {{9u, 0u}, 4.},
+        {{0u, 5u}, 2.5},
+    };
+
+    auto decoded = decode_spikes(encode_spikes(spikes));
+    EXPECT_EQ(spikes, decoded);
+}
+
+TEST(spike_codec, times) {
+    // Times are not rounded.
+    std::vector<spike> spikes;
+    for (auto i: util::make_span(100)) {
+        spikes.push_back({{cell_gid_type(i), 0u}, time_type(1000.1+0.0123*i)});
+    }
+    spikes.push_back({{200u, 0u}, -1});
+    spikes.push_back({{201u, 0u}, 1e-30f});
+
+    auto decoded = decode_spikes(encode_spikes(spikes));
+    EXPECT_EQ(spikes, decoded);
+}
+
+TEST(spike_codec, compression) {
+    // Sorted sources with small gid deltas: at least 2x smaller than raw spikes,
+    // also when some source indices are non-zero.
+    std::vector<spike> spikes;
+    for (auto i: util::make_span(1000)) {
+        spikes.push_back({{cell_gid_type(3*i), cell_lid_type(i%10==0)}, time_type(0.025*(i%40))});
+    }
+
+    auto encoded = encode_spikes(spikes);
+    EXPECT_LE(2*encoded.size(), spikes.size()*sizeof(spike));
+    EXPECT_EQ(spikes, decode_spikes(encoded));
+}
+
+TEST(spike_codec, gathered) {
+    using count_type = gathered_vector<char>::count_type;
+
+    std::vector<std::vector<spike>> domains = {
+        {{{0u, 0u}, 1.}, {{1u, 0u}, 1.5}},
+        {},
+        {{{10u, 2u}, 3.}},
+    };
+
+    std::vector<char> bytes;
+    std::vector<count_type> byte_part = {0};
+    std::vector<spike> expected;
+    for (auto& d: domains) {
+        auto encoded = encode_spikes(d);
+        bytes.insert(bytes.end(), encoded.begin(), encoded.end());
+        byte_part.push_back(bytes.size());
+        expected.insert(expected.end(), d.begin(), d.end());
+    }
+
+    auto decoded = decode_spikes(gathered_vector<char>(std::move(bytes), std::move(byte_part)));
+    EXPECT_EQ(expected, decoded.values());
+    EXPECT_EQ((std::vector<count_type>{0, 2, 2, 3}), decoded.partition());
+}
@@ -0,0 +1,253 @@
+#include "../gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/domain_decomposition.hpp>
+#include <arbor/lif_cell.hpp>
+#include <arbor/load_balance.hpp>
+#include <arbor/recipe.hpp>
+#include <arbor/schedule.hpp>
+#include <arbor/simulation.hpp>
+#include <arbor/spike.hpp>
+#include <arbor/spike_file.hpp>
+#include <arbor/spike_source_cell.hpp>
+
+#include "spike_export_queue.hpp"
+
+#include "common.hpp"
+
+using namespace arb;
+
+namespace {
+    // Regularly spiking sources, all connected with zero weight to a LIF
+    // cell, which sets the minimum delay.
+    class sources_recipe: public recipe {
+    public:
+        sources_recipe(cell_size_type n_sources): n_sources_(n_sources) {}
+
+        cell_size_type num_cells() const override {
+            return n_sources_+1;
+        }
+
+        cell_kind get_cell_kind(cell_gid_type gid) const override {
+            return gid<n_sources_? cell_kind::spike_source: cell_kind::lif;
+        }
+
+        util::unique_any get_cell_description(cell_gid_type gid) const override {
+            if (gid<n_sources_) {
+                return spike_source_cell{regular_schedule(0.5)};
+            }
+            return lif_cell();
+        }
+
+        cell_size_type num_sources(cell_gid_type) const override {
+            return 1;
+        }
+
+        cell_size_type num_targets(cell_gid_type gid) const override {
+            return gid<n_sources_? 0: 1;
+        }
+
+        std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+            std::vector<cell_connection> conns;
+            if (gid==n_sources_) {
+                for (cell_gid_type src = 0; src<n_sources_; ++src) {
+                    conns.push_back(cell_connection({src, 0}, {gid, 0}, 0.f, 1.f));
+                }
+            }
+            return conns;
+        }
+
+    private:
+        cell_size_type n_sources_;
+    };
+}
+
+TEST(spike_export_queue, back_pressure) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    std::vector<std::size_t> sizes;
+
+    spike_export_function f = [&](const std::vector<spike>& spikes) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return release; });
+        sizes.push_back(spikes.size());
+    };
+
+    spike_export_queue queue(3);
+    queue.push(f, std::vector<spike>(2));
+    queue.push(f, std::vector<spike>(1));
+
+    // The queue is full: a further push waits until the exports progress.
+    auto blocked = std::async(std::launch::async, [&] { queue.push(f, std::vector<spike>(1)); });
+    EXPECT_EQ(std::future_status::timeout, blocked.wait_for(std::chrono::milliseconds(50)));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+    blocked.get();
+    queue.flush();
+    EXPECT_EQ((std::vector<std::size_t>{2, 1, 1}), sizes);
+
+    // An empty queue takes any number of spikes.
+    queue.push(f, std::vector<spike>(10));
+    queue.flush();
+    EXPECT_EQ(10u, sizes.back());
+}
+
+TEST(spike_export_queue, stateful_callback) {
+    struct counter {
+        std::size_t n = 0;
+        void operator()(const std::vector<spike>& spikes) { n += spikes.size(); }
+    };
+
+    spike_export_function f = counter{};
+    spike_export_queue queue(100);
+    for (std::size_t i = 0; i<5; ++i) {
+        queue.push(f, std::vector<spike>(i));
+    }
+    queue.flush();
+    EXPECT_EQ(10u, f.target<counter>()->n);
+}
+
+TEST(spike_export_queue, errors) {
+    spike_export_function f = [](const std::vector<spike>& spikes) {
+        if (spikes.size()==1) throw std::runtime_error("export failure");
+    };
+
+    spike_export_queue queue(100);
+    queue.push(f, std::vector<spike>(1));
+    EXPECT_THROW(queue.flush(), std::runtime_error);
+
+    // The error is raised once.
+    queue.push(f, std::vector<spike>(2));
+    queue.flush();
+}
+
+// Spikes exported asynchronously, with a slow callback and a small buffer,
+// must match those exported synchronously.
+TEST(spike_export, simulation) {
+    cell_size_type n_sources = 20;
+    time_type simulation_time = 20;
+
+    auto context = make_context(proc_allocation(2, -1));
+    auto recipe = sources_recipe(n_sources);
+    auto decomp = partition_load_balance(recipe, context);
+
+    auto by_source = [](const spike& a, const spike& b) { return a.source<b.source || (a.source==b.source && a.time<b.time); };
+
+    std::vector<spike> expected;
+    {
+        simulation sim(recipe, decomp, context);
+        sim.set_global_spike_callback(
+            [&expected](const std::vector<spike>& spikes) {
+                expected.insert(expected.end(), spikes.begin(), spikes.end());
+            });
+        sim.run(simulation_time, 0.01);
+        std::sort(expected.begin(), expected.end(), by_source);
+    }
+    ASSERT_EQ(40u*n_sources, expected.size());
+
+    testing::scoped_temp_path tmp;
+    std::vector<spike> exported;
+    std::vector<std::size_t> counts;
+    {
+        simulation sim(recipe, decomp, context);
+        sim.set_async_spike_export(2);
+        sim.set_global_spike_callback(
+            [&exported](const std::vector<spike>& spikes) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                exported.insert(exported.end(), spikes.begin(), spikes.end());
+            });
+
+        // The state of the callbacks is kept from one export to the next.
+        sim.set_local_spike_callback(
+            [n = std::size_t(0), &counts, writer = spike_file_writer(tmp.path)](const std::vector<spike>& spikes) mutable {
+                n += spikes.size();
+                counts.push_back(n);
+                writer(spikes);
+            });
+
+        // All exports have completed when run returns.
+        sim.run(simulation_time/2, 0.01);
+        auto n_half = exported.size();
+        EXPECT_LT(0u, n_half);
+        EXPECT_EQ(n_half, sim.num_spikes());
+
+        sim.run(simulation_time, 0.01);
+    }
+
+    std::sort(exported.begin(), exported.end(), by_source);
+    EXPECT_EQ(expected, exported);
+
+    ASSERT_LT(1u, counts.size());
+    EXPECT_EQ(expected.size(), counts.back());
+
+    auto from_file = read_spike_file(tmp.path);
+    std::sort(from_file.begin(), from_file.end(), by_source);
+    EXPECT_EQ(expected, from_file);
+
+    // Exceptions thrown by the callbacks are raised by run.
+    {
+        simulation sim(recipe, decomp, context);
+        sim.set_async_spike_export(2);
+        sim.set_global_spike_callback(
+            [](const std::vector<spike>& spikes) {
+                if (!spikes.empty()) throw std::runtime_error("export failure");
+            });
+        EXPECT_THROW(sim.run(simulation_time, 0.01), std::runtime_error);
+    }
+}
+
+TEST(spike_file, write_read) {
+    testing::scoped_temp_path tmp;
+    std::vector<spike> spikes = {{{1, 0}, 0.5f}, {{3, 2}, 1.25f}, {{0, 1}, 2.0f}};
+
+    {
+        // Copies of a writer append to the same file.
+        spike_file_writer writer(tmp.path);
+        auto copy = writer;
+        writer({spikes[0]});
+        copy({spikes[1], spikes[2]});
+        writer(std::vector<spike>{});
+
+        writer.flush();
+        EXPECT_EQ(spikes, read_spike_file(tmp.path));
+    }
+    EXPECT_EQ(spikes, read_spike_file(tmp.path));
+
+    // A new writer truncates the file.
+    spike_file_writer{tmp.path};
+    EXPECT_TRUE(read_spike_file(tmp.path).empty());
+}
+
+TEST(spike_file, errors) {
+    testing::scoped_temp_path tmp;
+
+    EXPECT_THROW(read_spike_file(tmp.path+".missing"), spike_file_error);
+    EXPECT_THROW(spike_file_writer(tmp.path+".missing/spikes"), spike_file_error);
+
+    std::ofstream(tmp.path) << "not a spike file";
+    EXPECT_THROW(read_spike_file(tmp.path), spike_file_error);
+
+    // A file cut short in the middle of a spike record.
+    spike_file_writer{tmp.path}({{{1, 0}, 0.5f}, {{2, 0}, 1.5f}});
+    std::ifstream in(tmp.path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ASSERT_LT(4u, contents.size());
+    std::ofstream(tmp.path, std::ios::binary|std::ios::trunc) << contents.substr(0, contents.size()-4);
+    EXPECT_THROW(read_spike_file(tmp.path), spike_file_error);
+}
@@ -155,3 +155,55 @@ TEST(SPIKES_TEST_CLASS, threshold_watcher) {
     EXPECT_FALSE(watch.is_crossed(2));
 }
 
+
+TEST(SPIKES_TEST_CLASS, threshold_watcher_many) {
+    using value_type = backend::value_type;
+    using index_type = backend::index_type;
+    using array = backend::array;
+    using iarray = backend::iarray;
+
+    // Watch every other value of 2n, all in one cell, with threshold 1.
+    // At step j, the values of watches j, j+3, j+6, ... rise to 2 and the
+    // others fall to 0.
+    execution_context context;
+    const unsigned n = 19;
+
+    std::vector<index_type> index;
+    for (unsigned i = 0; i<n; ++i) {
+        index.push_back(2*i+1);
+    }
+    const std::vector<value_type> thresh(n, 1.);
+
+    array values(2*n, 0.);
+    iarray cell_index(2*n, 0);
+    array time_before(1, 0.);
+    array time_after(1, 0.);
+
+    backend::threshold_watcher watch(cell_index.data(), time_before.data(), time_after.data(), values.data(), index, thresh, context);
+
+    std::vector<threshold_crossing> expected;
+    for (unsigned j = 0; j<3; ++j) {
+        memory::fill(time_before, value_type(j));
+        memory::fill(time_after, value_type(j+1));
+
+        std::vector<value_type> v(2*n, 0.);
+        for (unsigned i = j; i<n; i += 3) {
+            v[index[i]] = 2.;
+            expected.push_back({i, j+0.5f});
+        }
+        memory::copy(v, values);
+        watch.test();
+
+        for (unsigned i = 0; i<n; ++i) {
+            EXPECT_EQ(i%3==j, watch.is_crossed(i));
+        }
+    }
+
+    // Crossings within a step need not be ordered by watch.
+    auto crossings = watch.crossings();
+    util::sort_by(crossings, [](const threshold_crossing& c) { return std::make_pair(c.time, c.index); });
+    ASSERT_EQ(expected.size(), crossings.size());
+    for (unsigned i = 0; i<expected.size(); ++i) {
+        EXPECT_EQ(expected[i], crossings[i]);
+    }
+}
@@ -1,8 +1,15 @@
 #include "../gtest.h"
 #include "common.hpp"
 
+#include <array>
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <ostream>
+#include <thread>
+#include <vector>
 // (Pending abstraction of threading interface)
 #include <arbor/version.hpp>
 
@@ -68,8 +75,8 @@ TEST(task_system, test_copy) {
     ftor f;
     ts.async(f);
 
-    // Copy into new ftor and move ftor into a task (std::function<void()>)
-    EXPECT_EQ(1, nmove);
+    // Copy directly into the task's storage.
+    EXPECT_EQ(0, nmove);
     EXPECT_EQ(1, ncopy);
     reset();
 }
@@ -80,34 +87,99 @@ TEST(task_system, test_move) {
     ftor f;
     ts.async(std::move(f));
 
-    // Move into new ftor and move ftor into a task (std::function<void()>)
-    EXPECT_LE(nmove, 2);
-    EXPECT_LE(ncopy, 1);
+    // Move directly into the task's storage.
+    EXPECT_LE(nmove, 1);
+    EXPECT_EQ(0, ncopy);
     reset();
 }
 
-TEST(notification_queue, test_copy) {
-    notification_queue q;
+TEST(task, small_buffer) {
+    int n = 0;
+    task t([&n] { ++n; });
+    ASSERT_TRUE(t);
+    t();
+    EXPECT_EQ(1, n);
 
-    ftor f;
-    q.push(f);
+    task u(std::move(t));
+    EXPECT_FALSE(t);
+    u();
+    EXPECT_EQ(2, n);
 
-    // Copy into new ftor and move ftor into a task (std::function<void()>)
-    EXPECT_EQ(1, nmove);
-    EXPECT_EQ(1, ncopy);
-    reset();
+    u.reset();
+    EXPECT_FALSE(u);
 }
 
-TEST(notification_queue, test_move) {
-    notification_queue q;
+TEST(task, large_callable) {
+    // Callables larger than the inline buffer are stored on the heap.
+    std::array<char, 2*task::buffer_size> big;
+    big.fill(1);
 
-    ftor f;
+    int n = 0;
+    task t([big, &n] { n += big.back(); });
+    task u(std::move(t));
+    u();
+    EXPECT_EQ(1, n);
+}
 
-    // Move into new ftor and move ftor into a task (std::function<void()>)
-    q.push(std::move(f));
-    EXPECT_LE(nmove, 2);
-    EXPECT_LE(ncopy, 1);
-    reset();
+TEST(task_deque, push_pop_steal) {
+    task_deque q(2);
+    std::vector<task> tasks(10);
+
+    EXPECT_TRUE(q.empty());
+    EXPECT_FALSE(q.pop());
+    EXPECT_FALSE(q.steal());
+
+    // Owner pops in LIFO order, thieves steal in FIFO order; the deque
+    // grows past its initial capacity as required.
+    for (auto& t: tasks) q.push(&t);
+    EXPECT_FALSE(q.empty());
+
+    EXPECT_EQ(&tasks[9], q.pop());
+    EXPECT_EQ(&tasks[0], q.steal());
+    EXPECT_EQ(&tasks[8], q.pop());
+    EXPECT_EQ(&tasks[1], q.steal());
+
+    for (unsigned i = 2; i<8; ++i) {
+        EXPECT_EQ(&tasks[i], q.steal());
+    }
+    EXPECT_TRUE(q.empty());
+    EXPECT_FALSE(q.pop());
+}
+
+TEST(task_deque, concurrent_steal) {
+    // Every pushed task is taken exactly once by either the owner or a thief.
+    const unsigned n = 100000;
+    const unsigned nthieves = 3;
+    task_deque q;
+    std::vector<task> tasks(n);
+    std::vector<std::atomic<int>> taken(n);
+    for (auto& t: taken) t = 0;
+
+    std::atomic<bool> done{false};
+    auto take = [&](task* t) { ++taken[t-tasks.data()]; };
+
+    std::vector<std::thread> thieves;
+    for (unsigned i = 0; i<nthieves; ++i) {
+        thieves.emplace_back([&] {
+            while (!done) {
+                if (auto t = q.steal()) take(t);
+            }
+        });
+    }
+
+    for (unsigned i = 0; i<n; ++i) {
+        q.push(&tasks[i]);
+        if (i%3==0) {
+            if (auto t = q.pop()) take(t);
+        }
+    }
+    while (auto t = q.pop()) take(t);
+    done = true;
+    for (auto& t: thieves) t.join();
+
+    for (auto& t: taken) {
+        EXPECT_EQ(1, t);
+    }
 }
 
 TEST(task_group, test_copy) {
@@ -194,6 +266,85 @@ TEST(task_group, nested_parallel_for) {
     }
 }
 
+TEST(task_group, partitioned_parallel_for) {
+    for (int nthreads: {1, 2, 5}) {
+        task_system ts(nthreads);
+        for (auto kind: {partition_kind::static_blocks, partition_kind::dynamic, partition_kind::guided}) {
+            for (int grain: {1, 3, 64, 20000}) {
+                for (int n = 0; n < 10000; n=!n?1:3*n) {
+                    // Every index in [left, right) is visited exactly once.
+                    const int left = 7, right = left+n;
+                    std::vector<std::atomic<int>> v(n);
+                    for (auto& x: v) x = 0;
+
+                    parallel_for::apply(left, right, &ts, partitioner(kind, grain), [&](int i) { ++v[i-left]; });
+                    for (int i = 0; i < n; ++i) {
+                        EXPECT_EQ(1, v[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(task_group, partitioned_parallel_for_blocks) {
+    task_system ts(4);
+
+    // Static blocks have no fewer than grain_size indices: 10 indices with
+    // grain 4 make two blocks of 5, rather than three of fewer than 4. The
+    // indices of a block are visited in order by one thread.
+    std::mutex m;
+    std::map<std::thread::id, std::vector<int>> visited;
+    parallel_for::apply(0, 10, &ts, partitioner(partition_kind::static_blocks, 4), [&](int i) {
+        std::lock_guard<std::mutex> lock(m);
+        visited[std::this_thread::get_id()].push_back(i);
+    });
+
+    for (auto& t: visited) {
+        auto& idx = t.second;
+        std::size_t run = 1;
+        for (std::size_t k = 1; k<=idx.size(); ++k) {
+            if (k<idx.size() && idx[k]==idx[k-1]+1) {
+                ++run;
+            }
+            else {
+                EXPECT_LE(4u, run);
+                run = 1;
+            }
+        }
+    }
+}
+
+TEST(task_group, partitioned_parallel_for_int_max) {
+    // Claiming chunks near INT_MAX does not overflow the shared counter.
+    task_system ts(4);
+    for (auto kind: {partition_kind::static_blocks, partition_kind::dynamic, partition_kind::guided}) {
+        const int right = std::numeric_limits<int>::max();
+        const int left = right-1000;
+        std::vector<std::atomic<int>> v(right-left);
+        for (auto& x: v) x = 0;
+
+        parallel_for::apply(left, right, &ts, partitioner(kind, 64), [&](int i) { ++v[i-left]; });
+        for (auto& x: v) {
+            EXPECT_EQ(1, x);
+        }
+    }
+}
+
+TEST(task_group, nested_partitioned_parallel_for) {
+    task_system ts(4);
+    const int m = 100, n = 1000;
+    std::vector<std::vector<int>> v(m, std::vector<int>(n, -1));
+    parallel_for::apply(0, m, &ts, partitioner(partition_kind::dynamic, 1), [&](int i) {
+        parallel_for::apply(0, n, &ts, partitioner(partition_kind::guided, 8), [&](int j) { v[i][j] = i + j; });
+    });
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            EXPECT_EQ(i + j, v[i][j]);
+        }
+    }
+}
+
 TEST(enumerable_thread_specific, test) {
     task_system_handle ts = task_system_handle(new task_system);
     enumerable_thread_specific<int> buffers(ts);
@@ -0,0 +1,96 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../gtest.h"
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/sampling.hpp>
+#include <arbor/trace_file.hpp>
+#include <arbor/util/any_ptr.hpp>
+
+#include "common.hpp"
+
+using namespace arb;
+
+TEST(trace_file, write_read) {
+    testing::scoped_temp_path tmp;
+    std::vector<cell_member_type> probes = {{3, 0}, {1, 2}};
+
+    {
+        trace_writer writer(tmp.path, probes, 6);
+        auto bulk = writer.bulk_sampler();
+        auto sampler = writer.sampler();
+
+        // Both probes in one block, then each probe separately.
+        cell_member_type ids[] = {{1, 2}, {3, 0}};
+        probe_tag tags[] = {20, 10};
+        double time[] = {0.0, 0.5, 0.0, 0.5};
+        double value[] = {1.0, 2.0, 3.0, 4.0};
+        bulk({2, 2, ids, tags, time, value});
+
+        const double v[] = {5.0, 6.0};
+        sample_record recs[] = {{1.0f, &v[0]}, {1.5f, &v[1]}};
+        sampler({3, 0}, 10, 2, recs);
+
+        // Reading while the writer is open sees the flushed samples.
+        writer.flush();
+        trace_reader reader(tmp.path);
+        EXPECT_EQ(4u, reader.num_samples(0));
+        EXPECT_EQ(2u, reader.num_samples(1));
+
+        double t = 2.0, x = 7.0;
+        bulk({1, 1, &ids[0], &tags[0], &t, &x});
+    }
+
+    trace_reader reader(tmp.path);
+    ASSERT_EQ(2u, reader.num_probes());
+    EXPECT_EQ(6u, reader.capacity());
+
+    EXPECT_EQ(cell_member_type({3, 0}), reader.probe_id(0));
+    EXPECT_EQ(10, reader.tag(0));
+    ASSERT_EQ(4u, reader.num_samples(0));
+    EXPECT_EQ((std::vector<double>{0.0, 0.5, 1.0, 1.5}), std::vector<double>(reader.times(0), reader.times(0)+4));
+    EXPECT_EQ((std::vector<double>{3.0, 4.0, 5.0, 6.0}), std::vector<double>(reader.values(0), reader.values(0)+4));
+
+    EXPECT_EQ(cell_member_type({1, 2}), reader.probe_id(1));
+    EXPECT_EQ(20, reader.tag(1));
+    ASSERT_EQ(3u, reader.num_samples(1));
+    EXPECT_EQ((std::vector<double>{0.0, 0.5, 2.0}), std::vector<double>(reader.times(1), reader.times(1)+3));
+    EXPECT_EQ((std::vector<double>{1.0, 2.0, 7.0}), std::vector<double>(reader.values(1), reader.values(1)+3));
+}
+
+TEST(trace_file, errors) {
+    testing::scoped_temp_path tmp;
+    trace_writer writer(tmp.path, {{0, 0}}, 2);
+    auto bulk = writer.bulk_sampler();
+
+    cell_member_type id = {0, 0}, other = {0, 1};
+    probe_tag tag = 0;
+    double time[] = {0.0, 1.0, 2.0};
+    double value[] = {0.0, 1.0, 2.0};
+
+    EXPECT_THROW(bulk({1, 1, &other, &tag, time, value}), bad_probe_id);
+    EXPECT_THROW(bulk({1, 3, &id, &tag, time, value}), trace_file_error);
+    bulk({1, 2, &id, &tag, time, value});
+    EXPECT_THROW(bulk({1, 1, &id, &tag, time, value}), trace_file_error);
+
+    writer.close();
+    EXPECT_THROW(bulk({1, 0, &id, &tag, time, value}), trace_file_error);
+
+    // Samplers may outlive their writer.
+    sampler_function sampler;
+    {
+        trace_writer other_writer(tmp.path, {{0, 0}}, 2);
+        bulk = other_writer.bulk_sampler();
+        sampler = other_writer.sampler();
+    }
+    const double v = 1.0;
+    sample_record rec = {0.0f, &v};
+    EXPECT_THROW(bulk({1, 1, &id, &tag, time, value}), trace_file_error);
+    EXPECT_THROW(sampler(id, tag, 1, &rec), trace_file_error);
+
+    testing::scoped_temp_path bad;
+    std::ofstream(bad.path) << "not a trace file, but long enough for a header";
+    EXPECT_THROW(trace_reader{bad.path}, trace_file_error);
+}